@@ -0,0 +1,230 @@
+// Minimal benchmark runner in the manner of Google Benchmark: every case
+// is timed over enough iterations to fill --min_time seconds, reported
+// as a console table and, with --json=FILE, in Google Benchmark's JSON
+// layout so results can be diffed between commits.
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "qbestd/scratch.hpp"
+#include "qbestd/simd.hpp"
+
+namespace bench {
+
+struct Options {
+    double min_time = 0.2;         // seconds per case
+    std::string filter = ".*";     // regex on case names
+    std::string json;              // output file, empty for none
+    double max_bytes = 1 << 30;    // cases allocating more up front are skipped
+    bool list = false;             // print the names only
+};
+
+inline Options parse(int argc, char** argv)
+{
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        std::string v;
+        // True for --key=VALUE, which leaves VALUE (possibly empty) in v
+        auto value = [&](const char* key) {
+            const std::string prefix = std::string("--") + key + "=";
+            if (arg.compare(0, prefix.size(), prefix) != 0)
+                return false;
+            v = arg.substr(prefix.size());
+            return true;
+        };
+        if (value("min_time") && !v.empty())
+            opt.min_time = std::stod(v);
+        else if (value("filter"))
+            opt.filter = v.empty() ? ".*" : v;
+        else if (value("json"))
+            opt.json = v;
+        else if (value("max_bytes") && !v.empty())
+            opt.max_bytes = std::stod(v);
+        else if (arg == "--list")
+            opt.list = true;
+        else {
+            std::fprintf(stderr,
+                         "usage: %s [--filter=REGEX] [--min_time=SECONDS] [--json=FILE] [--max_bytes=N] [--list]\n",
+                         argv[0]);
+            std::exit(2);
+        }
+    }
+    return opt;
+}
+
+// One benchmark: setup() allocates the inputs and output buffers (bytes
+// of them) and returns the timed body, which computes `cells` DP cells
+// per call.
+struct Case {
+    std::string name;
+    double cells = 0;
+    double bytes = 0;
+    std::function<std::function<void()>()> setup;
+};
+
+struct Result {
+    std::string name;
+    std::size_t iterations = 0;
+    double seconds = 0;         // per iteration
+    double cells_per_second = 0;
+    double bytes_per_cell = 0;  // case buffers plus scratch memory, per cell
+    long peak_rss = 0;          // high-water mark of the process that ran the case, bytes
+};
+
+// Times the case in the calling process; peak_rss is left 0.
+inline Result measure(const Case& c, double min_time)
+{
+    using clock = std::chrono::steady_clock;
+    Result r;
+    r.name = c.name;
+    const std::function<void()> body = c.setup();
+
+    // The first call warms the scratch pool; what it holds is the call's
+    // working memory
+    qbestd::release_scratch();
+    const std::size_t held = qbestd::scratch_stats().held;
+    body();
+    const double scratch = double(qbestd::scratch_stats().held - held);
+
+    const clock::time_point start = clock::now();
+    double elapsed = 0;
+    do {
+        body();
+        ++r.iterations;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    } while (elapsed < min_time);
+    r.seconds = elapsed / double(r.iterations);
+    r.cells_per_second = c.cells / r.seconds;
+    r.bytes_per_cell = (c.bytes + scratch) / c.cells;
+    return r;
+}
+
+// Runs the case in a forked child, so that its ru_maxrss covers this case
+// and the runner it was forked from, not every case before it. Returns
+// false when the child does not report back.
+inline bool run(const Case& c, double min_time, Result& r)
+{
+    // Timings of the child, sent back through a pipe
+    struct Timing {
+        std::size_t iterations;
+        double seconds, cells_per_second, bytes_per_cell;
+    };
+    int fd[2];
+    if (pipe(fd) != 0)
+        return false;
+    std::fflush(nullptr);
+    const pid_t pid = fork();
+    if (pid < 0) {
+        close(fd[0]);
+        close(fd[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fd[0]);
+        const Result m = measure(c, min_time);
+        const Timing t{m.iterations, m.seconds, m.cells_per_second, m.bytes_per_cell};
+        const bool sent = write(fd[1], &t, sizeof t) == ssize_t(sizeof t);
+        _exit(sent ? 0 : 1);
+    }
+    close(fd[1]);
+    Timing t{};
+    const bool received = read(fd[0], &t, sizeof t) == ssize_t(sizeof t);
+    close(fd[0]);
+    int status = 0;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid || !received || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        return false;
+    r.name = c.name;
+    r.iterations = t.iterations;
+    r.seconds = t.seconds;
+    r.cells_per_second = t.cells_per_second;
+    r.bytes_per_cell = t.bytes_per_cell;
+    r.peak_rss = usage.ru_maxrss * 1024L;
+    return true;
+}
+
+inline void write_json(const std::string& path, const char* executable, const std::vector<Result>& results)
+{
+    std::FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        std::fprintf(stderr, "cannot write %s\n", path.c_str());
+        return;
+    }
+    char date[64], host[256] = "";
+    const std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+    gethostname(host, sizeof host - 1);
+    std::fprintf(f, "{\n  \"context\": {\n");
+    std::fprintf(f, "    \"date\": \"%s\",\n    \"host_name\": \"%s\",\n    \"executable\": \"%s\",\n", date, host,
+                 executable);
+    std::fprintf(f, "    \"num_cpus\": %u,\n    \"isa\": \"%s\",\n", std::thread::hardware_concurrency(),
+                 qbestd::isa_name(qbestd::active_isa()));
+#ifdef NDEBUG
+    std::fprintf(f, "    \"library_build_type\": \"release\"\n  },\n");
+#else
+    std::fprintf(f, "    \"library_build_type\": \"debug\"\n  },\n");
+#endif
+    std::fprintf(f, "  \"benchmarks\": [\n");
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(f,
+                     "    {\"name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %zu, "
+                     "\"real_time\": %.6g, \"time_unit\": \"ms\", \"cells_per_second\": %.6g, "
+                     "\"bytes_per_cell\": %.6g, \"peak_rss_bytes\": %ld}%s\n",
+                     r.name.c_str(), r.iterations, r.seconds * 1e3, r.cells_per_second, r.bytes_per_cell,
+                     r.peak_rss, i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+}
+
+// Runs the cases matching the options; returns the process exit code.
+inline int main(int argc, char** argv, const std::vector<Case>& cases)
+{
+    const Options opt = parse(argc, argv);
+    const std::regex filter(opt.filter);
+    std::vector<Result> results;
+    if (!opt.list)
+        std::printf("%-48s %10s %8s %12s %10s %10s\n", "Benchmark", "Time(ms)", "Iter", "Cells/s", "Bytes/cell",
+                    "PeakRSS(MB)");
+    for (const Case& c : cases) {
+        if (!std::regex_search(c.name, filter))
+            continue;
+        if (opt.list) {
+            std::printf("%s\n", c.name.c_str());
+            continue;
+        }
+        if (c.bytes > opt.max_bytes) {
+            std::printf("%-48s skipped: %.0f MB of buffers exceeds --max_bytes\n", c.name.c_str(), c.bytes / 1e6);
+            continue;
+        }
+        Result r;
+        if (!run(c, opt.min_time, r)) {
+            std::printf("%-48s failed\n", c.name.c_str());
+            continue;
+        }
+        std::printf("%-48s %10.3f %8zu %12.4g %10.3f %10.1f\n", r.name.c_str(), r.seconds * 1e3, r.iterations,
+                    r.cells_per_second, r.bytes_per_cell, double(r.peak_rss) / 1e6);
+        std::fflush(stdout);
+        results.push_back(r);
+    }
+    if (!opt.json.empty())
+        write_json(opt.json, argv[0], results);
+    return 0;
+}
+
+} // namespace bench
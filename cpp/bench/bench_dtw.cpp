@@ -0,0 +1,144 @@
+// Throughput of the recurrences behind every MEX kernel, over query
+// lengths N and reference lengths M. Options: see bench.hpp.
+//
+// Modes:
+//   full      dtw() on a precomputed D, writing S, T and P (the *_c_skel outputs)
+//   rolling   dtw_rolling() on a precomputed D, best hit only
+//   features  dtw_features() on 39-dimensional frames, D never materialised
+//   stream    StreamSearch pushing the reference in chunks (online kernels)
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bench.hpp"
+#include "qbestd/qbestd.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+constexpr index_t dims = 39;
+constexpr index_t chunk = 4096;
+
+const index_t query_lengths[] = {50, 100, 300};
+const index_t reference_lengths[] = {1000, 10000, 100000, 1000000};
+
+using Buffer = std::shared_ptr<std::vector<double>>;
+
+Buffer uniform(index_t n, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> u(0.05, 1.0);
+    Buffer x = std::make_shared<std::vector<double>>(static_cast<std::size_t>(n));
+    for (double& v : *x)
+        v = u(gen);
+    return x;
+}
+
+std::string name(const char* kernel, const char* mode, index_t N, index_t M)
+{
+    return std::string(kernel) + "/" + mode + "/N:" + std::to_string(N) + "/M:" + std::to_string(M);
+}
+
+// Results land here so the optimiser cannot drop the work.
+volatile double sink;
+
+template <class Pattern, class Norm>
+bench::Case rolling(const char* kernel, index_t N, index_t M)
+{
+    const double cells = double(M) * double(N);
+    return {name(kernel, "rolling", N, M), cells, cells * sizeof(double), [M, N] {
+                const Buffer D = uniform(M * N, 1);
+                return std::function<void()>([D, M, N] {
+                    sink = dtw_rolling<Pattern, Norm>(column_major<const double>(D->data(), M, N)).dist;
+                });
+            }};
+}
+
+template <class Pattern, class Norm>
+bench::Case full(const char* kernel, index_t N, index_t M)
+{
+    const double cells = double(M) * double(N);
+    return {name(kernel, "full", N, M), cells, 4 * cells * sizeof(double), [M, N] {
+                const Buffer D = uniform(M * N, 1);
+                const Buffer STP = std::make_shared<std::vector<double>>(3 * D->size());
+                return std::function<void()>([D, STP, M, N] {
+                    double* S = STP->data();
+                    sink = dtw<Pattern, Norm>(D->data(), M, N, M, S, S + M * N, S + 2 * M * N).dist;
+                });
+            }};
+}
+
+template <class Pattern, class Norm>
+bench::Case features(const char* kernel, index_t N, index_t M)
+{
+    const double cells = double(M) * double(N);
+    return {name(kernel, "features", N, M), cells, double((M + N) * dims) * sizeof(double), [M, N] {
+                const Buffer R = uniform(M * dims, 2), Q = uniform(N * dims, 3);
+                return std::function<void()>([R, Q, M, N] {
+                    sink = dtw_features<Pattern, Norm>(column_major<const double>(R->data(), dims, M),
+                                                       column_major<const double>(Q->data(), dims, N),
+                                                       Metric::SqEuclidean)
+                               .dist;
+                });
+            }};
+}
+
+template <class Pattern, class Norm>
+bench::Case stream(const char* kernel, index_t N, index_t M)
+{
+    const double cells = double(M) * double(N);
+    return {name(kernel, "stream", N, M), cells, double((M + N) * dims) * sizeof(double), [M, N] {
+                const Buffer R = uniform(M * dims, 2), Q = uniform(N * dims, 3);
+                return std::function<void()>([R, Q, M, N] {
+                    StreamSearch<Pattern, Norm> search(column_major<const double>(Q->data(), dims, N),
+                                                       Metric::SqEuclidean, 0.0);
+                    std::vector<Hit<double>> hits;
+                    for (index_t m = 0; m < M; m += chunk)
+                        search.push(column_major<const double>(R->data() + m * dims, dims, std::min(chunk, M - m)),
+                                    hits);
+                    search.flush(hits);
+                    sink = search.last().dist;
+                });
+            }};
+}
+
+// One MEX kernel: the pattern and normalisation it runs. The *_c_skel
+// kernels return S, T and P; the online ones can stream.
+template <class Pattern, class Norm>
+void add_kernel(std::vector<bench::Case>& cases, const char* kernel, bool with_full, bool with_stream)
+{
+    for (index_t N : query_lengths)
+        for (index_t M : reference_lengths) {
+            cases.push_back(rolling<Pattern, Norm>(kernel, N, M));
+            if (with_full)
+                cases.push_back(full<Pattern, Norm>(kernel, N, M));
+            cases.push_back(features<Pattern, Norm>(kernel, N, M));
+            if constexpr (Pattern::end == End::Open)
+                if (with_stream)
+                    cases.push_back(stream<Pattern, Norm>(kernel, N, M));
+        }
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<bench::Case> cases;
+    add_kernel<OpenEndDTW, Accumulated>(cases, "DTW_c_skel_nobt", false, false);
+    add_kernel<BasicDTW, Accumulated>(cases, "DTW_c_basic_skel_nobt", false, false);
+    add_kernel<NSDTW2, Accumulated>(cases, "NSDTW_c_skel_2", true, false);
+    add_kernel<NSDTW3, Accumulated>(cases, "NSDTW_c_skel", true, false);
+    add_kernel<NSDTW4, Accumulated>(cases, "NSDTW_c_skel_4", true, false);
+    add_kernel<NSDTW5, Accumulated>(cases, "NSDTW_c_skel_5", true, false);
+    add_kernel<NSDTW3, Normalized>(cases, "NSDTW_c_skel_online", false, true);
+    add_kernel<NewNSDTW, Accumulated>(cases, "newNSDTW_c_skel", true, false);
+    add_kernel<NewNSDTW, Normalized>(cases, "newNSDTW_c_skel_online", false, true);
+    add_kernel<GTTS, Accumulated>(cases, "GTTS_DTW_c_skel", true, false);
+    add_kernel<GTTS, Normalized>(cases, "GTTS_DTW_c_skel_online", false, true);
+    add_kernel<GTTS, Normalized>(cases, "sub_DTW_c_skel_online", false, true);
+    return bench::main(argc, argv, cases);
+}
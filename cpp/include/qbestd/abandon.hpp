@@ -0,0 +1,258 @@
+/*********************************************************************
+ * Early abandoning inside the recurrence. A search keeping the best hits
+ * over many references only needs a reference whose hit beats the worst
+ * one kept so far; dtw_rolling(D, BestSoFar{c}) and dtw_features(...,
+ * BestSoFar{c}) return the hit of the plain call when its dist is below
+ * c and std::nullopt otherwise. With non-negative local distances S never
+ * decreases along a path, and a path through a cell still adds at least
+ * the smallest entry of every later column of D it lands on; steps that
+ * skip columns (NewNSDTW) land on fewer, so the tail is the cheapest
+ * chain of step widths to the last column. An end point beating c has
+ * S < c*L, L being the longest path the pattern allows (N for the NSDTW
+ * patterns, where every path has one cell per column), so cells whose S
+ * plus that tail exceeds c*L are set to +Inf. Each column only computes
+ * the rows the live cells of the previous columns reach, and the search
+ * stops once no step reaches back to a live cell. The fused form takes
+ * the column minima from the block boxes of prune.hpp and skips the
+ * dead rows of D as well.
+ *
+ * Raising a cell never lowers another one under Accumulated selection,
+ * so the best end point is untouched whenever it beats c. Normalized
+ * selection only keeps that property when every candidate has the same
+ * length, i.e. for the one-cell-per-column patterns.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "counters.hpp"
+#include "distance.hpp"
+#include "dtw.hpp"
+#include "fused.hpp"
+#include "kernels.hpp"
+#include "patterns.hpp"
+#include "prune.hpp"
+#include "rolling.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+namespace detail {
+
+// Rows [first, first+rows) of X.
+template <class Real>
+MatrixView<Real> row_range(MatrixView<Real> X, index_t first, index_t rows)
+{
+    return MatrixView<Real>{X.data + first * X.row_stride, rows, X.cols, X.row_stride, X.col_stride};
+}
+
+// rolling() with the cutoff. floor[n] is a non-negative lower bound on
+// every entry of column n of D; an empty floor means D may be negative
+// and nothing is pruned. column(n, first, last) returns column n of D
+// (entry m at [m*row_stride]) with at least rows [first, last) filled;
+// it may be called several times per column with disjoint ranges.
+template <class Pattern, class Norm, class Real, class Column>
+std::optional<Hit<Real>> rolling_cutoff(index_t M, index_t N, index_t row_stride, Isa isa, Real cutoff,
+                                        const std::vector<Real>& floor, Column&& column)
+{
+    static_assert(!Norm::by_length || one_cell_per_column<Pattern>,
+                  "the cutoff needs equal candidate lengths under Normalized selection");
+    using steps = typename Pattern::steps;
+    constexpr index_t width = std::max(steps::max_dn, Pattern::first_col) + 1;
+    constexpr Real inf = std::numeric_limits<Real>::infinity();
+    // Rows past the reach of the previous columns computed at a time
+    constexpr index_t block = 16;
+
+    const Real bound = Real(double(cutoff) * longest_path<Pattern>(M, N));
+    const Real limit = floor.empty() ? inf : bound + std::abs(bound) * Real(1e-9);
+    // tail[n]: least cost any path adds after column n, over the columns
+    // its steps land on; boundary columns are entered from the previous one
+    Scratch<Real> tail(static_cast<std::size_t>(N), Real(0));
+    if (!floor.empty())
+        for (index_t n = N - 2; n >= 0; --n) {
+            auto after = [&](index_t to) { return floor[std::size_t(to)] + tail[std::size_t(to)]; };
+            Real t = n + 1 < Pattern::first_col ? after(n + 1) : inf;
+            for_each_step(steps{}, [&](index_t, index_t dn) {
+                if (dn > 0 && n + dn < N)
+                    t = std::min(t, after(n + dn));
+            });
+            tail[std::size_t(n)] = t;
+        }
+    for (Real& t : tail)
+        if (t < inf)
+            t = widened(t);
+    const index_t rows0 = std::min(Pattern::first_row, M);
+
+    ColumnWindow<Real> window(M, width);
+    Scratch<index_t> lo(static_cast<std::size_t>(N)), hi(lo.size());  // live rows of each column
+    MatrixView<Real> S, T, P;
+    const StageTimer timer(Stage::Dp);
+    index_t computed = 0, live = -1;  // live: last column with a live cell
+    // Cells computed and skipped once `columns` columns have been reached
+    auto tally = [&](index_t columns) {
+        count_cells(computed);
+        count_pruned(M * N - computed);
+        count_abandoned(N - columns);
+    };
+    for (index_t n = 0; n < N; ++n) {
+        window.advance(n);
+        S = window.S(n);
+        T = window.T(n);
+        P = window.P(n);
+        const index_t j = S.cols - 1;
+        index_t& first = lo[std::size_t(n)];
+        index_t& last = hi[std::size_t(n)];
+        first = M;
+        last = -1;
+
+        // The slot may hold live cells of an older column (any row of a
+        // fresh one); everything outside this column's rows must read +Inf.
+        if (n > 0) {
+            index_t from = 0, to = M - 1;
+            if (n >= width) {
+                const std::size_t old = std::size_t(width == 2 ? n - 2 : n - 1);
+                from = lo[old];
+                to = hi[old];
+            }
+            for (index_t m = from; m <= to; ++m)
+                S(m, j) = inf;
+        }
+
+        // Prunes rows [from, to] of column n and extends its live range.
+        const Real rest = tail[std::size_t(n)];
+        const Real* d = nullptr;
+        auto prune = [&](index_t from, index_t to) {
+            for (index_t m = from; m <= to; ++m) {
+                if (S(m, j) + rest <= limit) {
+                    first = std::min(first, m);
+                    last = m;
+                } else {
+                    S(m, j) = inf;
+                }
+            }
+        };
+        auto Dw = [&](index_t r0, index_t rows) {
+            return MatrixView<const Real>{d + r0 * row_stride, rows, j + 1, row_stride, 0};
+        };
+
+        if (j < Pattern::first_col) {
+            computed += M;
+            d = column(n, 0, M);
+            init_column<Pattern, Norm>(j, Dw(0, M), S, T, P);
+            prune(0, M - 1);
+        } else {
+            // Rows reachable from the live rows of the previous columns
+            index_t a = M, b = -1;
+            for_each_step(steps{}, [&](index_t dm, index_t dn) {
+                if (dn > 0) {
+                    a = std::min(a, lo[std::size_t(n - dn)] + dm);
+                    b = std::max(b, hi[std::size_t(n - dn)] + dm);
+                }
+            });
+            computed += rows0;
+            d = column(n, 0, rows0);
+            init_column<Pattern, Norm>(j, Dw(0, M), S, T, P);
+            prune(0, rows0 - 1);
+            // In-column steps also reach down from a live first row
+            if constexpr (steps::min_dn == 0)
+                if (last >= 0)
+                    a = 0;
+            a = std::max(a, Pattern::first_row);
+            b = std::min(b, M - 1);
+
+            auto interior = [&](index_t from, index_t to) {
+                computed += to + 1 - from;
+                d = column(n, from, to + 1);
+                const index_t r0 = from - Pattern::first_row, rows = to + 1 - r0;
+                interior_columns<Pattern, Norm>(isa, j, Dw(r0, rows), row_range(S, r0, rows),
+                                                row_range(T, r0, rows), row_range(P, r0, rows));
+                prune(from, to);
+            };
+            if (a <= b)
+                interior(a, b);
+            if constexpr (steps::min_dn == 0) {
+                // In-column steps carry a live cell further down
+                index_t end = std::max(b, rows0 - 1);
+                while (end < M - 1 && last == end) {
+                    const index_t to = std::min(end + block, M - 1);
+                    interior(std::max(end + 1, Pattern::first_row), to);
+                    end = to;
+                }
+            }
+        }
+        // Steps reach back max_dn columns, so the search is over once
+        // that many columns in a row are dead
+        if (last >= 0)
+            live = n;
+        if (n - live >= std::max<index_t>(steps::max_dn, 1)) {
+            tally(n + 1);
+            return std::nullopt;
+        }
+    }
+    tally(N);
+    const Hit<Real> hit = score<Pattern>(S, T, P);
+    if (hit.dist < cutoff)
+        return hit;
+    return std::nullopt;
+}
+
+} // namespace detail
+
+// Hit of dtw_rolling<Pattern, Norm>(D) when its dist is below best.dist,
+// std::nullopt otherwise. One pass over D takes the column minima; D
+// must not have negative entries.
+template <class Pattern, class Norm = Accumulated, class Real>
+std::optional<Hit<Real>> dtw_rolling(MatrixView<const Real> D, const BestSoFar& best, Isa isa = active_isa())
+{
+    if (D.empty())
+        throw std::invalid_argument("dtw: empty distance matrix");
+    std::vector<Real> floor(static_cast<std::size_t>(D.cols));
+    for (index_t n = 0; n < D.cols; ++n) {
+        Real low = D(0, n);
+        for (index_t m = 1; m < D.rows; ++m)
+            low = std::min(low, D(m, n));
+        if (!(low >= 0))
+            throw std::invalid_argument("dtw: the cutoff needs non-negative local distances");
+        floor[std::size_t(n)] = low;
+    }
+    return detail::rolling_cutoff<Pattern, Norm, Real>(D.rows, D.cols, D.row_stride, isa, Real(best.dist), floor,
+                                                       [&](index_t n, index_t, index_t) { return &D(0, n); });
+}
+
+// Hit of dtw_features<Pattern, Norm>(dist) when its dist is below
+// best.dist, std::nullopt otherwise. The column minima come from boxes
+// over `block` reference frames; nothing is pruned when the metric can
+// produce negative distances (see FrameDistance::nonnegative()).
+template <class Pattern, class Norm = Accumulated, class Real>
+std::optional<Hit<Real>> dtw_features(const FrameDistance<Real>& dist, const BestSoFar& best,
+                                      Isa isa = active_isa(), index_t block = 64)
+{
+    std::vector<Real> floor;
+    if (dist.nonnegative()) {
+        floor = detail::column_bounds(detail::Envelope<Real>(dist.reference(), block), dist.query());
+        for (Real& f : floor)
+            f = std::max(detail::widened(f), Real(0));
+    }
+    Scratch<Real> column(std::size_t(dist.rows()));
+    return detail::rolling_cutoff<Pattern, Norm, Real>(
+        dist.rows(), dist.cols(), 1, isa, Real(best.dist), floor, [&](index_t n, index_t first, index_t last) {
+            dist.column_rows(n, first, last, column.data(), isa);
+            return static_cast<const Real*>(column.data());
+        });
+}
+
+template <class Pattern, class Norm = Accumulated, class Real>
+std::optional<Hit<Real>> dtw_features(MatrixView<const Real> ref, MatrixView<const Real> qry, Metric metric,
+                                      const BestSoFar& best, Isa isa = active_isa())
+{
+    return dtw_features<Pattern, Norm>(FrameDistance<Real>(ref, qry, metric), best, isa);
+}
+
+} // namespace qbestd
@@ -0,0 +1,375 @@
+/*********************************************************************
+ * Feature archive: a reference corpus in one file that is mapped into
+ * memory instead of loaded. The layout (all integers little-endian) is
+ *
+ *   header   64 bytes, see ArchiveHeader
+ *   blocks   one per utterance, dims x frames values column-major (the
+ *            frames one after the other), each starting on a 64-byte
+ *            boundary, as float32 or IEEE float16
+ *   index    one ArchiveEntry per utterance
+ *   names    utterance names, concatenated without terminators
+ *
+ * Opening an Archive maps the file and checks the header and the index;
+ * no frame is read until the search touches it, so start-up does not
+ * depend on the corpus size. Float32 utterances are handed out as views
+ * into the mapping and can go straight to search_corpus(); float16 ones
+ * (half the disk and page cache) are widened per utterance by decode().
+ * ArchiveWriter streams utterances into a new archive one at a time;
+ * python/build_archive.py writes the same format from WAV files or
+ * posteriorgram dumps.
+ *
+ * Reading uses POSIX mmap.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "counters.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+enum class FrameType : std::uint32_t { Float32 = 0, Float16 = 1 };
+
+struct ArchiveHeader {
+    char magic[8];           // "QBESTDFA"
+    std::uint32_t version;   // 1
+    std::uint32_t type;      // FrameType
+    std::uint64_t dims;      // values per frame
+    std::uint64_t count;     // utterances
+    std::uint64_t frames;    // frames of all utterances
+    std::uint64_t index;     // file offset of the index
+    std::uint64_t names;     // file offset of the names
+    std::uint64_t size;      // file size
+};
+
+struct ArchiveEntry {
+    std::uint64_t offset;     // file offset of the block
+    std::uint64_t frames;
+    std::uint64_t name;       // offset into the names
+    std::uint64_t name_size;
+};
+
+static_assert(sizeof(ArchiveHeader) == 64 && sizeof(ArchiveEntry) == 32, "archive records are packed");
+
+namespace detail {
+
+inline constexpr char archive_magic[8] = {'Q', 'B', 'E', 'S', 'T', 'D', 'F', 'A'};
+inline constexpr std::uint32_t archive_version = 1;
+inline constexpr std::uint64_t archive_align = 64;
+
+inline bool little_endian()
+{
+    const std::uint16_t one = 1;
+    unsigned char low;
+    std::memcpy(&low, &one, 1);
+    return low == 1;
+}
+
+inline std::size_t frame_bytes(FrameType type)
+{
+    return type == FrameType::Float16 ? 2 : 4;
+}
+
+// IEEE binary16 <-> binary32, rounding to nearest even.
+inline float half_to_float(std::uint16_t h)
+{
+    const std::uint32_t sign = std::uint32_t(h & 0x8000) << 16;
+    const std::uint32_t exp = (h >> 10) & 0x1f, mant = h & 0x3ff;
+    if (exp == 0) {
+        const float f = std::ldexp(float(mant), -24);
+        return sign ? -f : f;
+    }
+    const std::uint32_t bits = sign | (exp == 31 ? 0x7f800000 | mant << 13 : (exp + 112) << 23 | mant << 13);
+    float f;
+    std::memcpy(&f, &bits, 4);
+    return f;
+}
+
+inline std::uint16_t float_to_half(float f)
+{
+    std::uint32_t x;
+    std::memcpy(&x, &f, 4);
+    const std::uint16_t sign = std::uint16_t(x >> 16 & 0x8000);
+    std::uint32_t a = x & 0x7fffffff;
+    if (a >= 0x7f800000)  // Inf, NaN (kept quiet)
+        return std::uint16_t(sign | 0x7c00 | (a > 0x7f800000 ? 0x200 : 0));
+    if (a >= 0x477ff000)  // rounds past 65504
+        return std::uint16_t(sign | 0x7c00);
+    if (a < 0x38800000) {  // below 2^-14: a multiple of 2^-24
+        float m;
+        std::memcpy(&m, &a, 4);
+        return std::uint16_t(sign | std::uint16_t(std::nearbyint(m * 16777216.0f)));
+    }
+    a += 0xfff + (a >> 13 & 1);
+    return std::uint16_t(sign | (a - 0x38000000) >> 13);
+}
+
+} // namespace detail
+
+// Read-only mapping of an archive. Views and names stay valid while the
+// Archive lives.
+class Archive {
+public:
+    explicit Archive(const std::string& path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("archive: cannot open " + path);
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || std::uint64_t(st.st_size) < sizeof(ArchiveHeader)) {
+            ::close(fd);
+            throw std::runtime_error("archive: " + path + " is not an archive");
+        }
+        size_ = std::size_t(st.st_size);
+        void* base = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED)
+            throw std::runtime_error("archive: cannot map " + path);
+        base_ = static_cast<const unsigned char*>(base);
+        try {
+            check(path);
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    Archive(Archive&& other) noexcept
+        : base_(std::exchange(other.base_, nullptr)), size_(std::exchange(other.size_, 0)),
+          header_(other.header_), entries_(other.entries_)
+    {
+    }
+    Archive& operator=(Archive&& other) noexcept
+    {
+        if (this != &other) {
+            unmap();
+            base_ = std::exchange(other.base_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            header_ = other.header_;
+            entries_ = other.entries_;
+        }
+        return *this;
+    }
+    Archive(const Archive&) = delete;
+    Archive& operator=(const Archive&) = delete;
+    ~Archive() { unmap(); }
+
+    std::size_t size() const { return std::size_t(header_.count); }
+    index_t dims() const { return index_t(header_.dims); }
+    FrameType type() const { return FrameType(header_.type); }
+    index_t total_frames() const { return index_t(header_.frames); }
+    index_t frames(std::size_t u) const { return index_t(entry(u).frames); }
+
+    std::string_view name(std::size_t u) const
+    {
+        const ArchiveEntry e = entry(u);
+        return {reinterpret_cast<const char*>(base_ + header_.names + e.name), std::size_t(e.name_size)};
+    }
+
+    // Frames of utterance u as a dims x frames view into the mapping.
+    MatrixView<const float> utterance(std::size_t u) const
+    {
+        if (type() != FrameType::Float32)
+            throw std::invalid_argument("archive: float16 utterances must be decoded");
+        return column_major(reinterpret_cast<const float*>(block(u)), dims(), frames(u));
+    }
+
+    // All utterances, in archive order, for search_corpus().
+    std::vector<MatrixView<const float>> utterances() const
+    {
+        std::vector<MatrixView<const float>> out;
+        out.reserve(size());
+        for (std::size_t u = 0; u < size(); ++u)
+            out.push_back(utterance(u));
+        return out;
+    }
+
+    // The raw binary16 values of a float16 utterance.
+    MatrixView<const std::uint16_t> half_utterance(std::size_t u) const
+    {
+        if (type() != FrameType::Float16)
+            throw std::invalid_argument("archive: utterances are float32");
+        return column_major(reinterpret_cast<const std::uint16_t*>(block(u)), dims(), frames(u));
+    }
+
+    // Writes the dims * frames(u) values of utterance u, column-major, to
+    // `out` as float, whichever the stored type.
+    void decode(std::size_t u, float* out) const
+    {
+        const detail::StageTimer timer(Stage::Load);
+        const std::size_t n = std::size_t(dims() * frames(u));
+        if (type() == FrameType::Float32) {
+            std::memcpy(out, block(u), n * sizeof(float));
+            return;
+        }
+        const std::uint16_t* h = half_utterance(u).data;
+        for (std::size_t i = 0; i < n; ++i)
+            out[i] = detail::half_to_float(h[i]);
+    }
+
+private:
+    ArchiveEntry entry(std::size_t u) const
+    {
+        ArchiveEntry e;
+        std::memcpy(&e, entries_ + u * sizeof(ArchiveEntry), sizeof e);
+        return e;
+    }
+
+    const unsigned char* block(std::size_t u) const { return base_ + entry(u).offset; }
+
+    // Everything the accessors rely on, so that a truncated or foreign
+    // file fails here and not in the middle of a search.
+    void check(const std::string& path)
+    {
+        auto fail = [&](const char* what) { throw std::runtime_error("archive: " + path + ": " + what); };
+        if (!detail::little_endian())
+            fail("big-endian hosts are not supported");
+        std::memcpy(&header_, base_, sizeof header_);
+        const ArchiveHeader& h = header_;
+        if (std::memcmp(h.magic, detail::archive_magic, 8) != 0)
+            fail("not an archive (or not finished)");
+        if (h.version != detail::archive_version)
+            fail("unsupported version");
+        if (h.type > std::uint32_t(FrameType::Float16))
+            fail("unknown frame type");
+        if (h.size != size_)
+            fail("truncated");
+        const std::uint64_t table = h.count * sizeof(ArchiveEntry);
+        if (h.dims == 0 || h.dims > size_ || h.count > size_ / sizeof(ArchiveEntry) || h.index > size_ ||
+            table > size_ - h.index || h.names < h.index + table || h.names > size_)
+            fail("corrupt index");
+        entries_ = base_ + h.index;
+
+        const std::uint64_t per_frame = h.dims * detail::frame_bytes(type());
+        std::uint64_t frames = 0;
+        for (std::size_t u = 0; u < size(); ++u) {
+            const ArchiveEntry e = entry(u);
+            if (e.offset % detail::archive_align != 0 || e.offset < sizeof(ArchiveHeader) || e.offset > h.index ||
+                e.frames > (h.index - e.offset) / per_frame || e.name_size > size_ - h.names ||
+                e.name > size_ - h.names - e.name_size)
+                fail("corrupt index");
+            frames += e.frames;
+        }
+        if (frames != h.frames)
+            fail("corrupt index");
+    }
+
+    void unmap()
+    {
+        if (base_)
+            ::munmap(const_cast<unsigned char*>(base_), size_);
+        base_ = nullptr;
+    }
+
+    const unsigned char* base_ = nullptr;
+    std::size_t size_ = 0;
+    ArchiveHeader header_{};
+    const unsigned char* entries_ = nullptr;
+};
+
+// Writes an archive one utterance at a time. The file only becomes a
+// valid archive when finish() has written the index and the header.
+class ArchiveWriter {
+public:
+    ArchiveWriter(const std::string& path, index_t dims, FrameType type = FrameType::Float32)
+        : path_(path), out_(path, std::ios::binary | std::ios::trunc), dims_(dims), type_(type)
+    {
+        if (dims <= 0)
+            throw std::invalid_argument("archive: dims must be positive");
+        if (!out_)
+            throw std::runtime_error("archive: cannot create " + path);
+        if (!detail::little_endian())
+            throw std::runtime_error("archive: big-endian hosts are not supported");
+        const ArchiveHeader blank{};
+        write(&blank, sizeof blank);
+    }
+
+    // frames is dims x count, one frame per column, with any strides.
+    template <class Real>
+    void add(std::string_view name, MatrixView<const Real> frames)
+    {
+        if (frames.rows != dims_)
+            throw std::invalid_argument("archive: utterance dims differ from the archive's");
+        entries_.push_back(ArchiveEntry{offset_, std::uint64_t(frames.cols), names_.size(), name.size()});
+        names_.append(name);
+        total_ += std::uint64_t(frames.cols);
+
+        std::vector<float> f(static_cast<std::size_t>(dims_));
+        std::vector<std::uint16_t> h(type_ == FrameType::Float16 ? f.size() : 0);
+        for (index_t n = 0; n < frames.cols; ++n) {
+            for (index_t d = 0; d < dims_; ++d)
+                f[std::size_t(d)] = float(frames(d, n));
+            if (type_ == FrameType::Float32) {
+                write(f.data(), f.size() * sizeof(float));
+            } else {
+                std::transform(f.begin(), f.end(), h.begin(), detail::float_to_half);
+                write(h.data(), h.size() * sizeof(std::uint16_t));
+            }
+        }
+        pad();
+    }
+
+    void finish()
+    {
+        ArchiveHeader h{};
+        std::memcpy(h.magic, detail::archive_magic, 8);
+        h.version = detail::archive_version;
+        h.type = std::uint32_t(type_);
+        h.dims = std::uint64_t(dims_);
+        h.count = entries_.size();
+        h.frames = total_;
+        h.index = offset_;
+        write(entries_.data(), entries_.size() * sizeof(ArchiveEntry));
+        h.names = offset_;
+        write(names_.data(), names_.size());
+        h.size = offset_;
+        out_.seekp(0);
+        out_.write(reinterpret_cast<const char*>(&h), sizeof h);
+        out_.close();
+        if (!out_)
+            throw std::runtime_error("archive: cannot write " + path_);
+    }
+
+private:
+    void write(const void* data, std::size_t bytes)
+    {
+        out_.write(static_cast<const char*>(data), std::streamsize(bytes));
+        if (!out_)
+            throw std::runtime_error("archive: cannot write " + path_);
+        offset_ += bytes;
+    }
+
+    void pad()
+    {
+        static const char zeros[detail::archive_align] = {};
+        const std::uint64_t used = offset_ % detail::archive_align;
+        write(zeros, std::size_t(used ? detail::archive_align - used : 0));
+    }
+
+    std::string path_;
+    std::ofstream out_;
+    index_t dims_;
+    FrameType type_;
+    std::uint64_t offset_ = 0;
+    std::uint64_t total_ = 0;
+    std::vector<ArchiveEntry> entries_;
+    std::string names_;
+};
+
+} // namespace qbestd
@@ -0,0 +1,254 @@
+/*********************************************************************
+ * Audio input for the MFCC front end: 16-bit PCM WAV files, mixed down
+ * to mono as float samples in [-1, 1) the way librosa.load reads them,
+ * and a band-limited resampler for files whose rate differs from the
+ * feature rate.
+ *
+ * The resampler is a polyphase windowed sinc (Kaiser window, 32 zero
+ * crossings, cut off at 95% of the lower Nyquist frequency). librosa
+ * resamples with soxr instead, so features of resampled files match
+ * the Python ones closely but not bit for bit; files at the feature
+ * rate are not touched. Resampler works on a stream of samples; the
+ * resample() convenience form runs it over a whole signal.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "counters.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+struct Audio {
+    int sample_rate = 0;
+    std::vector<float> samples;  // mono
+};
+
+namespace detail {
+
+inline std::uint32_t le32(const unsigned char* p)
+{
+    return std::uint32_t(p[0]) | std::uint32_t(p[1]) << 8 | std::uint32_t(p[2]) << 16 | std::uint32_t(p[3]) << 24;
+}
+
+inline std::uint16_t le16(const unsigned char* p)
+{
+    return std::uint16_t(p[0] | p[1] << 8);
+}
+
+} // namespace detail
+
+// Reads a 16-bit PCM WAV file (plain or WAVE_FORMAT_EXTENSIBLE); the
+// channels are averaged.
+inline Audio read_wav(const std::string& path)
+{
+    const detail::StageTimer load(Stage::Load);
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        throw std::runtime_error("wav: cannot open " + path);
+    std::vector<unsigned char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    auto fail = [&](const char* what) { throw std::runtime_error("wav: " + path + ": " + what); };
+    if (file.size() < 12 || std::memcmp(file.data(), "RIFF", 4) != 0 || std::memcmp(file.data() + 8, "WAVE", 4) != 0)
+        fail("not a RIFF/WAVE file");
+
+    Audio out;
+    int channels = 0;
+    const unsigned char* data = nullptr;
+    std::size_t data_bytes = 0;
+    for (std::size_t at = 12; at + 8 <= file.size();) {
+        const unsigned char* chunk = file.data() + at;
+        const std::size_t size = detail::le32(chunk + 4);
+        const std::size_t body = std::min(size, file.size() - at - 8);
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (body < 16)
+                fail("truncated fmt chunk");
+            std::uint16_t format = detail::le16(chunk + 8);
+            if (format == 0xFFFE && body >= 26)  // WAVE_FORMAT_EXTENSIBLE: the subformat GUID starts with the tag
+                format = detail::le16(chunk + 8 + 24);
+            channels = detail::le16(chunk + 10);
+            out.sample_rate = int(detail::le32(chunk + 12));
+            if (format != 1 || detail::le16(chunk + 22) != 16)
+                fail("only 16-bit PCM is supported");
+            if (channels < 1 || out.sample_rate < 1)
+                fail("bad fmt chunk");
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            data = chunk + 8;
+            data_bytes = body;
+        }
+        at += 8 + size + (size & 1);
+    }
+    if (channels == 0)
+        fail("no fmt chunk");
+    if (data == nullptr)
+        fail("no data chunk");
+
+    const std::size_t frames = data_bytes / (2 * std::size_t(channels));
+    out.samples.resize(frames);
+    for (std::size_t f = 0; f < frames; ++f) {
+        float sum = 0;
+        const unsigned char* frame = data + 2 * f * std::size_t(channels);
+        for (int c = 0; c < channels; ++c)
+            sum += float(std::int16_t(detail::le16(frame + 2 * std::size_t(c)))) / 32768.0f;
+        out.samples[f] = sum / float(channels);
+    }
+    return out;
+}
+
+// Writes mono 16-bit PCM, rounding and clipping the samples.
+inline void write_wav(const std::string& path, const Audio& audio)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+        throw std::runtime_error("wav: cannot create " + path);
+    auto u32 = [&](std::uint32_t v) {
+        const unsigned char b[4] = {(unsigned char)v, (unsigned char)(v >> 8), (unsigned char)(v >> 16),
+                                    (unsigned char)(v >> 24)};
+        out.write(reinterpret_cast<const char*>(b), 4);
+    };
+    auto u16 = [&](std::uint16_t v) {
+        const unsigned char b[2] = {(unsigned char)v, (unsigned char)(v >> 8)};
+        out.write(reinterpret_cast<const char*>(b), 2);
+    };
+    const std::uint32_t bytes = std::uint32_t(2 * audio.samples.size());
+    out.write("RIFF", 4);
+    u32(36 + bytes);
+    out.write("WAVEfmt ", 8);
+    u32(16);
+    u16(1);  // PCM
+    u16(1);  // mono
+    u32(std::uint32_t(audio.sample_rate));
+    u32(std::uint32_t(2 * audio.sample_rate));
+    u16(2);
+    u16(16);
+    out.write("data", 4);
+    u32(bytes);
+    for (float s : audio.samples)
+        u16(std::uint16_t(std::int16_t(std::clamp(std::lround(double(s) * 32768.0), -32768L, 32767L))));
+    if (!out)
+        throw std::runtime_error("wav: cannot write " + path);
+}
+
+// Converts a stream of samples from one rate to another. Output sample
+// j sits at input time j * from / to; samples before the first and
+// after the last input are zero.
+class Resampler {
+public:
+    Resampler(int from, int to)
+    {
+        if (from < 1 || to < 1)
+            throw std::invalid_argument("resample: rates must be positive");
+        const int g = std::gcd(from, to);
+        up_ = to / g;
+        down_ = from / g;
+        // Sinc cut off below the lower Nyquist frequency, in input samples
+        const double cutoff = rolloff * std::min(1.0, double(up_) / double(down_));
+        const double reach = zero_crossings / cutoff;
+        half_ = index_t(std::ceil(reach));
+        const index_t taps = 2 * half_;
+        filter_.resize(std::size_t(up_ * taps));
+        const double norm = bessel_i0(beta);
+        for (index_t p = 0; p < up_; ++p)
+            for (index_t k = 0; k < taps; ++k) {
+                // Tap k of phase p weighs input sample base - half + 1 + k
+                const double t = double(k - half_ + 1) - double(p) / double(up_);
+                const double r = t / reach;
+                double h = 0;
+                if (std::abs(r) < 1) {
+                    const double x = cutoff * t;
+                    const double sinc = x == 0 ? 1.0 : std::sin(pi * x) / (pi * x);
+                    h = cutoff * sinc * bessel_i0(beta * std::sqrt(1 - r * r)) / norm;
+                }
+                filter_[std::size_t(p * taps + k)] = float(h);
+            }
+    }
+
+    // Appends the output samples the new input completes to out.
+    void push(const float* samples, std::size_t count, std::vector<float>& out)
+    {
+        input_.insert(input_.end(), samples, samples + count);
+        received_ += index_t(count);
+        emit(received_, out);
+    }
+
+    // End of input: the remaining ceil(inputs * to / from) outputs.
+    void flush(std::vector<float>& out)
+    {
+        const index_t total = (received_ * up_ + down_ - 1) / down_;
+        input_.resize(input_.size() + std::size_t(half_), 0.0f);
+        emit(received_ + half_, out, total);
+    }
+
+private:
+    static constexpr double pi = 3.14159265358979323846;
+    static constexpr double rolloff = 0.95;
+    static constexpr double zero_crossings = 32;
+    static constexpr double beta = 9.0;
+
+    static double bessel_i0(double x)
+    {
+        double sum = 1, term = 1;
+        for (int k = 1; k < 64 && term > 1e-17 * sum; ++k) {
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+        }
+        return sum;
+    }
+
+    // Outputs whose taps lie below `available` input samples (up to
+    // `limit` outputs in all).
+    void emit(index_t available, std::vector<float>& out, index_t limit = -1)
+    {
+        const index_t taps = 2 * half_;
+        for (;; ++next_) {
+            if (limit >= 0 && next_ >= limit)
+                break;
+            const index_t base = next_ * down_ / up_, phase = next_ * down_ % up_;
+            if (base + half_ >= available)
+                break;
+            const float* h = filter_.data() + phase * taps;
+            float sum = 0;
+            for (index_t k = 0; k < taps; ++k) {
+                const index_t i = base - half_ + 1 + k;
+                if (i >= first_)
+                    sum += h[k] * input_[std::size_t(i - first_)];
+            }
+            out.push_back(sum);
+        }
+        // Inputs no later output reaches
+        const index_t keep = std::max<index_t>(first_, next_ * down_ / up_ - half_ + 1);
+        if (keep > first_) {
+            input_.erase(input_.begin(), input_.begin() + (keep - first_));
+            first_ = keep;
+        }
+    }
+
+    index_t up_ = 1, down_ = 1, half_ = 0;
+    std::vector<float> filter_;  // up_ phases of 2 half_ taps
+    std::vector<float> input_;   // samples first_ .. first_ + size - 1
+    index_t first_ = 0, received_ = 0, next_ = 0;
+};
+
+// The whole signal at the rate `to`; unchanged when the rates agree.
+inline Audio resample(const Audio& audio, int to)
+{
+    if (audio.sample_rate == to)
+        return audio;
+    const detail::StageTimer load(Stage::Load);
+    Resampler r(audio.sample_rate, to);
+    Audio out{to, {}};
+    r.push(audio.samples.data(), audio.samples.size(), out.samples);
+    r.flush(out.samples);
+    return out;
+}
+
+} // namespace qbestd
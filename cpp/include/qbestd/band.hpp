@@ -0,0 +1,142 @@
+/*********************************************************************
+ * Global path constraints as part of the recurrence. A Band admits rows
+ * lo(n) .. hi(n) of column n, computed in closed form: the Sakoe-Chiba
+ * band |m - slope n| <= radius around a line through (0, 0), and the
+ * Itakura parallelogram, in which a path can keep a slope between
+ * 1/max_slope and max_slope from (0, 0) to its end. Either can be used,
+ * or both, which keeps their intersection.
+ *
+ * dtw_band<Pattern, Norm>(D, band) aligns an anchored pattern (OpenEndDTW,
+ * BasicDTW, SymmetricDTW) inside the band only. It keeps two columns as
+ * wide as the band, so cells outside it are neither computed nor stored.
+ * The result is that of dtw() on D with +Inf outside the band, which is
+ * what adding masking_distMtrx_segDTW's Mask did, at a cost of
+ * band cells instead of M x N. segmental_dtw (segmental.hpp) runs the
+ * same kernel on many segments at once.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "counters.hpp"
+#include "patterns.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "steps.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+struct Band {
+    index_t radius = -1;    // Sakoe-Chiba rows on either side of the centre line; < 0: none
+    double slope = 1;       // rows per column of the centre line, e.g. (M-1)/(N-1)
+    double max_slope = 0;   // Itakura limit on the path slope, at least 1; 0: none
+
+    // Rows lo .. hi of column n of an M x N grid, clipped to 0 .. M-1;
+    // lo > hi when the band leaves no row. The Itakura limit counts
+    // from (0, 0), and for a corner end also back from (M-1, N-1).
+    std::pair<index_t, index_t> rows(index_t n, index_t M, index_t N, End end) const
+    {
+        // Rounding must not drop a row the band passes exactly through
+        constexpr double eps = 1e-9;
+        double lo = 0, hi = double(M - 1);
+        if (radius >= 0) {
+            lo = std::max(lo, std::ceil(slope * double(n) - double(radius) - eps));
+            hi = std::min(hi, std::floor(slope * double(n) + double(radius) + eps));
+        }
+        if (max_slope > 0) {
+            lo = std::max(lo, std::ceil(double(n) / max_slope - eps));
+            hi = std::min(hi, std::floor(double(n) * max_slope + eps));
+            if (end == End::Corner) {
+                const double left = double(N - 1 - n);
+                lo = std::max(lo, std::ceil(double(M - 1) - left * max_slope - eps));
+                hi = std::min(hi, std::floor(double(M - 1) - left / max_slope + eps));
+            }
+        }
+        if (lo > hi)
+            return {0, -1};
+        return {index_t(lo), index_t(hi)};
+    }
+};
+
+namespace detail {
+namespace scalar {
+#include "detail/band_kernels.inl"
+} // namespace scalar
+} // namespace detail
+
+#if QBESTD_X86_SIMD
+
+QBESTD_PUSH_TARGET_AVX2
+namespace detail::avx2 {
+#include "detail/band_kernels.inl"
+} // namespace detail::avx2
+QBESTD_POP_TARGET
+
+QBESTD_PUSH_TARGET_AVX512
+namespace detail::avx512 {
+#include "detail/band_kernels.inl"
+} // namespace detail::avx512
+QBESTD_POP_TARGET
+
+#endif // QBESTD_X86_SIMD
+
+namespace detail {
+
+inline void check_band(const Band& band)
+{
+    if (!(band.slope >= 0) || !std::isfinite(band.slope))
+        throw std::invalid_argument("band: the slope must not be negative");
+    if (band.max_slope != 0 && !(band.max_slope >= 1 && std::isfinite(band.max_slope)))
+        throw std::invalid_argument("band: max_slope must be 0 or at least 1");
+}
+
+// Rows of every column of a band alignment of `length` x N; returns the
+// widest column and the number of band cells.
+inline std::pair<index_t, index_t> band_rows(const Band& band, index_t length, index_t N, End end, index_t* lo,
+                                             index_t* hi)
+{
+    index_t width = 0, cells = 0;
+    for (index_t n = 0; n < N; ++n) {
+        std::tie(lo[n], hi[n]) = band.rows(n, length, N, end);
+        width = std::max(width, hi[n] - lo[n] + 1);
+        cells += std::max<index_t>(hi[n] - lo[n] + 1, 0);
+    }
+    return {width, cells};
+}
+
+} // namespace detail
+
+// Best hit of the anchored Pattern inside the band: dist is S/T at the
+// end row (+Inf when the band admits no path), start 0.
+template <class Pattern, class Norm = Accumulated, class Real>
+Hit<Real> dtw_band(MatrixView<const Real> D, const Band& band)
+{
+    static_assert(Pattern::start == Start::Anchored, "a band needs paths anchored at (0, 0)");
+    static_assert(Pattern::first_col == 1 && Pattern::steps::max_dn <= 1,
+                  "a band needs steps with at most one column of look-back");
+    static_assert(std::is_floating_point_v<Real>, "band alignments need a floating-point D");
+    if (D.empty())
+        throw std::invalid_argument("dtw: empty distance matrix");
+    detail::check_band(band);
+
+    const detail::StageTimer timer(Stage::Dp);
+    Scratch<index_t> lo(std::size_t(2 * D.cols));
+    index_t* hi = lo.data() + D.cols;
+    const auto [width, cells] = detail::band_rows(band, D.rows, D.cols, Pattern::end, lo.data(), hi);
+    detail::count_cells(cells);
+    detail::count_pruned(D.rows * D.cols - cells);
+
+    Hit<Real> hit{0, 0, 0};
+    detail::scalar::band_group<Scalar<Real>, Norm>(typename Pattern::steps{}, D, lo.data(), hi, width, D.rows,
+                                                   Pattern::end == End::Open, 0, &hit.dist, &hit.end);
+    return hit;
+}
+
+} // namespace qbestd
@@ -0,0 +1,160 @@
+/*********************************************************************
+ * Many queries against one reference in one pass. search_batch() sorts
+ * the queries by length and runs them in groups of one SIMD width: for
+ * every column, each reference frame is loaded once and scored against
+ * the current frame of all queries of the group (one query per lane),
+ * and the rolling recurrence then advances all lanes together. Unlike
+ * the row-parallel kernels this also vectorizes the in-column patterns
+ * (GTTS, NewNSDTW), since lanes never depend on each other. Every hit
+ * is identical to dtw_features(..., Isa::Scalar) for that query.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "counters.hpp"
+#include "distance.hpp"
+#include "dtw.hpp"
+#include "kernels.hpp"
+#include "patterns.hpp"
+#include "rolling.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+namespace detail {
+namespace scalar {
+#include "detail/batch_kernels.inl"
+} // namespace scalar
+} // namespace detail
+
+#if QBESTD_X86_SIMD
+
+QBESTD_PUSH_TARGET_AVX2
+namespace detail::avx2 {
+#include "detail/batch_kernels.inl"
+} // namespace detail::avx2
+QBESTD_POP_TARGET
+
+QBESTD_PUSH_TARGET_AVX512
+namespace detail::avx512 {
+#include "detail/batch_kernels.inl"
+} // namespace detail::avx512
+QBESTD_POP_TARGET
+
+#endif // QBESTD_X86_SIMD
+
+namespace detail {
+
+// Runs the queries qry[0..] in groups of V::width lanes; a short last
+// group repeats its first query in the spare lanes.
+template <class V, class Real, class Group>
+void lane_groups(const std::vector<const Frames<Real>*>& qry, Hit<Real>* hits, Group&& group)
+{
+    constexpr int W = V::width;
+    for (std::size_t g = 0; g < qry.size(); g += W) {
+        const Frames<Real>* lanes[W];
+        Hit<Real> out[W];
+        for (int i = 0; i < W; ++i)
+            lanes[i] = qry[std::min(g + i, qry.size() - 1)];
+        group(lanes, out);
+        for (int i = 0; i < W && g + i < qry.size(); ++i)
+            hits[g + i] = out[i];
+    }
+}
+
+// Hit of every query in qry against ref, in the order of qry. Lanes of a
+// group are best filled with queries of similar length (longest first).
+template <class Pattern, class Norm, class Real>
+void search_lanes(const Frames<Real>& ref, const std::vector<const Frames<Real>*>& qry, Hit<Real>* hits,
+                  Isa isa)
+{
+    // The lanes compute each distance right where the DP needs it, so
+    // the time of both is charged to the DP
+    const StageTimer timer(Stage::Dp);
+    index_t frames = 0;
+    for (const Frames<Real>* q : qry)
+        frames += q->count;
+    count_distances(ref.count * frames);
+    count_cells(ref.count * frames);
+#if QBESTD_X86_SIMD
+    if constexpr (detail::simd_real<Real>) {
+        if (isa == Isa::Avx512) {
+            lane_groups<Avx512<Real>>(qry, hits, [&](auto lanes, auto out) {
+                avx512::lane_group<Avx512<Real>, Pattern, Norm>(ref, lanes, out);
+            });
+            return;
+        }
+        if (isa == Isa::Avx2) {
+            lane_groups<Avx2<Real>>(qry, hits, [&](auto lanes, auto out) {
+                avx2::lane_group<Avx2<Real>, Pattern, Norm>(ref, lanes, out);
+            });
+            return;
+        }
+    }
+#endif
+    (void)isa;
+    lane_groups<Scalar<Real>>(qry, hits, [&](auto lanes, auto out) {
+        scalar::lane_group<Scalar<Real>, Pattern, Norm>(ref, lanes, out);
+    });
+}
+
+// Indices of qry, longest query first (ties keep their order).
+template <class Real>
+std::vector<std::size_t> longest_first(const std::vector<Frames<Real>>& qry)
+{
+    std::vector<std::size_t> order(qry.size());
+    std::iota(order.begin(), order.end(), std::size_t(0));
+    std::stable_sort(order.begin(), order.end(),
+                     [&](std::size_t a, std::size_t b) { return qry[a].count > qry[b].count; });
+    return order;
+}
+
+// Frames of every query, checked against the reference dimension.
+template <class Real>
+std::vector<Frames<Real>> query_frames(const std::vector<MatrixView<const Real>>& queries, index_t dims,
+                                       Metric metric, const char* caller)
+{
+    std::vector<Frames<Real>> qry;
+    qry.reserve(queries.size());
+    for (const MatrixView<const Real>& q : queries) {
+        if (q.empty() || q.rows != dims)
+            throw std::invalid_argument(std::string(caller) + ": query dimensions do not match the reference");
+        qry.emplace_back(q, metric);
+    }
+    return qry;
+}
+
+} // namespace detail
+
+// Hit of every query (ND x N_q each) against ref (ND x M), in query order.
+template <class Pattern, class Norm = Accumulated, class Real>
+std::vector<Hit<Real>> search_batch(MatrixView<const Real> ref,
+                                    const std::vector<MatrixView<const Real>>& queries,
+                                    Metric metric, Isa isa = active_isa())
+{
+    if (ref.empty())
+        throw std::invalid_argument("search_batch: empty reference");
+    const detail::Frames<Real> r(ref, metric);
+    const std::vector<detail::Frames<Real>> qry = detail::query_frames(queries, ref.rows, metric, "search_batch");
+
+    // Longest first, so the lanes of a group finish at similar columns
+    const std::vector<std::size_t> order = detail::longest_first(qry);
+    std::vector<const detail::Frames<Real>*> sorted;
+    for (std::size_t q : order)
+        sorted.push_back(&qry[q]);
+    std::vector<Hit<Real>> found(qry.size()), hits(qry.size());
+    detail::search_lanes<Pattern, Norm>(r, sorted, found.data(), isa);
+    for (std::size_t i = 0; i < order.size(); ++i)
+        hits[order[i]] = found[i];
+    return hits;
+}
+
+} // namespace qbestd
@@ -0,0 +1,149 @@
+/*********************************************************************
+ * Coarse-to-fine search. dtw_coarse<Pattern, Norm>(ref, qry, metric)
+ * averages every `factor` consecutive frames of the reference and the
+ * query and runs the recurrence on the pooled grid, which has factor^2
+ * times fewer cells. The best candidates of that pass (start rows from
+ * P, end rows from the last column) are widened by a margin, scaled back
+ * to reference frames and merged where they meet. Only those regions are
+ * then searched at full resolution with the whole query.
+ *
+ * Each region starts Pattern::first_row frames early, since the first
+ * rows of a search only take horizontal steps; a path starting on the
+ * region's own first frame then climbs as it does in the full search.
+ * When the best full-resolution path lies inside a region, the result
+ * is exact under Accumulated for patterns with a horizontal step;
+ * otherwise it is the best hit inside the regions. Free-start patterns
+ * only: an anchored search has no candidates to choose between.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "counters.hpp"
+#include "distance.hpp"
+#include "dtw.hpp"
+#include "fused.hpp"
+#include "patterns.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+struct CoarseOptions {
+    index_t factor = 4;          // frames averaged into one coarse frame
+    std::size_t candidates = 8;  // coarse hits refined at full resolution
+    double margin = 0.5;         // rows added on both sides of a candidate, in query lengths
+    Isa isa = active_isa();
+};
+
+namespace detail {
+
+// Means of `factor` consecutive frames, column-major; the last group may
+// be shorter.
+template <class Real>
+Scratch<Real> pool(MatrixView<const Real> X, index_t factor)
+{
+    const index_t count = (X.cols + factor - 1) / factor;
+    Scratch<Real> out(std::size_t(X.rows * count), Real(0));
+    for (index_t c = 0; c < count; ++c) {
+        const index_t first = c * factor, last = std::min(first + factor, X.cols);
+        Real* o = out.data() + c * X.rows;
+        for (index_t f = first; f < last; ++f)
+            for (index_t d = 0; d < X.rows; ++d)
+                o[d] += X(d, f);
+        for (index_t d = 0; d < X.rows; ++d)
+            o[d] /= Real(last - first);
+    }
+    return out;
+}
+
+// Reference frames [first, last] around each coarse hit, in order and
+// merged where they overlap or touch. `lead` more frames go before the
+// start: the first rows of a region are boundary rows of its search.
+template <class Real>
+std::vector<std::pair<index_t, index_t>> fine_regions(const std::vector<Hit<Real>>& coarse, index_t factor,
+                                                      index_t margin, index_t frames, index_t lead = 0)
+{
+    std::vector<std::pair<index_t, index_t>> regions;
+    for (const Hit<Real>& h : coarse)
+        regions.emplace_back(std::max<index_t>(0, h.start * factor - margin - lead),
+                             std::min(frames - 1, (h.end + 1) * factor - 1 + margin));
+    std::sort(regions.begin(), regions.end());
+    std::vector<std::pair<index_t, index_t>> merged;
+    for (const std::pair<index_t, index_t>& r : regions) {
+        if (!merged.empty() && r.first <= merged.back().second + 1)
+            merged.back().second = std::max(merged.back().second, r.second);
+        else
+            merged.push_back(r);
+    }
+    return merged;
+}
+
+template <class Pattern, class Norm, class Real>
+std::vector<Hit<Real>> coarse_to_fine(MatrixView<const Real> ref, MatrixView<const Real> qry, Metric metric,
+                                      const TopK& top, const CoarseOptions& opt)
+{
+    static_assert(Pattern::start == Start::Free, "coarse search needs a free-start pattern");
+    if (ref.empty() || qry.empty())
+        throw std::invalid_argument("distance: empty feature matrix");
+    if (opt.factor < 1 || opt.candidates < 1 || !(opt.margin >= 0))
+        throw std::invalid_argument("coarse: factor and candidates must be positive, margin non-negative");
+
+    const index_t dims = ref.rows;
+    const Scratch<Real> r = pool(ref, opt.factor), q = pool(qry, opt.factor);
+    const MatrixView<const Real> pooled_ref = column_major(r.data(), dims, index_t(r.size()) / dims);
+    const MatrixView<const Real> pooled_qry = column_major(q.data(), dims, index_t(q.size()) / dims);
+    const std::vector<Hit<Real>> coarse =
+        dtw_features<Pattern, Norm>(pooled_ref, pooled_qry, metric, TopK{opt.candidates, 0.0}, opt.isa);
+
+    const index_t margin = index_t(std::ceil(opt.margin * double(qry.cols)));
+    std::vector<Hit<Real>> hits;
+    for (const auto& [first, last] : fine_regions(coarse, opt.factor, margin, ref.cols, Pattern::first_row)) {
+        const MatrixView<const Real> part{&ref(0, first), dims, last - first + 1, ref.row_stride, ref.col_stride};
+        for (Hit<Real> h : dtw_features<Pattern, Norm>(part, qry, metric, top, opt.isa)) {
+            h.start += first;
+            h.end += first;
+            hits.push_back(h);
+        }
+    }
+
+    // Regions are disjoint, but their hits are ranked together
+    const StageTimer timer(Stage::Merge);
+    std::stable_sort(hits.begin(), hits.end(),
+                     [](const Hit<Real>& a, const Hit<Real>& b) { return a.dist < b.dist; });
+    std::vector<Hit<Real>> out;
+    for (const Hit<Real>& h : hits) {
+        if (out.size() == top.count)
+            break;
+        if (std::none_of(out.begin(), out.end(),
+                         [&](const Hit<Real>& kept) { return overlaps(h, kept, top.max_overlap); }))
+            out.push_back(h);
+    }
+    return out;
+}
+
+} // namespace detail
+
+// ref is ND x N1 and qry ND x N2 (frames in columns), as dtw_features().
+template <class Pattern, class Norm = Accumulated, class Real>
+Hit<Real> dtw_coarse(MatrixView<const Real> ref, MatrixView<const Real> qry, Metric metric,
+                     const CoarseOptions& opt = {})
+{
+    return detail::coarse_to_fine<Pattern, Norm>(ref, qry, metric, TopK{1, 0.0}, opt).front();
+}
+
+// The top.count best hits inside the refined regions, best first.
+template <class Pattern, class Norm = Accumulated, class Real>
+std::vector<Hit<Real>> dtw_coarse(MatrixView<const Real> ref, MatrixView<const Real> qry, Metric metric,
+                                  const TopK& top, const CoarseOptions& opt = {})
+{
+    return detail::coarse_to_fine<Pattern, Norm>(ref, qry, metric, top, opt);
+}
+
+} // namespace qbestd
@@ -0,0 +1,240 @@
+/*********************************************************************
+ * Corpus search: every query against every reference utterance, on all
+ * cores. The work is cut into (query batch x utterance chunk) tasks run
+ * by run_tasks(); each task scores its queries against each utterance of
+ * its chunk with the query-lane kernels of search_batch() and keeps the
+ * top_k utterances per query. With pruning, each query is first searched
+ * in the top_k utterances of the task with the lowest one-box bound of
+ * prune.hpp; every other utterance is then only searched when neither
+ * that bound nor the per-block one exceeds the query's top_k-th
+ * distance. The per-task lists are merged at the end, so the result
+ * does not depend on the thread count, on scheduling or on pruning.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+#include "batch.hpp"
+#include "counters.hpp"
+#include "distance.hpp"
+#include "patterns.hpp"
+#include "prune.hpp"
+#include "scheduler.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+// Detection of a query in utterance `utterance` of the corpus.
+template <class Real>
+struct CorpusHit {
+    index_t utterance = 0;
+    Hit<Real> hit;
+};
+
+struct CorpusOptions {
+    std::size_t top_k = 10;        // hits kept per query
+    unsigned threads = 0;          // 0: one per hardware thread
+    std::size_t query_batch = 32;  // queries per task, a multiple of the lane count
+    index_t chunk_frames = 20000;  // utterance frames per task (at least one utterance)
+    Isa isa = active_isa();
+    bool prune = true;             // skip utterances by lower bound
+    index_t prune_block = 64;      // frames per box of the second bound
+};
+
+namespace detail {
+
+// Best first; equal distances keep the earlier utterance.
+template <class Real>
+bool better(const CorpusHit<Real>& a, const CorpusHit<Real>& b)
+{
+    return a.hit.dist < b.hit.dist || (a.hit.dist == b.hit.dist && a.utterance < b.utterance);
+}
+
+template <class Real>
+void keep_best(std::vector<CorpusHit<Real>>& hits, std::size_t k)
+{
+    const StageTimer timer(Stage::Merge);
+    const std::size_t n = std::min(k, hits.size());
+    std::partial_sort(hits.begin(), hits.begin() + n, hits.end(), better<Real>);
+    hits.resize(n);
+}
+
+// [first, last) ranges of consecutive utterances with at least `frames`
+// frames each (the last chunk may have fewer).
+template <class Real>
+std::vector<std::size_t> utterance_chunks(const std::vector<MatrixView<const Real>>& utterances,
+                                          index_t frames)
+{
+    std::vector<std::size_t> bounds{0};
+    index_t size = 0;
+    for (std::size_t u = 0; u < utterances.size(); ++u) {
+        size += utterances[u].cols;
+        if (size >= frames || u + 1 == utterances.size()) {
+            bounds.push_back(u + 1);
+            size = 0;
+        }
+    }
+    return bounds;
+}
+
+} // namespace detail
+
+// Top opt.top_k utterances for every query (ND x N_q each) among the
+// reference utterances (ND x M_u each), best first, in query order.
+// stats, when given, receives the pruning counts.
+template <class Pattern, class Norm = Accumulated, class Real>
+std::vector<std::vector<CorpusHit<Real>>> search_corpus(const std::vector<MatrixView<const Real>>& queries,
+                                                        const std::vector<MatrixView<const Real>>& utterances,
+                                                        Metric metric, const CorpusOptions& opt = {},
+                                                        PruneStats* stats = nullptr)
+{
+    if (stats)
+        *stats = PruneStats{};
+    std::vector<std::vector<CorpusHit<Real>>> result(queries.size());
+    if (queries.empty() || utterances.empty() || opt.top_k == 0)
+        return result;
+    const index_t dims = utterances.front().rows;
+    for (const MatrixView<const Real>& u : utterances)
+        if (u.empty() || u.rows != dims)
+            throw std::invalid_argument("search_corpus: utterances must be non-empty with equal dimensions");
+    const std::vector<detail::Frames<Real>> qry = detail::query_frames(queries, dims, metric, "search_corpus");
+
+    // Query batches of similar length, utterance chunks of similar size
+    const std::vector<std::size_t> order = detail::longest_first(qry);
+    const std::size_t batch = std::max<std::size_t>(opt.query_batch, 1);
+    const std::vector<std::size_t> chunks = detail::utterance_chunks(utterances, opt.chunk_frames);
+
+    struct Task {
+        std::size_t batch;  // first entry of order
+        std::size_t chunk;  // index into chunks
+        double cost;
+    };
+    std::vector<Task> tasks;
+    for (std::size_t b = 0; b < order.size(); b += batch) {
+        index_t qframes = 0;
+        for (std::size_t i = b; i < std::min(b + batch, order.size()); ++i)
+            qframes += qry[order[i]].count;
+        for (std::size_t c = 0; c + 1 < chunks.size(); ++c) {
+            index_t uframes = 0;
+            for (std::size_t u = chunks[c]; u < chunks[c + 1]; ++u)
+                uframes += utterances[u].cols;
+            tasks.push_back({b, c, double(qframes) * double(uframes)});
+        }
+    }
+    std::stable_sort(tasks.begin(), tasks.end(), [](const Task& a, const Task& b) { return a.cost > b.cost; });
+
+    // found[t][i]: best hits of query order[tasks[t].batch + i] in chunk t
+    std::vector<std::vector<std::vector<CorpusHit<Real>>>> found(tasks.size());
+    std::vector<PruneStats> pruned(tasks.size());
+    run_tasks(tasks.size(), opt.threads, [&](std::size_t t, unsigned) {
+        const Task& task = tasks[t];
+        const std::size_t first = chunks[task.chunk], U = chunks[task.chunk + 1] - first;
+        const std::size_t Q = std::min(task.batch + batch, order.size()) - task.batch;
+        auto query = [&](std::size_t i) -> const detail::Frames<Real>& { return qry[order[task.batch + i]]; };
+        std::vector<detail::Frames<Real>> refs;
+        refs.reserve(U);
+        for (std::size_t u = 0; u < U; ++u)
+            refs.emplace_back(utterances[first + u], metric);
+
+        // First pass: every pair without pruning, otherwise the top_k
+        // utterances of each query by the one-box bound, which fills its
+        // list with good hits before the others are tested.
+        std::vector<Real> coarse(Q * U);
+        std::vector<char> seed(Q * U, !opt.prune);
+        if (opt.prune) {
+            for (std::size_t u = 0; u < U; ++u) {
+                const detail::Envelope<Real> env(refs[u], 0);
+                for (std::size_t i = 0; i < Q; ++i)
+                    coarse[i * U + u] = detail::lower_bound<Pattern>(env, query(i));
+            }
+            std::vector<std::size_t> by_bound(U);
+            for (std::size_t i = 0; i < Q; ++i) {
+                std::iota(by_bound.begin(), by_bound.end(), std::size_t(0));
+                const std::size_t n = std::min(opt.top_k, U);
+                std::partial_sort(by_bound.begin(), by_bound.begin() + n, by_bound.end(),
+                                  [&](std::size_t a, std::size_t b) {
+                                      return coarse[i * U + a] < coarse[i * U + b]
+                                          || (!(coarse[i * U + b] < coarse[i * U + a]) && a < b);
+                                  });
+                for (std::size_t k = 0; k < n; ++k)
+                    seed[i * U + by_bound[k]] = 1;
+            }
+        }
+
+        std::vector<std::vector<CorpusHit<Real>>> best(Q);
+        std::vector<const detail::Frames<Real>*> lanes;
+        std::vector<std::size_t> lane_query;
+        std::vector<Hit<Real>> hits;
+        // Searches utterance u for the queries i with wanted(i)
+        auto search = [&](std::size_t u, auto&& wanted) {
+            lanes.clear();
+            lane_query.clear();
+            for (std::size_t i = 0; i < Q; ++i)
+                if (wanted(i)) {
+                    lanes.push_back(&query(i));
+                    lane_query.push_back(i);
+                }
+            hits.resize(lanes.size());
+            detail::search_lanes<Pattern, Norm>(refs[u], lanes, hits.data(), opt.isa);
+            for (std::size_t k = 0; k < lanes.size(); ++k) {
+                std::vector<CorpusHit<Real>>& b = best[lane_query[k]];
+                b.push_back({index_t(first + u), hits[k]});
+                if (b.size() >= opt.top_k)
+                    detail::keep_best(b, opt.top_k);
+            }
+        };
+        for (std::size_t u = 0; u < U; ++u)
+            search(u, [&](std::size_t i) { return seed[i * U + u] != 0; });
+
+        // Second pass: the remaining pairs, unless a bound already exceeds
+        // the query's top_k-th distance (its list is full by now)
+        PruneStats& count = pruned[t];
+        count.pairs = Q * U;
+        if (opt.prune)
+            for (std::size_t u = 0; u < U; ++u) {
+                std::optional<detail::Envelope<Real>> fine;
+                search(u, [&](std::size_t i) {
+                    if (seed[i * U + u])
+                        return false;
+                    const Real kth = best[i].back().hit.dist;
+                    if (coarse[i * U + u] > kth) {
+                        ++count.coarse;
+                        detail::count_pruned(refs[u].count * query(i).count);
+                        return false;
+                    }
+                    if (!fine)
+                        fine.emplace(refs[u], opt.prune_block);
+                    if (detail::lower_bound<Pattern>(*fine, query(i)) > kth) {
+                        ++count.fine;
+                        detail::count_pruned(refs[u].count * query(i).count);
+                        return false;
+                    }
+                    return true;
+                });
+            }
+        for (std::vector<CorpusHit<Real>>& b : best)
+            detail::keep_best(b, opt.top_k);
+        found[t] = std::move(best);
+    });
+    if (stats)
+        for (const PruneStats& p : pruned)
+            *stats += p;
+
+    const detail::StageTimer timer(Stage::Merge);
+    for (std::size_t t = 0; t < tasks.size(); ++t)
+        for (std::size_t i = 0; i < found[t].size(); ++i) {
+            std::vector<CorpusHit<Real>>& r = result[order[tasks[t].batch + i]];
+            r.insert(r.end(), found[t][i].begin(), found[t][i].end());
+        }
+    for (std::vector<CorpusHit<Real>>& r : result)
+        detail::keep_best(r, opt.top_k);
+    return result;
+}
+
+} // namespace qbestd
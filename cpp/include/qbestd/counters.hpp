@@ -0,0 +1,409 @@
+/*********************************************************************
+ * Search counters: distance evaluations, DP cells computed and pruned,
+ * columns abandoned by a cutoff, bytes obtained from the system
+ * allocator, wall time per stage (feature load, distance, DP, top-K
+ * merge) and, for run_tasks() workers, time in tasks against time
+ * alive. Compiled in with -DQBESTD_COUNTERS=1 (the same in every
+ * translation unit); otherwise every hook is an empty inline function
+ * and counter_snapshot() reports enabled = false.
+ *
+ * Each thread counts into its own cache-line aligned block, so the
+ * hooks never contend. Stage times are exclusive: a distance column
+ * computed inside the DP is charged to distance only. Blocks of exited
+ * threads are handed to the next new thread, so a row of the snapshot
+ * is a worker slot rather than one OS thread.
+ ********************************************************************/
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifndef QBESTD_COUNTERS
+#define QBESTD_COUNTERS 0
+#endif
+
+namespace qbestd {
+
+enum class Stage { Load, Distance, Dp, Merge };
+
+constexpr std::size_t stage_count = 4;
+
+inline const char* stage_name(Stage stage)
+{
+    switch (stage) {
+    case Stage::Load:
+        return "load";
+    case Stage::Distance:
+        return "distance";
+    case Stage::Dp:
+        return "dp";
+    case Stage::Merge:
+        return "merge";
+    }
+    return "?";
+}
+
+struct Counters {
+    std::uint64_t distances = 0;                // frame-pair distances evaluated
+    std::uint64_t cells = 0;                    // DP cells computed
+    std::uint64_t cells_pruned = 0;             // cells skipped by a bound, a band or an abandoned column
+    std::uint64_t columns_abandoned = 0;        // query columns never reached after a cutoff
+    std::uint64_t bytes_allocated = 0;          // scratch memory from the system allocator
+    std::array<double, stage_count> seconds{};  // wall time per Stage, nested stages excluded
+
+    Counters& operator+=(const Counters& o)
+    {
+        distances += o.distances;
+        cells += o.cells;
+        cells_pruned += o.cells_pruned;
+        columns_abandoned += o.columns_abandoned;
+        bytes_allocated += o.bytes_allocated;
+        for (std::size_t s = 0; s < stage_count; ++s)
+            seconds[s] += o.seconds[s];
+        return *this;
+    }
+};
+
+struct ThreadCounters {
+    std::size_t slot = 0;
+    Counters counters;
+    std::uint64_t tasks = 0;    // run_tasks() tasks run
+    double busy_seconds = 0;    // inside those tasks
+    double worker_seconds = 0;  // as a run_tasks() worker, busy or looking for work
+
+    double utilization() const { return worker_seconds > 0 ? busy_seconds / worker_seconds : 0.0; }
+};
+
+struct CounterSnapshot {
+    bool enabled = QBESTD_COUNTERS != 0;
+    Counters total;
+    std::vector<ThreadCounters> threads;  // slots that counted anything
+};
+
+namespace detail {
+
+enum class Field { Distances, Cells, Pruned, Abandoned, Bytes, Tasks, Busy, Worker, Stages };
+
+constexpr std::size_t field_count = std::size_t(Field::Stages) + stage_count;
+
+#if QBESTD_COUNTERS
+
+using counter_clock = std::chrono::steady_clock;
+
+// Only the owning thread writes, so a relaxed load and store suffice;
+// the atomics make the concurrent reads of counter_snapshot() defined.
+struct alignas(64) CounterBlock {
+    std::array<std::atomic<std::uint64_t>, field_count> value{};
+
+    void add(std::size_t field, std::uint64_t n)
+    {
+        std::atomic<std::uint64_t>& v = value[field];
+        v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+class CounterRegistry {
+public:
+    CounterBlock* acquire()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            CounterBlock* b = idle_.back();
+            idle_.pop_back();
+            return b;
+        }
+        blocks_.push_back(std::make_unique<CounterBlock>());
+        return blocks_.back().get();
+    }
+
+    void release(CounterBlock* b)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(b);
+    }
+
+    // f(slot, block) for every block, live or idle.
+    template <class F>
+    void for_each(F&& f)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (std::size_t i = 0; i < blocks_.size(); ++i)
+            f(i, *blocks_[i]);
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<CounterBlock>> blocks_;
+    std::vector<CounterBlock*> idle_;
+};
+
+inline CounterRegistry& counter_registry()
+{
+    static CounterRegistry registry;
+    return registry;
+}
+
+// The calling thread's block and the stage it is timing.
+struct CounterSlot {
+    CounterBlock* block = counter_registry().acquire();
+    int stage = -1;
+    counter_clock::time_point since;
+
+    CounterSlot() = default;
+    CounterSlot(const CounterSlot&) = delete;
+    CounterSlot& operator=(const CounterSlot&) = delete;
+    ~CounterSlot() { counter_registry().release(block); }
+
+    // Charges the time since the last switch to the current stage.
+    void switch_to(int next)
+    {
+        const counter_clock::time_point now = counter_clock::now();
+        if (stage >= 0)
+            block->add(std::size_t(Field::Stages) + std::size_t(stage), elapsed_ns(since, now));
+        stage = next;
+        since = now;
+    }
+
+    static std::uint64_t elapsed_ns(counter_clock::time_point from, counter_clock::time_point to)
+    {
+        return std::uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count());
+    }
+};
+
+inline CounterSlot& counter_slot()
+{
+    thread_local CounterSlot slot;
+    return slot;
+}
+
+inline void count(Field field, std::uint64_t n)
+{
+    counter_slot().block->add(std::size_t(field), n);
+}
+
+// Charges its lifetime to a stage, pausing the stage it interrupts.
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage) : slot_(counter_slot()), outer_(slot_.stage) { slot_.switch_to(int(stage)); }
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+    ~StageTimer() { slot_.switch_to(outer_); }
+
+private:
+    CounterSlot& slot_;
+    int outer_;
+};
+
+// Adds its lifetime to Field::Busy (one task) or Field::Worker.
+class ThreadTimer {
+public:
+    explicit ThreadTimer(Field field) : field_(field), start_(counter_clock::now()) {}
+    ThreadTimer(const ThreadTimer&) = delete;
+    ThreadTimer& operator=(const ThreadTimer&) = delete;
+    ~ThreadTimer()
+    {
+        count(field_, CounterSlot::elapsed_ns(start_, counter_clock::now()));
+        if (field_ == Field::Busy)
+            count(Field::Tasks, 1);
+    }
+
+private:
+    Field field_;
+    counter_clock::time_point start_;
+};
+
+#else
+
+inline void count(Field, std::uint64_t) {}
+
+class StageTimer {
+public:
+    explicit StageTimer(Stage) {}
+    ~StageTimer() {}
+};
+
+class ThreadTimer {
+public:
+    explicit ThreadTimer(Field) {}
+    ~ThreadTimer() {}
+};
+
+#endif // QBESTD_COUNTERS
+
+// Hooks of the engine; sizes are taken as signed index products.
+template <class I>
+void count_distances(I n)
+{
+    count(Field::Distances, std::uint64_t(n));
+}
+
+template <class I>
+void count_cells(I n)
+{
+    count(Field::Cells, std::uint64_t(n));
+}
+
+template <class I>
+void count_pruned(I n)
+{
+    count(Field::Pruned, std::uint64_t(n));
+}
+
+template <class I>
+void count_abandoned(I n)
+{
+    count(Field::Abandoned, std::uint64_t(n));
+}
+
+inline void count_allocation(std::size_t bytes)
+{
+    count(Field::Bytes, bytes);
+}
+
+inline void append(std::string& out, const char* format, ...)
+{
+    char line[256];
+    va_list args;
+    va_start(args, format);
+    const int n = std::vsnprintf(line, sizeof line, format, args);
+    va_end(args);
+    if (n > 0)
+        out.append(line, std::size_t(n) < sizeof line ? std::size_t(n) : sizeof line - 1);
+}
+
+inline void append_json(std::string& out, const Counters& c)
+{
+    append(out,
+           "{\"distances\": %llu, \"cells\": %llu, \"cells_pruned\": %llu, \"columns_abandoned\": %llu, "
+           "\"bytes_allocated\": %llu, \"seconds\": {",
+           static_cast<unsigned long long>(c.distances), static_cast<unsigned long long>(c.cells),
+           static_cast<unsigned long long>(c.cells_pruned), static_cast<unsigned long long>(c.columns_abandoned),
+           static_cast<unsigned long long>(c.bytes_allocated));
+    for (std::size_t s = 0; s < stage_count; ++s)
+        append(out, "%s\"%s\": %.9g", s ? ", " : "", stage_name(Stage(s)), c.seconds[s]);
+    out += "}}";
+}
+
+} // namespace detail
+
+// Counters of every thread so far. Safe to call while a search runs;
+// each value is then read at some point during the call.
+inline CounterSnapshot counter_snapshot()
+{
+    CounterSnapshot snap;
+#if QBESTD_COUNTERS
+    using detail::Field;
+    detail::counter_registry().for_each([&](std::size_t slot, const detail::CounterBlock& b) {
+        auto get = [&](Field f, std::size_t offset = 0) {
+            return b.value[std::size_t(f) + offset].load(std::memory_order_relaxed);
+        };
+        ThreadCounters t;
+        t.slot = slot;
+        t.counters.distances = get(Field::Distances);
+        t.counters.cells = get(Field::Cells);
+        t.counters.cells_pruned = get(Field::Pruned);
+        t.counters.columns_abandoned = get(Field::Abandoned);
+        t.counters.bytes_allocated = get(Field::Bytes);
+        for (std::size_t s = 0; s < stage_count; ++s)
+            t.counters.seconds[s] = double(get(Field::Stages, s)) * 1e-9;
+        t.tasks = get(Field::Tasks);
+        t.busy_seconds = double(get(Field::Busy)) * 1e-9;
+        t.worker_seconds = double(get(Field::Worker)) * 1e-9;
+        bool used = false;
+        for (std::size_t f = 0; f < detail::field_count; ++f)
+            used = used || b.value[f].load(std::memory_order_relaxed) != 0;
+        if (used) {
+            snap.total += t.counters;
+            snap.threads.push_back(t);
+        }
+    });
+#endif
+    return snap;
+}
+
+// Zeroes every counter. Call it while no search runs: a thread counting
+// at the same time may write back part of its old value.
+inline void reset_counters()
+{
+#if QBESTD_COUNTERS
+    detail::counter_registry().for_each([](std::size_t, detail::CounterBlock& b) {
+        for (std::atomic<std::uint64_t>& v : b.value)
+            v.store(0, std::memory_order_relaxed);
+    });
+#endif
+}
+
+// {"enabled": ..., "total": {...}, "threads": [{"slot": ..., ...}]}
+inline std::string to_json(const CounterSnapshot& snap)
+{
+    std::string out;
+    detail::append(out, "{\"enabled\": %s, \"total\": ", snap.enabled ? "true" : "false");
+    detail::append_json(out, snap.total);
+    out += ", \"threads\": [";
+    for (std::size_t i = 0; i < snap.threads.size(); ++i) {
+        const ThreadCounters& t = snap.threads[i];
+        detail::append(out,
+                       "%s{\"slot\": %zu, \"tasks\": %llu, \"busy_seconds\": %.9g, \"worker_seconds\": %.9g, "
+                       "\"utilization\": %.6g, \"counters\": ",
+                       i ? ", " : "", t.slot, static_cast<unsigned long long>(t.tasks), t.busy_seconds,
+                       t.worker_seconds, t.utilization());
+        detail::append_json(out, t.counters);
+        out += "}";
+    }
+    out += "]}\n";
+    return out;
+}
+
+// Prometheus text exposition, one series per thread slot; sum over
+// `slot` for the totals.
+inline std::string to_prometheus(const CounterSnapshot& snap)
+{
+    std::string out;
+    auto family = [&](const char* name, const char* type, const char* help, auto&& value) {
+        detail::append(out, "# HELP qbestd_%s %s\n# TYPE qbestd_%s %s\n", name, help, name, type);
+        for (const ThreadCounters& t : snap.threads)
+            value(t);
+    };
+    auto series = [&](const char* name, const char* type, const char* help, auto&& get) {
+        family(name, type, help, [&](const ThreadCounters& t) {
+            detail::append(out, "qbestd_%s{slot=\"%zu\"} %.17g\n", name, t.slot, double(get(t)));
+        });
+    };
+    detail::append(out, "# HELP qbestd_counters_enabled Whether the engine was built with QBESTD_COUNTERS.\n"
+                        "# TYPE qbestd_counters_enabled gauge\nqbestd_counters_enabled %d\n",
+                   snap.enabled ? 1 : 0);
+    series("distances_total", "counter", "Frame-pair distances evaluated.",
+           [](const ThreadCounters& t) { return t.counters.distances; });
+    series("cells_total", "counter", "DP cells computed.", [](const ThreadCounters& t) { return t.counters.cells; });
+    series("cells_pruned_total", "counter", "DP cells skipped by a bound, a band or an abandoned column.",
+           [](const ThreadCounters& t) { return t.counters.cells_pruned; });
+    series("columns_abandoned_total", "counter", "Query columns never reached after a cutoff.",
+           [](const ThreadCounters& t) { return t.counters.columns_abandoned; });
+    series("allocated_bytes_total", "counter", "Scratch memory obtained from the system allocator.",
+           [](const ThreadCounters& t) { return t.counters.bytes_allocated; });
+    family("stage_seconds_total", "counter", "Wall time per stage, nested stages excluded.",
+           [&](const ThreadCounters& t) {
+               for (std::size_t s = 0; s < stage_count; ++s)
+                   detail::append(out, "qbestd_stage_seconds_total{stage=\"%s\",slot=\"%zu\"} %.9g\n",
+                                  stage_name(Stage(s)), t.slot, t.counters.seconds[s]);
+           });
+    series("tasks_total", "counter", "run_tasks() tasks run.", [](const ThreadCounters& t) { return t.tasks; });
+    series("busy_seconds_total", "counter", "Time inside run_tasks() tasks.",
+           [](const ThreadCounters& t) { return t.busy_seconds; });
+    series("worker_seconds_total", "counter", "Time as a run_tasks() worker.",
+           [](const ThreadCounters& t) { return t.worker_seconds; });
+    series("utilization", "gauge", "Busy time over worker time.",
+           [](const ThreadCounters& t) { return t.utilization(); });
+    return out;
+}
+
+} // namespace qbestd
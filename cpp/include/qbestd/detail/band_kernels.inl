@@ -0,0 +1,125 @@
+// Banded alignments for one instruction set, included by band.hpp the
+// same way as dp_kernels.inl. The W lanes of V are W alignments of
+// `length` rows that start on consecutive rows of D: cell (m, n) of
+// alignment k+i reads D(k+i+m, n), so a lane vector is one contiguous
+// load of D and every lane runs exactly the scalar operations of its
+// own alignment. All lanes share the band, rows lo[n] .. hi[n] of
+// column n, and only those rows are computed or stored.
+
+// Alignments first .. first+W-1 with an anchored step list of at most
+// one column of look-back; requires a unit row stride of D when W > 1.
+// dist is S/T at the end row (the lowest S of the last column for an
+// open end, row length-1 for a corner end), end the 0-based end row.
+template <class V, class Norm, class Real, class... Steps>
+void band_group(StepList<Steps...>, MatrixView<const Real> D, const index_t* lo, const index_t* hi,
+                index_t width, index_t length, bool open_end, index_t first, Real* dist, index_t* end)
+{
+    using reg = typename V::reg;
+    constexpr int W = V::width;
+    constexpr std::size_t K = sizeof...(Steps);
+    constexpr index_t dm[K] = {Steps::dm...};
+    constexpr index_t dn[K] = {Steps::dn...};
+    constexpr int weight[K] = {Steps::weight...};
+    const index_t N = D.cols;
+    const reg inf = V::set1(std::numeric_limits<Real>::infinity());
+
+    // Band column n holds row m at slot m - lo[n]; the previous column
+    // is read through its own lo and hi, so no slot outside a band is
+    // ever written or read.
+    Scratch<Real> buf(std::size_t(4 * width * W));
+    Real* S_prev = buf.data();
+    Real* T_prev = S_prev + width * W;
+    Real* S_cur = T_prev + width * W;
+    Real* T_cur = S_cur + width * W;
+    index_t lo_prev = 0, hi_prev = -1;
+
+    for (index_t n = 0; n < N; ++n) {
+        const index_t lo_n = lo[n], hi_n = hi[n];
+        // Rows from which every step lands inside the band; the rows
+        // outside need the checks
+        index_t safe_lo = lo_n, safe_hi = hi_n;
+        for (std::size_t k = 0; k < K; ++k) {
+            safe_lo = std::max(safe_lo, (dn[k] ? lo_prev : lo_n) + dm[k]);
+            if (dn[k])
+                safe_hi = std::min(safe_hi, hi_prev + dm[k]);
+        }
+
+        auto cell = [&](index_t m, auto checked) {
+            constexpr bool check = decltype(checked)::value;
+            const reg d = V::load(&D(first + m, n));
+            reg cost = inf, key = inf, len = V::set1(Real(1));
+            if (check && n == 0 && m == 0) {
+                // Every path starts here: S = D, T = 1 (column 0 has no
+                // safe rows)
+                cost = d;
+            } else {
+#pragma GCC unroll 8
+                for (std::size_t k = 0; k < K; ++k) {
+                    const index_t from = m - dm[k];
+                    if constexpr (check)
+                        if (dn[k] ? from < lo_prev || from > hi_prev : from < lo_n)
+                            continue;
+                    const Real* s = dn[k] ? S_prev + (from - lo_prev) * W : S_cur + (from - lo_n) * W;
+                    const Real* t = dn[k] ? T_prev + (from - lo_prev) * W : T_cur + (from - lo_n) * W;
+                    const reg w = V::set1(Real(weight[k]));
+                    const reg c = V::add(V::load(s), weight[k] == 1 ? d : V::mul(w, d));
+                    const reg l = V::add(V::load(t), w);
+                    const reg q = Norm::by_length ? V::div(c, l) : c;
+                    if (!check && k == 0) {
+                        cost = c;
+                        len = l;
+                        key = q;
+                    } else {
+                        // A later step wins only when it is strictly better
+                        const typename V::mask better = V::lt(q, key);
+                        cost = V::blend(better, c, cost);
+                        len = V::blend(better, l, len);
+                        if constexpr (Norm::by_length)
+                            key = V::blend(better, q, key);
+                        else
+                            key = cost;
+                    }
+                }
+            }
+            V::store(S_cur + (m - lo_n) * W, cost);
+            V::store(T_cur + (m - lo_n) * W, len);
+        };
+        if (safe_lo > safe_hi) {
+            safe_lo = hi_n + 1;
+            safe_hi = hi_n;
+        }
+        for (index_t m = lo_n; m < safe_lo; ++m)
+            cell(m, std::true_type{});
+        for (index_t m = safe_lo; m <= safe_hi; ++m)
+            cell(m, std::false_type{});
+        for (index_t m = safe_hi + 1; m <= hi_n; ++m)
+            cell(m, std::true_type{});
+
+        std::swap(S_prev, S_cur);
+        std::swap(T_prev, T_cur);
+        lo_prev = lo_n;
+        hi_prev = hi_n;
+    }
+
+    // The last column is in S_prev and T_prev now
+    reg best_s = inf, best_t = V::set1(Real(1)), best_m = V::set1(Real(length - 1));
+    if (open_end) {
+        // Lowest S of the last column, first row on ties
+        for (index_t m = lo_prev; m <= hi_prev; ++m) {
+            const reg s = V::load(S_prev + (m - lo_prev) * W);
+            const typename V::mask better = V::lt(s, best_s);
+            best_s = V::blend(better, s, best_s);
+            best_t = V::blend(better, V::load(T_prev + (m - lo_prev) * W), best_t);
+            best_m = V::blend(better, V::set1(Real(m)), best_m);
+        }
+    } else if (lo_prev <= length - 1 && length - 1 <= hi_prev) {
+        best_s = V::load(S_prev + (length - 1 - lo_prev) * W);
+        best_t = V::load(T_prev + (length - 1 - lo_prev) * W);
+    }
+
+    Real ms[W];
+    V::store(dist, V::div(best_s, best_t));
+    V::store(ms, best_m);
+    for (int i = 0; i < W; ++i)
+        end[i] = index_t(ms[i]);
+}
@@ -0,0 +1,125 @@
+// Query-lane kernels for one instruction set, included by batch.hpp after
+// dp_kernels.inl in the same namespace. Lane i of every vector belongs to
+// query i of a group of V::width queries; per-lane storage is interleaved
+// as [row][lane], so each lane sees a matrix with row stride W.
+
+// d[m*W + i] = distance between reference frame m and query frame q_i,
+// where q holds the W query frames interleaved as [dim][lane]. Each lane
+// accumulates over the dimensions in order, like the scalar kernels.
+template <class V, class Real>
+void lane_distances(const Frames<Real>& ref, const Real* q, const Real* q_log, Real* d)
+{
+    constexpr int W = V::width;
+    const index_t dims = ref.dims;
+    for (index_t m = 0; m < ref.count; ++m) {
+        const Real* x = ref.frame(m);
+        typename V::reg acc = V::zero();
+        switch (ref.kind) {
+        case FrameKind::Dot:
+            for (index_t i = 0; i < dims; ++i)
+                acc = V::add(acc, V::mul(V::set1(x[i]), V::load(q + i * W)));
+            break;
+        case FrameKind::SqDiff:
+            for (index_t i = 0; i < dims; ++i) {
+                const typename V::reg e = V::sub(V::set1(x[i]), V::load(q + i * W));
+                acc = V::add(acc, V::mul(e, e));
+            }
+            break;
+        case FrameKind::Kl: {
+            const Real* lx = ref.log_frame(m);
+            for (index_t i = 0; i < dims; ++i) {
+                const typename V::reg e = V::sub(V::set1(x[i]), V::load(q + i * W));
+                const typename V::reg l = V::sub(V::set1(lx[i]), V::load(q_log + i * W));
+                acc = V::add(acc, V::mul(e, l));
+            }
+            break;
+        }
+        }
+        V::store(d + m * W, acc);
+        if (ref.kind == FrameKind::Dot)
+            for (int i = 0; i < W; ++i)
+                d[m * W + i] = neg_log(d[m * W + i]);
+    }
+}
+
+// Interior rows of column n for all lanes; S, T, P span rows*W entries
+// per column. Rows run in order, so in-column steps are fine here.
+template <class V, class Norm, class Real, class... Steps>
+void lane_column(StepList<Steps...>, index_t first_row, index_t n, const Real* d,
+                 MatrixView<Real> S, MatrixView<Real> T, MatrixView<Real> P)
+{
+    constexpr int W = V::width;
+    constexpr std::size_t K = sizeof...(Steps);
+    constexpr index_t dm[K] = {Steps::dm...};
+    constexpr index_t dn[K] = {Steps::dn...};
+    constexpr int weight[K] = {Steps::weight...};
+    const index_t M = S.rows / W, ld = S.col_stride;
+
+    index_t pred[K];
+    for (std::size_t k = 0; k < K; ++k)
+        pred[k] = (n - dn[k]) * ld - dm[k] * W;
+    const index_t out = n * ld;
+    for (index_t m = first_row; m < M; ++m) {
+        const index_t at = m * W;
+        const typename V::reg dv = V::load(d + at);
+        Lanes<V> best = lanes<V, Norm>(dv, weight[0], S.data + pred[0] + at, T.data + pred[0] + at,
+                                       P.data + pred[0] + at);
+#pragma GCC unroll 16
+        for (std::size_t k = 1; k < K; ++k)
+            select(best, lanes<V, Norm>(dv, weight[k], S.data + pred[k] + at, T.data + pred[k] + at,
+                                        P.data + pred[k] + at));
+        V::store(S.data + out + at, best.cost);
+        V::store(T.data + out + at, best.len);
+        V::store(P.data + out + at, best.start);
+    }
+}
+
+// Rolling recurrence of W queries against one reference; query i of the
+// group is qry[i] and its hit goes to hits[i].
+template <class V, class Pattern, class Norm, class Real>
+void lane_group(const Frames<Real>& ref, const Frames<Real>* const* qry, Hit<Real>* hits)
+{
+    constexpr int W = V::width;
+    const index_t M = ref.count, dims = ref.dims;
+    index_t N = 0;
+    for (int i = 0; i < W; ++i)
+        N = std::max(N, qry[i]->count);
+
+    constexpr index_t width = std::max(Pattern::steps::max_dn, Pattern::first_col) + 1;
+    ColumnWindow<Real> window(M * W, width);
+    Scratch<Real> d(std::size_t(M * W)), q(std::size_t(dims * W));
+    Scratch<Real> q_log(ref.kind == FrameKind::Kl ? q.size() : 0);
+
+    // Lane i of an interleaved matrix as a plain view.
+    auto lane = [&](MatrixView<Real> X, int i) {
+        return MatrixView<Real>{X.data + i, M, X.cols, W, X.col_stride};
+    };
+
+    for (index_t n = 0; n < N; ++n) {
+        // Lanes whose query has ended repeat its last frame; they are
+        // computed but no longer read.
+        for (int i = 0; i < W; ++i) {
+            const index_t f = std::min(n, qry[i]->count - 1);
+            for (index_t k = 0; k < dims; ++k) {
+                q[std::size_t(k * W + i)] = qry[i]->frame(f)[k];
+                if (!q_log.empty())
+                    q_log[std::size_t(k * W + i)] = qry[i]->log_frame(f)[k];
+            }
+        }
+        lane_distances<V>(ref, q.data(), q_log.data(), d.data());
+
+        window.advance(n);
+        const MatrixView<Real> S = window.S(n), T = window.T(n), P = window.P(n);
+        const index_t j = S.cols - 1;
+        for (int i = 0; i < W; ++i) {
+            const MatrixView<const Real> Di{d.data() + i, M, j + 1, W, 0};
+            init_column<Pattern, Norm>(j, Di, lane(S, i), lane(T, i), lane(P, i));
+        }
+        if (j >= Pattern::first_col)
+            lane_column<V, Norm>(typename Pattern::steps{}, Pattern::first_row, j, d.data(), S, T, P);
+
+        for (int i = 0; i < W; ++i)
+            if (n == qry[i]->count - 1)
+                hits[i] = score<Pattern>(lane(S, i), lane(T, i), lane(P, i));
+    }
+}
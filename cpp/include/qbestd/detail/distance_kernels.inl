@@ -0,0 +1,70 @@
+// Frame-distance kernels for one instruction set, included by distance.hpp
+// the same way as dp_kernels.inl. Each reduction runs over the feature
+// dimension of one reference and one query frame.
+
+template <class V, class Real>
+inline Real dot(const Real* a, const Real* b, index_t dims)
+{
+    typename V::reg acc = V::zero();
+    index_t i = 0;
+    for (; i + V::width <= dims; i += V::width)
+        acc = V::add(acc, V::mul(V::load(a + i), V::load(b + i)));
+    Real s = V::sum(acc);
+    for (; i < dims; ++i)
+        s += a[i] * b[i];
+    return s;
+}
+
+template <class V, class Real>
+inline Real sqdiff(const Real* a, const Real* b, index_t dims)
+{
+    typename V::reg acc = V::zero();
+    index_t i = 0;
+    for (; i + V::width <= dims; i += V::width) {
+        const typename V::reg d = V::sub(V::load(a + i), V::load(b + i));
+        acc = V::add(acc, V::mul(d, d));
+    }
+    Real s = V::sum(acc);
+    for (; i < dims; ++i)
+        s += (a[i] - b[i]) * (a[i] - b[i]);
+    return s;
+}
+
+// sum (x - y) (log x - log y), the symmetric KL divergence.
+template <class V, class Real>
+inline Real kl(const Real* x, const Real* lx, const Real* y, const Real* ly, index_t dims)
+{
+    typename V::reg acc = V::zero();
+    index_t i = 0;
+    for (; i + V::width <= dims; i += V::width) {
+        const typename V::reg d = V::sub(V::load(x + i), V::load(y + i));
+        const typename V::reg l = V::sub(V::load(lx + i), V::load(ly + i));
+        acc = V::add(acc, V::mul(d, l));
+    }
+    Real s = V::sum(acc);
+    for (; i < dims; ++i)
+        s += (x[i] - y[i]) * (lx[i] - ly[i]);
+    return s;
+}
+
+template <class V, class Real>
+void distance_column(const Frames<Real>& ref, const Frames<Real>& qry, index_t n, index_t first,
+                     index_t last, Real* out)
+{
+    const index_t dims = ref.dims;
+    const Real* q = qry.frame(n);
+    switch (ref.kind) {
+    case FrameKind::Dot:
+        for (index_t m = first; m < last; ++m)
+            out[m] = neg_log(dot<V>(ref.frame(m), q, dims));
+        break;
+    case FrameKind::SqDiff:
+        for (index_t m = first; m < last; ++m)
+            out[m] = sqdiff<V>(ref.frame(m), q, dims);
+        break;
+    case FrameKind::Kl:
+        for (index_t m = first; m < last; ++m)
+            out[m] = kl<V>(ref.frame(m), ref.log_frame(m), q, qry.log_frame(n), dims);
+        break;
+    }
+}
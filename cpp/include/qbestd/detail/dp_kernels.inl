@@ -0,0 +1,262 @@
+// DP kernels for one instruction set. kernels.hpp includes this file once
+// per set, inside that set's namespace and target pragma; V is the traits
+// struct of the set (simd.hpp). Both kernels produce exactly the S, T and
+// P of interior_scalar(): same operations, same tie order.
+
+template <class V>
+struct Lanes {
+    typename V::reg cost, len, key, start;
+};
+
+// Candidate of step k for W consecutive cells; d holds D of those cells
+// and S, T, P point at the predecessor of the first one.
+template <class V, class Norm, class Real>
+inline Lanes<V> lanes(typename V::reg d, int weight, const Real* S, const Real* T, const Real* P)
+{
+    const typename V::reg w = V::set1(Real(weight));
+    Lanes<V> c;
+    c.cost = V::add(V::load(S), weight == 1 ? d : V::mul(w, d));
+    c.len = V::add(V::load(T), w);
+    if constexpr (Norm::by_length)
+        c.key = V::div(c.cost, c.len);
+    else
+        c.key = c.cost;
+    c.start = V::load(P);
+    return c;
+}
+
+// Blend-based argmin: a later step only wins where it is strictly better.
+template <class V>
+inline void select(Lanes<V>& best, const Lanes<V>& c)
+{
+    const typename V::mask better = V::lt(c.key, best.key);
+    best.cost = V::blend(better, c.cost, best.cost);
+    best.len = V::blend(better, c.len, best.len);
+    best.key = V::blend(better, c.key, best.key);
+    best.start = V::blend(better, c.start, best.start);
+}
+
+// Every step advances at least one column, so column n only reads earlier
+// columns and W consecutive rows are computed at once. Requires unit row
+// stride for D, S, T, P and a common column stride for S, T, P.
+template <class V, class Norm, class Real, class... Steps>
+void columns(StepList<Steps...> steps, index_t first_row, index_t first_col,
+             MatrixView<const Real> D, MatrixView<Real> S, MatrixView<Real> T, MatrixView<Real> P)
+{
+    constexpr int W = V::width;
+    constexpr std::size_t K = sizeof...(Steps);
+    constexpr index_t dm[K] = {Steps::dm...};
+    constexpr index_t dn[K] = {Steps::dn...};
+    constexpr int weight[K] = {Steps::weight...};
+    const index_t M = D.rows, N = D.cols, ld = S.col_stride;
+
+    for (index_t n = first_col; n < N; ++n) {
+        // S.data[pred[k] + m] is S(m - dm, n - dn) of step k
+        index_t pred[K];
+        for (std::size_t k = 0; k < K; ++k)
+            pred[k] = (n - dn[k]) * ld - dm[k];
+        const Real* d_col = D.data + n * D.col_stride;
+        const index_t out = n * ld;
+
+        index_t m = first_row;
+        for (; m + W <= M; m += W) {
+            const typename V::reg d = V::load(d_col + m);
+            Lanes<V> best = lanes<V, Norm>(d, weight[0], S.data + pred[0] + m,
+                                           T.data + pred[0] + m, P.data + pred[0] + m);
+#pragma GCC unroll 16
+            for (std::size_t k = 1; k < K; ++k)
+                select(best, lanes<V, Norm>(d, weight[k], S.data + pred[k] + m,
+                                            T.data + pred[k] + m, P.data + pred[k] + m));
+            V::store(S.data + out + m, best.cost);
+            V::store(T.data + out + m, best.len);
+            V::store(P.data + out + m, best.start);
+        }
+        for (; m < M; ++m) {
+            const Candidate<Real> best = relax<Norm>(steps, m, n, D(m, n), S, T, P);
+            S(m, n) = best.cost;
+            T(m, n) = best.len;
+            P(m, n) = best.start;
+        }
+    }
+}
+
+// Steps inside the current column (dn = 0) chain the rows of a column,
+// but the cells of one anti-diagonal d = m+n never depend on each other.
+// The last reach+1 diagonals are kept in buffers indexed by n, so every
+// predecessor is a contiguous load; D is gathered along the diagonal and
+// the results are scattered back to S, T and P. Boundary cells are taken
+// from the matrices, which init_boundaries() has already filled.
+template <class V, class Norm, class Real, class... Steps>
+void wavefront(StepList<Steps...> steps, index_t first_row, index_t first_col,
+               MatrixView<const Real> D, MatrixView<Real> S, MatrixView<Real> T, MatrixView<Real> P)
+{
+    constexpr int W = V::width;
+    constexpr std::size_t K = sizeof...(Steps);
+    constexpr index_t R = StepList<Steps...>::reach + 1;
+    constexpr index_t dm[K] = {Steps::dm...};
+    constexpr index_t dn[K] = {Steps::dn...};
+    constexpr int weight[K] = {Steps::weight...};
+    const index_t M = D.rows, N = D.cols;
+    const index_t d_step = D.col_stride - D.row_stride; // (m,n) -> (m-1,n+1)
+
+    Scratch<Real> buf(std::size_t(3 * R * N));
+    auto diag = [&](index_t d, int array) { return buf.data() + ((d % R) * 3 + array) * N; };
+
+    for (index_t d = 0; d <= M + N - 2; ++d) {
+        const index_t nlo = d - M + 1 > 0 ? d - M + 1 : 0;
+        const index_t nhi = d < N - 1 ? d : N - 1;
+        Real* s_d = diag(d, 0);
+        Real* t_d = diag(d, 1);
+        Real* p_d = diag(d, 2);
+        auto copy = [&](index_t n) {
+            s_d[n] = S(d - n, n);
+            t_d[n] = T(d - n, n);
+            p_d[n] = P(d - n, n);
+        };
+        const index_t ilo = nlo > first_col ? nlo : first_col;
+        const index_t ihi = nhi < d - first_row ? nhi : d - first_row;
+        for (index_t n = nlo; n < ilo && n <= nhi; ++n)
+            copy(n);
+        for (index_t n = ihi + 1 > ilo ? ihi + 1 : ilo; n <= nhi; ++n)
+            copy(n);
+        if (ilo > ihi)
+            continue;
+
+        const Real* s_pred[K];
+        const Real* t_pred[K];
+        const Real* p_pred[K];
+        for (std::size_t k = 0; k < K; ++k) {
+            const index_t pd = d - dm[k] - dn[k];
+            s_pred[k] = diag(pd, 0) - dn[k];
+            t_pred[k] = diag(pd, 1) - dn[k];
+            p_pred[k] = diag(pd, 2) - dn[k];
+        }
+
+        index_t n = ilo;
+        for (; n + W - 1 <= ihi; n += W) {
+            const typename V::reg dv = V::gather(&D(d - n, n), d_step);
+            Lanes<V> best = lanes<V, Norm>(dv, weight[0], s_pred[0] + n, t_pred[0] + n, p_pred[0] + n);
+#pragma GCC unroll 16
+            for (std::size_t k = 1; k < K; ++k)
+                select(best, lanes<V, Norm>(dv, weight[k], s_pred[k] + n, t_pred[k] + n, p_pred[k] + n));
+            V::store(s_d + n, best.cost);
+            V::store(t_d + n, best.len);
+            V::store(p_d + n, best.start);
+            for (index_t i = n; i < n + W; ++i) {
+                S(d - i, i) = s_d[i];
+                T(d - i, i) = t_d[i];
+                P(d - i, i) = p_d[i];
+            }
+        }
+        for (; n <= ihi; ++n) {
+            const Candidate<Real> best = relax<Norm>(steps, d - n, n, D(d - n, n), S, T, P);
+            S(d - n, n) = s_d[n] = best.cost;
+            T(d - n, n) = t_d[n] = best.len;
+            P(d - n, n) = p_d[n] = best.start;
+        }
+    }
+}
+
+template <class V, class Pattern, class Norm, class Real>
+void interior(MatrixView<const Real> D, MatrixView<Real> S, MatrixView<Real> T, MatrixView<Real> P)
+{
+    using steps = typename Pattern::steps;
+    if (steps::min_dn >= 1 && D.row_stride == 1)
+        columns<V, Norm>(steps{}, Pattern::first_row, Pattern::first_col, D, S, T, P);
+    else
+        wavefront<V, Norm>(steps{}, Pattern::first_row, Pattern::first_col, D, S, T, P);
+}
+
+// Packed two-column layout (rolling.hpp): S in doubles and L = T << 32 | P
+// in 64-bit words, so the argmin moves length and start with one blend.
+template <class V>
+struct Linked {
+    typename V::reg cost, key;
+    typename V::ireg link;
+};
+
+template <class V, class Norm>
+inline Linked<V> linked(typename V::reg d, int weight, const double* S, const std::uint64_t* L)
+{
+    Linked<V> c;
+    c.cost = V::add(V::load(S), weight == 1 ? d : V::mul(V::set1(double(weight)), d));
+    c.link = V::iadd(V::iload(L), V::iset1(std::uint64_t(weight) << 32));
+    if constexpr (Norm::by_length)
+        c.key = V::div(c.cost, V::high(c.link));
+    else
+        c.key = c.cost;
+    return c;
+}
+
+// Rows first_row..M-1 of the current column (S1, L1) from the previous
+// one (S0, L0); every step must come from the previous column. Same
+// operations and tie order as columns().
+template <class V, class Norm, class... Steps>
+void packed_column(StepList<Steps...>, index_t first_row, index_t M, const double* d, const double* S0,
+                   const std::uint64_t* L0, double* S1, std::uint64_t* L1)
+{
+    static_assert(((Steps::dn == 1) && ...), "the packed layout holds one previous column");
+    constexpr std::size_t K = sizeof...(Steps);
+    constexpr index_t dm[K] = {Steps::dm...};
+    constexpr int weight[K] = {Steps::weight...};
+    auto cells = [&](auto traits, index_t m) {
+        using U = decltype(traits);
+        const typename U::reg dv = U::load(d + m);
+        Linked<U> best = linked<U, Norm>(dv, weight[0], S0 + m - dm[0], L0 + m - dm[0]);
+#pragma GCC unroll 16
+        for (std::size_t k = 1; k < K; ++k) {
+            const Linked<U> c = linked<U, Norm>(dv, weight[k], S0 + m - dm[k], L0 + m - dm[k]);
+            const typename U::mask better = U::lt(c.key, best.key);
+            best.cost = U::blend(better, c.cost, best.cost);
+            best.key = U::blend(better, c.key, best.key);
+            best.link = U::iblend(better, c.link, best.link);
+        }
+        U::store(S1 + m, best.cost);
+        U::istore(L1 + m, best.link);
+    };
+    index_t m = first_row;
+    for (; m + V::width <= M; m += V::width)
+        cells(V{}, m);
+    for (; m < M; ++m)
+        cells(Scalar<double>{}, m);
+}
+
+// Code of the step select() keeps for rows first_row..M-1 of a column,
+// recomputing only the keys: s[k] and t[k] point at S and T of the
+// predecessor of row 0 under step k, whose code is step_code[k] (path.hpp).
+template <class V, class Norm, class Real, class... Steps>
+void winning_steps(StepList<Steps...>, const unsigned char* step_code, index_t first_row, index_t M,
+                   const Real* d, const Real* const* s, const Real* const* t, unsigned char* codes)
+{
+    constexpr std::size_t K = sizeof...(Steps);
+    constexpr int weight[K] = {Steps::weight...};
+    auto cells = [&](auto traits, index_t m) {
+        using U = decltype(traits);
+        const typename U::reg dv = U::load(d + m);
+        auto key = [&](std::size_t k) {
+            const typename U::reg w = U::set1(Real(weight[k]));
+            const typename U::reg cost = U::add(U::load(s[k] + m), weight[k] == 1 ? dv : U::mul(w, dv));
+            if constexpr (Norm::by_length)
+                return U::div(cost, U::add(U::load(t[k] + m), w));
+            else
+                return cost;
+        };
+        typename U::reg best = key(0), code = U::set1(Real(step_code[0]));
+#pragma GCC unroll 16
+        for (std::size_t k = 1; k < K; ++k) {
+            const typename U::reg c = key(k);
+            const typename U::mask better = U::lt(c, best);
+            best = U::blend(better, c, best);
+            code = U::blend(better, U::set1(Real(step_code[k])), code);
+        }
+        Real out[U::width];
+        U::store(out, code);
+        for (int i = 0; i < U::width; ++i)
+            codes[m + i] = (unsigned char)out[i];
+    };
+    index_t m = first_row;
+    for (; m + V::width <= M; m += V::width)
+        cells(V{}, m);
+    for (; m < M; ++m)
+        cells(Scalar<Real>{}, m);
+}
@@ -0,0 +1,153 @@
+// Blocked distance-matrix product for one instruction set, included by
+// distance_matrix.hpp the same way as dp_kernels.inl. V is the traits
+// struct of the set (simd.hpp); Scalar<Real> gives the portable build.
+
+// Natural log for positive normal x (Cephes log: log(1+f) with a 5/5
+// rational approximation on sqrt(1/2) <= 1+f < sqrt(2)), about 1 ulp.
+template <class V>
+inline typename V::reg vlog(typename V::reg x)
+{
+    using reg = typename V::reg;
+    static constexpr double P[] = {1.01875663804580931796E-4, 4.97494994976747001425E-1,
+                                   4.70579119878881725854E0,  1.44989225341610930846E1,
+                                   1.79368678507819816313E1,  7.70838733755885391666E0};
+    static constexpr double Q[] = {1.12873587189167450590E1, 4.52279145837532221105E1,
+                                   8.29875266912776603211E1, 7.11544750618563894466E1,
+                                   2.31251620126765340583E1};
+    reg e;
+    reg f = V::frexp(x, e);
+    const typename V::mask low = V::lt(f, V::set1(0.70710678118654752440));
+    f = V::sub(V::add(f, V::blend(low, f, V::zero())), V::set1(1.0));
+    e = V::sub(e, V::blend(low, V::set1(1.0), V::zero()));
+
+    const reg z = V::mul(f, f);
+    reg p = V::set1(P[0]);
+    for (int i = 1; i < 6; ++i)
+        p = V::add(V::mul(p, f), V::set1(P[i]));
+    reg q = V::add(f, V::set1(Q[0]));
+    for (int i = 1; i < 5; ++i)
+        q = V::add(V::mul(q, f), V::set1(Q[i]));
+    reg y = V::mul(f, V::div(V::mul(z, p), q));
+    y = V::sub(y, V::mul(e, V::set1(2.121944400546905827679E-4)));
+    y = V::sub(y, V::mul(z, V::set1(0.5)));
+    return V::add(V::add(f, y), V::mul(e, V::set1(0.693359375)));
+}
+
+// Register tile: MR = 2 vectors of reference frames by NR query frames.
+template <class V>
+struct Tile {
+    static constexpr int MR = 2 * V::width;
+    static constexpr int NR = 4;
+    typename V::reg acc[2][NR];
+};
+
+// acc += A_panel' * B_panel over kc products; a is packed as [k][MR],
+// b as [k][NR].
+template <class V, class Real>
+inline void multiply(Tile<V>& t, index_t kc, const Real* a, const Real* b)
+{
+    constexpr int W = V::width, NR = Tile<V>::NR;
+    for (index_t k = 0; k < kc; ++k) {
+        const typename V::reg a0 = V::load(a + k * 2 * W);
+        const typename V::reg a1 = V::load(a + k * 2 * W + W);
+#pragma GCC unroll 4
+        for (int j = 0; j < NR; ++j) {
+            const typename V::reg bj = V::set1(b[k * NR + j]);
+            t.acc[0][j] = V::add(t.acc[0][j], V::mul(a0, bj));
+            t.acc[1][j] = V::add(t.acc[1][j], V::mul(a1, bj));
+        }
+    }
+}
+
+// Turns finished products into distances; row_bias is padded to MR.
+template <class V, class Real>
+inline void finish(Tile<V>& t, const Product<Real>& op, const Real* row_bias, const Real* col_bias)
+{
+    constexpr int W = V::width, NR = Tile<V>::NR;
+    for (int h = 0; h < 2; ++h)
+        for (int j = 0; j < NR; ++j) {
+            typename V::reg& c = t.acc[h][j];
+            if (op.kind == FrameKind::Dot) {
+                c = V::max(c, V::set1(std::numeric_limits<Real>::min()));
+                c = V::sub(V::zero(), vlog<V>(c));
+            } else {
+                const typename V::reg bias =
+                    V::add(V::load(row_bias + h * W), V::set1(col_bias[j]));
+                c = V::max(V::add(bias, V::mul(V::set1(op.scale), c)), V::zero());
+            }
+        }
+}
+
+template <class V, class Real>
+void product(const Product<Real>& op, MatrixView<Real> D)
+{
+    constexpr int W = V::width, MR = Tile<V>::MR, NR = Tile<V>::NR;
+    constexpr index_t KC = 256, MC = 128; // packed A block: 256 KB of doubles
+    const index_t K = op.depth, M = op.rows, N = op.cols;
+    const index_t n_panels = (N + NR - 1) / NR;
+    Scratch<Real> apack(std::size_t(KC * MC)), bpack(std::size_t(KC * NR * n_panels));
+    Scratch<Real> rbias(std::size_t(MC), Real(0)), cbias(std::size_t(n_panels * NR), Real(0));
+    if (op.kind != FrameKind::Dot)
+        std::copy(op.col_bias.begin(), op.col_bias.end(), cbias.begin());
+    alignas(64) Real out[MR * NR] = {};
+
+    for (index_t k0 = 0; k0 < K; k0 += KC) {
+        const index_t kc = std::min(KC, K - k0);
+        const bool first = k0 == 0, last = k0 + kc == K;
+
+        for (index_t p = 0; p < n_panels; ++p)
+            for (index_t k = 0; k < kc; ++k)
+                for (int j = 0; j < NR; ++j) {
+                    const index_t n = p * NR + j;
+                    bpack[std::size_t((p * kc + k) * NR + j)] =
+                        n < N ? op.b[std::size_t(n * K + k0 + k)] : Real(0);
+                }
+
+        for (index_t m0 = 0; m0 < M; m0 += MC) {
+            const index_t mc = std::min(MC, M - m0);
+            const index_t m_panels = (mc + MR - 1) / MR;
+            for (index_t i = 0; i < m_panels; ++i)
+                for (index_t k = 0; k < kc; ++k)
+                    for (int r = 0; r < MR; ++r) {
+                        const index_t m = m0 + i * MR + r;
+                        apack[std::size_t((i * kc + k) * MR + r)] =
+                            m < M ? op.a[std::size_t(m * K + k0 + k)] : Real(0);
+                    }
+            if (last && op.kind != FrameKind::Dot)
+                for (index_t r = 0; r < m_panels * MR; ++r)
+                    rbias[std::size_t(r)] = m0 + r < M ? op.row_bias[std::size_t(m0 + r)] : Real(0);
+
+            for (index_t p = 0; p < n_panels; ++p)
+                for (index_t i = 0; i < m_panels; ++i) {
+                    const index_t mb = m0 + i * MR, nb = p * NR;
+                    const index_t rows = std::min<index_t>(MR, M - mb);
+                    const index_t cols = std::min<index_t>(NR, N - nb);
+                    Tile<V> t;
+                    for (int j = 0; j < NR; ++j) {
+                        t.acc[0][j] = V::zero();
+                        t.acc[1][j] = V::zero();
+                    }
+                    multiply(t, kc, apack.data() + i * kc * MR, bpack.data() + p * kc * NR);
+                    if (!first) {
+                        // Partial products of earlier k blocks are parked in D.
+                        for (int j = 0; j < cols; ++j)
+                            for (int r = 0; r < rows; ++r)
+                                out[j * MR + r] = D(mb + r, nb + j);
+                        for (int j = 0; j < NR; ++j) {
+                            t.acc[0][j] = V::add(t.acc[0][j], V::load(out + j * MR));
+                            t.acc[1][j] = V::add(t.acc[1][j], V::load(out + j * MR + W));
+                        }
+                    }
+                    if (last)
+                        finish(t, op, rbias.data() + i * MR, cbias.data() + nb);
+                    for (int j = 0; j < NR; ++j) {
+                        V::store(out + j * MR, t.acc[0][j]);
+                        V::store(out + j * MR + W, t.acc[1][j]);
+                    }
+                    for (int j = 0; j < cols; ++j)
+                        for (int r = 0; r < rows; ++r)
+                            D(mb + r, nb + j) = out[j * MR + r];
+                }
+        }
+    }
+}
@@ -0,0 +1,150 @@
+// Frame-lane kernels of the MFCC front end for one instruction set,
+// included by mfcc.hpp. Lane i of every vector belongs to frame i of a
+// group of V::width frames; per-lane buffers are interleaved as
+// [bin][lane], so every butterfly, filter and DCT row is a handful of
+// vector operations on whole groups.
+
+// Log-mel energies in dB (not yet clipped) of the frames x[0..count),
+// n_fft windowed samples each, into db[f * n_mels ..]; count <= W, the
+// spare lanes run on zeros.
+template <class V, class Real>
+void log_mel_group(const MfccPlan<Real>& plan, const Real* const* x, int count, Real* work, Real* db)
+{
+    using reg = typename V::reg;
+    constexpr int W = V::width;
+    const index_t h = plan.n_fft / 2;
+    Real* re = work;
+    Real* im = re + h * W;
+    Real* power = im + h * W;  // h + 1 bins
+    Real* mel = power + (h + 1) * W;
+
+    // Even and odd samples as the real and imaginary parts of one
+    // sequence of n_fft / 2 points, stored in bit-reversed order
+    for (index_t t = 0; t < h; ++t) {
+        const index_t r = plan.bitrev[std::size_t(t)] * W;
+        const Real w0 = plan.window[std::size_t(2 * t)], w1 = plan.window[std::size_t(2 * t + 1)];
+        for (int i = 0; i < W; ++i) {
+            re[r + i] = i < count ? w0 * x[i][2 * t] : Real(0);
+            im[r + i] = i < count ? w1 * x[i][2 * t + 1] : Real(0);
+        }
+    }
+
+    // Radix-2 butterflies, one twiddle per pass over the blocks
+    for (index_t size = 2; size <= h; size *= 2) {
+        const index_t half = size / 2, step = h / size;
+        for (index_t j = 0; j < half; ++j) {
+            const reg c = V::set1(plan.twiddle_cos[std::size_t(j * step)]);
+            const reg s = V::set1(plan.twiddle_sin[std::size_t(j * step)]);
+            for (index_t start = j; start < h; start += size) {
+                Real* ar = re + start * W;
+                Real* ai = im + start * W;
+                Real* br = ar + half * W;
+                Real* bi = ai + half * W;
+                const reg ur = V::load(br), ui = V::load(bi);
+                const reg tr = V::add(V::mul(c, ur), V::mul(s, ui));
+                const reg ti = V::sub(V::mul(c, ui), V::mul(s, ur));
+                const reg xr = V::load(ar), xi = V::load(ai);
+                V::store(br, V::sub(xr, tr));
+                V::store(bi, V::sub(xi, ti));
+                V::store(ar, V::add(xr, tr));
+                V::store(ai, V::add(xi, ti));
+            }
+        }
+    }
+
+    // Spectrum of the real frame from that of the packed sequence Z:
+    // X[k] = E[k] + e^(-2 pi i k / n_fft) O[k] with
+    // E = (Z[k] + conj Z[h-k]) / 2 and O = (Z[k] - conj Z[h-k]) / 2i
+    const reg one_half = V::set1(Real(0.5));
+    for (index_t k = 0; k <= h; ++k) {
+        const index_t a = (k % h) * W, b = ((h - k) % h) * W;
+        const reg zr = V::load(re + a), zi = V::load(im + a), yr = V::load(re + b), yi = V::load(im + b);
+        const reg er = V::mul(one_half, V::add(zr, yr)), ei = V::mul(one_half, V::sub(zi, yi));
+        const reg or_ = V::mul(one_half, V::add(zi, yi)), oi = V::mul(one_half, V::sub(yr, zr));
+        const reg c = V::set1(plan.post_cos[std::size_t(k)]), s = V::set1(plan.post_sin[std::size_t(k)]);
+        const reg xr = V::add(er, V::add(V::mul(c, or_), V::mul(s, oi)));
+        const reg xi = V::add(ei, V::sub(V::mul(c, oi), V::mul(s, or_)));
+        V::store(power + k * W, V::add(V::mul(xr, xr), V::mul(xi, xi)));
+    }
+
+    for (index_t m = 0; m < plan.n_mels; ++m) {
+        const MelBand& band = plan.bands[std::size_t(m)];
+        const Real* w = plan.mel_weights.data() + band.offset;
+        reg acc = V::zero();
+        for (index_t k = 0; k < band.count; ++k)
+            acc = V::add(acc, V::mul(V::set1(w[k]), V::load(power + (band.first + k) * W)));
+        V::store(mel + m * W, acc);
+    }
+    for (int i = 0; i < count; ++i)
+        for (index_t m = 0; m < plan.n_mels; ++m)
+            db[i * plan.n_mels + m] = Real(10) * std::log10(std::max(mel[m * W + i], Real(1e-10)));
+}
+
+// Coefficients of the frames db[0..count) (n_mels values each, raised
+// to at least `floor`) into out[f * n_mfcc ..], normalized per frame
+// when the plan says so; count <= W.
+template <class V, class Real>
+void cepstra_group(const MfccPlan<Real>& plan, const Real* db, int count, Real floor, Real* work, Real* out)
+{
+    using reg = typename V::reg;
+    constexpr int W = V::width;
+    const index_t n_mels = plan.n_mels, n_mfcc = plan.n_mfcc;
+    Real* in = work;
+    Real* c = in + n_mels * W;
+    for (index_t m = 0; m < n_mels; ++m)
+        for (int i = 0; i < W; ++i)
+            in[m * W + i] = i < count ? std::max(db[i * n_mels + m], floor) : Real(0);
+
+    for (index_t k = 0; k < n_mfcc; ++k) {
+        const Real* row = plan.dct.data() + k * n_mels;
+        reg acc = V::zero();
+        for (index_t m = 0; m < n_mels; ++m)
+            acc = V::add(acc, V::mul(V::set1(row[m]), V::load(in + m * W)));
+        V::store(c + k * W, acc);
+    }
+
+    if (plan.normalize) {
+        // Mean 0 and standard deviation 1 over the coefficients of a frame
+        const reg scale = V::set1(Real(1) / Real(n_mfcc));
+        reg mean = V::zero();
+        for (index_t k = 0; k < n_mfcc; ++k)
+            mean = V::add(mean, V::load(c + k * W));
+        mean = V::mul(mean, scale);
+        reg var = V::zero();
+        for (index_t k = 0; k < n_mfcc; ++k) {
+            const reg e = V::sub(V::load(c + k * W), mean);
+            var = V::add(var, V::mul(e, e));
+        }
+        Real inv[W];
+        V::store(inv, V::mul(var, scale));
+        for (int i = 0; i < W; ++i)
+            inv[i] = inv[i] > 0 ? Real(1) / std::sqrt(inv[i]) : Real(1);
+        const reg r = V::load(inv);
+        for (index_t k = 0; k < n_mfcc; ++k)
+            V::store(c + k * W, V::mul(V::sub(V::load(c + k * W), mean), r));
+    }
+    for (int i = 0; i < count; ++i)
+        for (index_t k = 0; k < n_mfcc; ++k)
+            out[i * n_mfcc + k] = c[k * W + i];
+}
+
+// Both stages over any number of frames, in groups of W.
+template <class V, class Real>
+void log_mel(const MfccPlan<Real>& plan, const Real* const* x, index_t count, Real* db)
+{
+    constexpr int W = V::width;
+    const index_t h = plan.n_fft / 2;
+    Scratch<Real> work(std::size_t((3 * h + 1 + plan.n_mels) * W));
+    for (index_t f = 0; f < count; f += W)
+        log_mel_group<V>(plan, x + f, int(std::min<index_t>(W, count - f)), work.data(), db + f * plan.n_mels);
+}
+
+template <class V, class Real>
+void cepstra(const MfccPlan<Real>& plan, const Real* db, index_t count, Real floor, Real* out)
+{
+    constexpr int W = V::width;
+    Scratch<Real> work(std::size_t((plan.n_mels + plan.n_mfcc) * W));
+    for (index_t f = 0; f < count; f += W)
+        cepstra_group<V>(plan, db + f * plan.n_mels, int(std::min<index_t>(W, count - f)), floor, work.data(),
+                         out + f * plan.n_mfcc);
+}
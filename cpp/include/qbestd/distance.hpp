@@ -0,0 +1,231 @@
+/*********************************************************************
+ * Local distances of Fx_do_SDTW.m between reference and query feature
+ * matrices (ND x Nframes, one frame per column):
+ *   's'  squared Euclidean            sum (x - y)^2
+ *   'i'  inner product                -log(x . y)
+ *   'in' inner product of x/|x|^2     -log(x . y) after that scaling
+ *   'k'  symmetric KL divergence      sum (x - y)(log x - log y)
+ *   'b'  Bhattacharyya                -log(sum sqrt(x y))
+ * FrameDistance prepares both sides once (scaling, sqrt, log) and then
+ * produces D one query frame at a time, so the N1 x N2 matrix is never
+ * needed. Logs are clamped at the smallest normal number, which keeps
+ * zero posteriors and non-positive products finite.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "counters.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+enum class Metric {
+    SqEuclidean,       // 's'
+    InnerProduct,      // 'i'
+    NormInnerProduct,  // 'in'
+    SymmetricKL,       // 'k'
+    Bhattacharyya      // 'b'
+};
+
+// Type_localdist code of Fx_do_SDTW.m.
+inline Metric parse_metric(const std::string& type)
+{
+    if (type == "s")
+        return Metric::SqEuclidean;
+    if (type == "i")
+        return Metric::InnerProduct;
+    if (type == "in")
+        return Metric::NormInnerProduct;
+    if (type == "k")
+        return Metric::SymmetricKL;
+    if (type == "b")
+        return Metric::Bhattacharyya;
+    throw std::invalid_argument("distance: unknown local distance type '" + type + "'");
+}
+
+namespace detail {
+
+// Every metric reduces to one of three per-frame kernels.
+enum class FrameKind { Dot, SqDiff, Kl };
+
+inline FrameKind frame_kind(Metric metric)
+{
+    switch (metric) {
+    case Metric::SqEuclidean: return FrameKind::SqDiff;
+    case Metric::SymmetricKL: return FrameKind::Kl;
+    default: return FrameKind::Dot;
+    }
+}
+
+template <class Real>
+inline Real clamped_log(Real x)
+{
+    return std::log(std::max(x, std::numeric_limits<Real>::min()));
+}
+
+template <class Real>
+inline Real neg_log(Real x)
+{
+    return -clamped_log(x);
+}
+
+// Frames of one side, transformed for the metric and stored contiguously
+// (frame f at data[f*dims]); logs holds log x for the KL kernel.
+template <class Real>
+struct Frames {
+    FrameKind kind = FrameKind::Dot;
+    index_t dims = 0;
+    index_t count = 0;
+    Scratch<Real> data;
+    Scratch<Real> logs;
+
+    Frames(MatrixView<const Real> X, Metric metric)
+        : kind(frame_kind(metric)), dims(X.rows), count(X.cols),
+          data(std::size_t(X.rows * X.cols))
+    {
+        const StageTimer load(Stage::Load);
+        for (index_t f = 0; f < count; ++f) {
+            Real* x = data.data() + f * dims;
+            Real energy = 0;
+            for (index_t i = 0; i < dims; ++i) {
+                x[i] = X(i, f);
+                energy += x[i] * x[i];
+            }
+            if (metric == Metric::NormInnerProduct)
+                for (index_t i = 0; i < dims; ++i)
+                    x[i] /= energy;
+            else if (metric == Metric::Bhattacharyya)
+                for (index_t i = 0; i < dims; ++i)
+                    x[i] = std::sqrt(x[i]);
+        }
+        if (kind == FrameKind::Kl) {
+            logs = Scratch<Real>(data.size());
+            for (std::size_t i = 0; i < data.size(); ++i)
+                logs[i] = clamped_log(data[i]);
+        }
+    }
+
+    const Real* frame(index_t f) const { return data.data() + f * dims; }
+    const Real* log_frame(index_t f) const { return logs.data() + f * dims; }
+};
+
+namespace scalar {
+#include "detail/distance_kernels.inl"
+} // namespace scalar
+
+} // namespace detail
+
+#if QBESTD_X86_SIMD
+
+QBESTD_PUSH_TARGET_AVX2
+namespace detail::avx2 {
+#include "detail/distance_kernels.inl"
+} // namespace detail::avx2
+QBESTD_POP_TARGET
+
+QBESTD_PUSH_TARGET_AVX512
+namespace detail::avx512 {
+#include "detail/distance_kernels.inl"
+} // namespace detail::avx512
+QBESTD_POP_TARGET
+
+#endif // QBESTD_X86_SIMD
+
+namespace detail {
+
+// out[m] = distance between frame m of a and frame n of b, for the rows
+// m in [first, last) (default: all frames of a).
+template <class Real>
+void distance_column(Isa isa, const Frames<Real>& a, const Frames<Real>& b, index_t n, Real* out,
+                     index_t first = 0, index_t last = -1)
+{
+    if (last < 0)
+        last = a.count;
+    const StageTimer timer(Stage::Distance);
+    count_distances(last - first);
+#if QBESTD_X86_SIMD
+    if constexpr (detail::simd_real<Real>) {
+        if (isa == Isa::Avx512)
+            return avx512::distance_column<Avx512<Real>>(a, b, n, first, last, out);
+        if (isa == Isa::Avx2)
+            return avx2::distance_column<Avx2<Real>>(a, b, n, first, last, out);
+    }
+#endif
+    (void)isa;
+    scalar::distance_column<Scalar<Real>>(a, b, n, first, last, out);
+}
+
+// Largest squared norm of the transformed frames.
+template <class Real>
+Real max_energy(const Frames<Real>& X)
+{
+    Real e = 0;
+    for (index_t f = 0; f < X.count; ++f) {
+        Real s = 0;
+        for (index_t i = 0; i < X.dims; ++i)
+            s += X.frame(f)[i] * X.frame(f)[i];
+        e = std::max(e, s);
+    }
+    return e;
+}
+
+} // namespace detail
+
+// D(m, n) = distance between reference frame m and query frame n.
+template <class Real>
+class FrameDistance {
+public:
+    using value_type = Real;
+
+    FrameDistance(MatrixView<const Real> ref, MatrixView<const Real> qry, Metric metric)
+        : ref_(ref, metric), qry_(qry, metric)
+    {
+        if (ref.empty() || qry.empty())
+            throw std::invalid_argument("distance: empty feature matrix");
+        if (ref.rows != qry.rows)
+            throw std::invalid_argument("distance: reference and query dimensions differ");
+    }
+
+    index_t rows() const { return ref_.count; }
+    index_t cols() const { return qry_.count; }
+
+    // Column n of D into out[0 .. rows()).
+    void column(index_t n, Real* out, Isa isa = active_isa()) const
+    {
+        detail::distance_column(isa, ref_, qry_, n, out);
+    }
+
+    // Entries first..last-1 of column n into out[first .. last).
+    void column_rows(index_t n, index_t first, index_t last, Real* out, Isa isa = active_isa()) const
+    {
+        detail::distance_column(isa, ref_, qry_, n, out, first, last);
+    }
+
+    // Prepared frames of the reference (rows) and the query (columns).
+    const detail::Frames<Real>& reference() const { return ref_; }
+    const detail::Frames<Real>& query() const { return qry_; }
+
+    // True when no entry of D is negative: always for 's' and 'k', and
+    // for -log(x . y) when no two frames have norms multiplying past 1
+    // (posteriors, for instance).
+    bool nonnegative() const
+    {
+        if (ref_.kind != detail::FrameKind::Dot)
+            return true;
+        return detail::max_energy(ref_) * detail::max_energy(qry_) <= Real(1);
+    }
+
+private:
+    detail::Frames<Real> ref_, qry_;
+};
+
+} // namespace qbestd
@@ -0,0 +1,149 @@
+/*********************************************************************
+ * Whole N1 x N2 local distance matrix for Fx_do_SDTW.m as one blocked
+ * matrix product over the feature dimension, with the norm terms and
+ * the clamped -log folded into the store of each register tile:
+ *   's'            |x|^2 + |y|^2 - 2 x.y
+ *   'i', 'in', 'b' -log(x.y) on the scaled / square-rooted frames
+ *   'k'            x.log x + y.log y - (x.log y + log x.y), one product
+ *                  over the stacked frames [x; log x] and [log y; y]
+ * The micro-kernel is built on the traits of simd.hpp, so no BLAS is
+ * needed; the same code compiles for AVX2, AVX-512 and plain scalar.
+ * Rounding can differ from the per-column FrameDistance in the last
+ * bits, and 's' and 'k' are clamped at zero.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "counters.hpp"
+#include "distance.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+namespace detail {
+
+// D(m, n) = row_bias[m] + col_bias[n] + scale * a_m . b_n for SqDiff and
+// Kl, -log(a_m . b_n) for Dot; a and b hold one frame per depth values.
+template <class Real>
+struct Product {
+    FrameKind kind;
+    index_t depth, rows, cols;
+    Real scale = Real(1);
+    Scratch<Real> a, b, row_bias, col_bias;
+
+    Product(Frames<Real>&& ref, Frames<Real>&& qry)
+        : kind(ref.kind), depth(ref.dims), rows(ref.count), cols(qry.count)
+    {
+        if (kind == FrameKind::Kl) {
+            depth = 2 * ref.dims;
+            scale = Real(-1);
+            a = stack(ref, ref.data, ref.logs);
+            b = stack(qry, qry.logs, qry.data);
+            row_bias = self_products(ref, ref.logs);
+            col_bias = self_products(qry, qry.logs);
+        } else {
+            if (kind == FrameKind::SqDiff) {
+                scale = Real(-2);
+                row_bias = self_products(ref, ref.data);
+                col_bias = self_products(qry, qry.data);
+            }
+            a = std::move(ref.data);
+            b = std::move(qry.data);
+        }
+    }
+
+private:
+    // Frame f of the result is frame f of first followed by that of second.
+    static Scratch<Real> stack(const Frames<Real>& x, const Scratch<Real>& first, const Scratch<Real>& second)
+    {
+        Scratch<Real> out(std::size_t(2 * x.dims * x.count));
+        for (index_t f = 0; f < x.count; ++f) {
+            std::copy_n(first.data() + f * x.dims, x.dims, out.data() + 2 * f * x.dims);
+            std::copy_n(second.data() + f * x.dims, x.dims, out.data() + (2 * f + 1) * x.dims);
+        }
+        return out;
+    }
+
+    // x_f . w_f for every frame f.
+    static Scratch<Real> self_products(const Frames<Real>& x, const Scratch<Real>& w)
+    {
+        Scratch<Real> out(std::size_t(x.count));
+        for (index_t f = 0; f < x.count; ++f) {
+            Real s = 0;
+            for (index_t i = 0; i < x.dims; ++i)
+                s += x.data[std::size_t(f * x.dims + i)] * w[std::size_t(f * x.dims + i)];
+            out[std::size_t(f)] = s;
+        }
+        return out;
+    }
+};
+
+namespace scalar {
+#include "detail/gemm_kernels.inl"
+} // namespace scalar
+
+} // namespace detail
+
+#if QBESTD_X86_SIMD
+
+QBESTD_PUSH_TARGET_AVX2
+namespace detail::avx2 {
+#include "detail/gemm_kernels.inl"
+} // namespace detail::avx2
+QBESTD_POP_TARGET
+
+QBESTD_PUSH_TARGET_AVX512
+namespace detail::avx512 {
+#include "detail/gemm_kernels.inl"
+} // namespace detail::avx512
+QBESTD_POP_TARGET
+
+#endif // QBESTD_X86_SIMD
+
+// Fills D (N1 x N2) with the distances between the frames of ref (ND x
+// N1) and qry (ND x N2).
+template <class Real>
+void distance_matrix(MatrixView<const Real> ref, MatrixView<const Real> qry, Metric metric,
+                     MatrixView<Real> D, Isa isa = active_isa())
+{
+    if (ref.empty() || qry.empty())
+        throw std::invalid_argument("distance: empty feature matrix");
+    if (ref.rows != qry.rows)
+        throw std::invalid_argument("distance: reference and query dimensions differ");
+    if (D.data == nullptr || D.rows != ref.cols || D.cols != qry.cols)
+        throw std::invalid_argument("distance: D must be N1 x N2");
+
+    const detail::StageTimer timer(Stage::Distance);
+    detail::count_distances(D.rows * D.cols);
+    const detail::Product<Real> op(detail::Frames<Real>(ref, metric),
+                                   detail::Frames<Real>(qry, metric));
+#if QBESTD_X86_SIMD
+    if constexpr (detail::simd_real<Real>) {
+        if (isa == Isa::Avx512)
+            return detail::avx512::product<Avx512<Real>>(op, D);
+        if (isa == Isa::Avx2)
+            return detail::avx2::product<Avx2<Real>>(op, D);
+    }
+#endif
+    (void)isa;
+    detail::scalar::product<Scalar<Real>>(op, D);
+}
+
+// Convenience form returning D column-major.
+template <class Real>
+std::vector<Real> distance_matrix(MatrixView<const Real> ref, MatrixView<const Real> qry,
+                                  Metric metric, Isa isa = active_isa())
+{
+    std::vector<Real> D(std::size_t(ref.cols * qry.cols));
+    distance_matrix(ref, qry, metric, column_major(D.data(), ref.cols, qry.cols), isa);
+    return D;
+}
+
+} // namespace qbestd
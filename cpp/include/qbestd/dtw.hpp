@@ -0,0 +1,199 @@
+/*********************************************************************
+ * Accumulated-cost recurrence shared by every kernel in matlab/.
+ *
+ * dtw<Pattern, Norm>(D, S, T, P) fills the accumulated cost S, the path
+ * length T and the 0-based start row P of an M x N local distance matrix
+ * D and returns the best hit of the last column, S/T at the end row.
+ * All matrices are caller-owned strided views; nothing is allocated
+ * except the diagonal buffers of the wavefront kernel (kernels.hpp).
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "counters.hpp"
+#include "kernels.hpp"
+#include "patterns.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "steps.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+namespace detail {
+
+template <class Real>
+void check_shape(MatrixView<const Real> D, MatrixView<Real> X, const char* what)
+{
+    if (X.data == nullptr || X.rows != D.rows || X.cols != D.cols)
+        throw std::invalid_argument(std::string("dtw: ") + what + " does not match D");
+}
+
+// Lowest S of the last column; the first row wins ties (find_min_value_ind).
+template <class Real>
+index_t argmin_last_column(MatrixView<Real> S)
+{
+    const index_t n = S.cols - 1;
+    index_t best = 0;
+    for (index_t m = 1; m < S.rows; ++m)
+        if (S(m, n) < S(best, n))
+            best = m;
+    return best;
+}
+
+template <class Real>
+void check_outputs(MatrixView<const Real> D, MatrixView<Real> S, MatrixView<Real> T,
+                   MatrixView<Real> P)
+{
+    if (D.empty())
+        throw std::invalid_argument("dtw: empty distance matrix");
+    check_shape(D, S, "S");
+    check_shape(D, T, "T");
+    check_shape(D, P, "P");
+}
+
+// Boundary cells of column n: the whole first column, otherwise the first
+// row(s) and, below first_col, the pattern-specific boundary column. Only
+// columns up to n are read, so this also runs on a column window.
+template <class Pattern, class Norm, class Real>
+void init_column(index_t n, MatrixView<const Real> D, MatrixView<Real> S, MatrixView<Real> T,
+                 MatrixView<Real> P)
+{
+    const index_t M = D.rows;
+
+    if (n == 0) {
+        if constexpr (Pattern::start == Start::Free) {
+            for (index_t m = 0; m < M; ++m) {
+                S(m, 0) = D(m, 0);
+                T(m, 0) = 1;
+                P(m, 0) = Real(m);
+            }
+        } else {
+            S(0, 0) = D(0, 0);
+            T(0, 0) = 1;
+            P(0, 0) = 0;
+            for (index_t m = 1; m < M; ++m) {
+                S(m, 0) = accumulate(S(m - 1, 0), D(m, 0));
+                T(m, 0) = Real(m + 1);
+                P(m, 0) = 0;
+            }
+        }
+        return;
+    }
+
+    // First row(s): horizontal accumulation only
+    const index_t rows0 = Pattern::first_row < M ? Pattern::first_row : M;
+    for (index_t m = 0; m < rows0; ++m) {
+        S(m, n) = accumulate(S(m, n - 1), D(m, n));
+        T(m, n) = accumulate(T(m, n - 1), Real(1));
+        P(m, n) = P(m, n - 1);
+    }
+
+    if constexpr (Pattern::first_col > 1)
+        if (n < Pattern::first_col)
+            Pattern::template boundary_column<Norm>(n, D, S, T, P);
+}
+
+template <class Pattern, class Norm, class Real>
+void init_boundaries(MatrixView<const Real> D, MatrixView<Real> S, MatrixView<Real> T,
+                     MatrixView<Real> P)
+{
+    for (index_t n = 0; n < D.cols; ++n)
+        init_column<Pattern, Norm>(n, D, S, T, P);
+}
+
+template <class Pattern, class Real>
+Hit<Real> score(MatrixView<Real> S, MatrixView<Real> T, MatrixView<Real> P)
+{
+    const index_t N = S.cols;
+    const index_t end = Pattern::end == End::Open ? argmin_last_column(S) : S.rows - 1;
+    return Hit<Real>{S(end, N - 1) / T(end, N - 1), index_t(P(end, N - 1)), end};
+}
+
+// True when the rows of a and b overlap by more than max_overlap of
+// their union.
+template <class Real>
+bool overlaps(const Hit<Real>& a, const Hit<Real>& b, double max_overlap)
+{
+    const index_t common = std::min(a.end, b.end) - std::max(a.start, b.start) + 1;
+    if (common <= 0)
+        return false;
+    const index_t total = (a.end - a.start + 1) + (b.end - b.start + 1) - common;
+    return double(common) > max_overlap * double(total);
+}
+
+// Up to top.count hits of the last column in the order of score(): rows
+// are visited by lowest S (first row on ties) through a heap, and a row
+// is kept unless it overlaps a hit already kept. Corner-end patterns
+// have only the one end row.
+template <class Pattern, class Real>
+std::vector<Hit<Real>> best_hits(MatrixView<Real> S, MatrixView<Real> T, MatrixView<Real> P, const TopK& top)
+{
+    const StageTimer timer(Stage::Merge);
+    std::vector<Hit<Real>> hits;
+    if (top.count == 0)
+        return hits;
+    if (Pattern::end != End::Open) {
+        hits.push_back(score<Pattern>(S, T, P));
+        return hits;
+    }
+    const index_t n = S.cols - 1;
+    auto hit = [&](index_t m) { return Hit<Real>{S(m, n) / T(m, n), index_t(P(m, n)), m}; };
+    // Max-heap on "worse", so the best row is on top
+    auto worse = [&](index_t a, index_t b) { return S(b, n) < S(a, n) || (!(S(a, n) < S(b, n)) && b < a); };
+    Scratch<index_t> rows(std::size_t(S.rows));
+    for (index_t m = 0; m < S.rows; ++m)
+        rows[std::size_t(m)] = m;
+    index_t* heap_end = rows.end();
+    std::make_heap(rows.begin(), heap_end, worse);
+    while (heap_end != rows.begin() && hits.size() < top.count) {
+        std::pop_heap(rows.begin(), heap_end, worse);
+        const Hit<Real> h = hit(*--heap_end);
+        if (std::none_of(hits.begin(), hits.end(),
+                         [&](const Hit<Real>& kept) { return overlaps(h, kept, top.max_overlap); }))
+            hits.push_back(h);
+    }
+    return hits;
+}
+
+} // namespace detail
+
+// Interior cells run on the instruction set isa (by default the widest
+// one available, see simd.hpp); every set gives identical results.
+template <class Pattern, class Norm = Accumulated, class Real>
+Hit<Real> dtw(MatrixView<const Real> D, MatrixView<Real> S, MatrixView<Real> T, MatrixView<Real> P,
+              Isa isa = active_isa())
+{
+    detail::check_outputs(D, S, T, P);
+    const detail::StageTimer timer(Stage::Dp);
+    detail::count_cells(D.rows * D.cols);
+    detail::init_boundaries<Pattern, Norm>(D, S, T, P);
+    detail::interior<Pattern, Norm>(isa, D, S, T, P);
+    return detail::score<Pattern>(S, T, P);
+}
+
+// Pointer + leading-dimension form for column-major buffers.
+template <class Pattern, class Norm = Accumulated, class Real>
+Hit<Real> dtw(const Real* D, index_t M, index_t N, index_t ldd, Real* S, Real* T, Real* P,
+              Isa isa = active_isa())
+{
+    return dtw<Pattern, Norm>(column_major(D, M, N, ldd), column_major(S, M, N),
+                              column_major(T, M, N), column_major(P, M, N), isa);
+}
+
+// Convenience form with S, T and P in scratch memory.
+template <class Pattern, class Norm = Accumulated, class Real>
+Hit<Real> dtw(MatrixView<const Real> D, Isa isa = active_isa())
+{
+    const std::size_t cells = std::size_t(D.rows) * std::size_t(D.cols);
+    Scratch<Real> S(cells), T(cells), P(cells);
+    return dtw<Pattern, Norm>(D, column_major(S.data(), D.rows, D.cols),
+                              column_major(T.data(), D.rows, D.cols),
+                              column_major(P.data(), D.rows, D.cols), isa);
+}
+
+} // namespace qbestd
@@ -0,0 +1,73 @@
+/*********************************************************************
+ * Fixed-point recurrence for quantized distances. quantize(D, scale)
+ * maps D to std::uint16_t steps of 1/scale, rounding to nearest and
+ * saturating at 65535; dtw_fixed<Pattern>(Dq, scale) then runs the
+ * rolling recurrence with 16-bit S, T and P, sixteen cells per AVX2
+ * register against four in double. S saturates instead of wrapping, so
+ * a path that reaches 65535 stays there: such end points lose their
+ * order among themselves but never overtake a cheaper one. T and P are
+ * exact integers up to 65535, which bounds M and the longest path.
+ * Selection is on the accumulated cost only (no Normalized division).
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "dtw.hpp"
+#include "patterns.hpp"
+#include "rolling.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+// Column-major M x N copy of D in steps of 1/scale; negative entries
+// become 0 and entries past 65535 steps (or NaN) saturate.
+template <class Real>
+std::vector<std::uint16_t> quantize(MatrixView<const Real> D, double scale)
+{
+    std::vector<std::uint16_t> q(std::size_t(D.rows * D.cols));
+    for (index_t n = 0; n < D.cols; ++n)
+        for (index_t m = 0; m < D.rows; ++m) {
+            const double x = std::round(double(D(m, n)) * scale);
+            q[std::size_t(n * D.rows + m)] = !(x < 65535.0) ? 65535 : x > 0 ? std::uint16_t(x) : 0;
+        }
+    return q;
+}
+
+namespace detail {
+
+template <class Pattern>
+struct FixedHit {
+    double scale;
+
+    Hit<double> operator()(MatrixView<std::uint16_t> S, MatrixView<std::uint16_t> T,
+                           MatrixView<std::uint16_t> P) const
+    {
+        const index_t n = S.cols - 1;
+        const index_t end = Pattern::end == End::Open ? argmin_last_column(S) : S.rows - 1;
+        return Hit<double>{double(S(end, n)) / (scale * double(T(end, n))), index_t(P(end, n)), end};
+    }
+};
+
+} // namespace detail
+
+// Hit of the recurrence on the quantized Dq (see quantize()), with dist
+// back in units of D.
+template <class Pattern>
+Hit<double> dtw_fixed(MatrixView<const std::uint16_t> Dq, double scale, Isa isa = active_isa())
+{
+    if (Dq.empty())
+        throw std::invalid_argument("dtw: empty distance matrix");
+    if (Dq.rows > 65535 || detail::longest_path<Pattern>(Dq.rows, Dq.cols) > 65535.0)
+        throw std::invalid_argument("dtw: fixed point holds rows and path lengths up to 65535");
+    return detail::rolling<Pattern, Accumulated, std::uint16_t>(Dq.rows, Dq.cols, Dq.row_stride, isa,
+                                                               [&](index_t n) { return &Dq(0, n); },
+                                                               detail::FixedHit<Pattern>{scale});
+}
+
+} // namespace qbestd
@@ -0,0 +1,69 @@
+/*********************************************************************
+ * Recurrence fed directly from feature matrices. dtw_features<Pattern,
+ * Norm>(ref, qry, metric) computes each column of D (one query frame
+ * against every reference frame) right before the rolling DP consumes
+ * it, so D is never written out: the working set is one column of D
+ * plus the rolling window of S, T and P.
+ ********************************************************************/
+#pragma once
+
+#include <vector>
+
+#include "distance.hpp"
+#include "patterns.hpp"
+#include "rolling.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+namespace detail {
+
+// Any source of D columns with rows(), cols() and column(n, out, isa):
+// FrameDistance, or CodeDistance of vq.hpp.
+template <class Pattern, class Norm, class Distance, class Finish>
+auto features(const Distance& dist, Isa isa, Finish&& finish)
+{
+    using Real = typename Distance::value_type;
+    Scratch<Real> column(std::size_t(dist.rows()));
+    return rolling<Pattern, Norm, Real>(
+        dist.rows(), dist.cols(), 1, isa,
+        [&](index_t n) {
+            dist.column(n, column.data(), isa);
+            return static_cast<const Real*>(column.data());
+        },
+        finish);
+}
+
+} // namespace detail
+
+template <class Pattern, class Norm = Accumulated, class Real>
+Hit<Real> dtw_features(const FrameDistance<Real>& dist, Isa isa = active_isa())
+{
+    return detail::features<Pattern, Norm>(dist, isa, detail::BestHit<Pattern>{});
+}
+
+// The top.count best hits (see TopK), best first.
+template <class Pattern, class Norm = Accumulated, class Real>
+std::vector<Hit<Real>> dtw_features(const FrameDistance<Real>& dist, const TopK& top, Isa isa = active_isa())
+{
+    return detail::features<Pattern, Norm>(dist, isa, detail::BestHits<Pattern>{top});
+}
+
+// ref is ND x N1 and qry ND x N2 (frames in columns); D is N1 x N2.
+template <class Pattern, class Norm = Accumulated, class Real>
+Hit<Real> dtw_features(MatrixView<const Real> ref, MatrixView<const Real> qry, Metric metric,
+                       Isa isa = active_isa())
+{
+    return dtw_features<Pattern, Norm>(FrameDistance<Real>(ref, qry, metric), isa);
+}
+
+template <class Pattern, class Norm = Accumulated, class Real>
+std::vector<Hit<Real>> dtw_features(MatrixView<const Real> ref, MatrixView<const Real> qry, Metric metric,
+                                    const TopK& top, Isa isa = active_isa())
+{
+    return dtw_features<Pattern, Norm>(FrameDistance<Real>(ref, qry, metric), top, isa);
+}
+
+} // namespace qbestd
@@ -0,0 +1,161 @@
+/*********************************************************************
+ * Interior of the accumulated-cost recurrence (every cell that has all
+ * predecessors of its step pattern), with a scalar reference loop and
+ * AVX2 / AVX-512 kernels chosen at runtime. Real is double, float (twice
+ * the lanes) or the saturating fixed-point std::uint16_t of fixed.hpp.
+ ********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "steps.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+namespace detail {
+
+template <class Pattern, class Norm, class Real>
+void interior_scalar(index_t first_col, MatrixView<const Real> D, MatrixView<Real> S,
+                     MatrixView<Real> T, MatrixView<Real> P)
+{
+    using steps = typename Pattern::steps;
+    for (index_t n = first_col; n < D.cols; ++n)
+        for (index_t m = Pattern::first_row; m < D.rows; ++m) {
+            const Candidate<Real> best = relax<Norm>(steps{}, m, n, D(m, n), S, T, P);
+            S(m, n) = best.cost;
+            T(m, n) = best.len;
+            P(m, n) = best.start;
+        }
+}
+
+// Width-1 build of the kernels below; interior() never dispatches to it,
+// but lane-parallel kernels (batch.hpp) use its Lanes and select().
+namespace scalar {
+#include "detail/dp_kernels.inl"
+} // namespace scalar
+
+} // namespace detail
+
+#if QBESTD_X86_SIMD
+
+QBESTD_PUSH_TARGET_AVX2
+namespace detail::avx2 {
+#include "detail/dp_kernels.inl"
+} // namespace detail::avx2
+QBESTD_POP_TARGET
+
+QBESTD_PUSH_TARGET_AVX512
+namespace detail::avx512 {
+#include "detail/dp_kernels.inl"
+} // namespace detail::avx512
+QBESTD_POP_TARGET
+
+#endif // QBESTD_X86_SIMD
+
+namespace detail {
+
+template <class Real>
+bool same_layout(MatrixView<Real> a, MatrixView<Real> b)
+{
+    return a.row_stride == b.row_stride && a.col_stride == b.col_stride;
+}
+
+template <class Real>
+bool simd_layout(MatrixView<Real> S, MatrixView<Real> T, MatrixView<Real> P)
+{
+    return S.row_stride == 1 && same_layout(S, T) && same_layout(S, P);
+}
+
+template <class Pattern, class Norm, class Real>
+void interior(Isa isa, MatrixView<const Real> D, MatrixView<Real> S, MatrixView<Real> T,
+              MatrixView<Real> P)
+{
+#if QBESTD_X86_SIMD
+    if constexpr (simd_real<Real>) {
+        const bool simd_layout = detail::simd_layout(S, T, P);
+        if (isa == Isa::Avx512 && simd_layout)
+            return avx512::interior<Avx512<Real>, Pattern, Norm>(D, S, T, P);
+        if (isa == Isa::Avx2 && simd_layout)
+            return avx2::interior<Avx2<Real>, Pattern, Norm>(D, S, T, P);
+    } else if constexpr (std::is_same_v<Real, std::uint16_t> && Pattern::steps::min_dn >= 1) {
+        if (isa >= Isa::Avx2 && D.row_stride == 1 && simd_layout(S, T, P))
+            return avx2::columns<Avx2<Real>, Norm>(typename Pattern::steps{}, Pattern::first_row,
+                                                   Pattern::first_col, D, S, T, P);
+    }
+#endif
+    (void)isa;
+    interior_scalar<Pattern, Norm>(Pattern::first_col, D, S, T, P);
+}
+
+// Interior cells of columns first_col.. of a column window (rolling.hpp).
+// A wavefront needs whole anti-diagonals, so patterns with an in-column
+// step stay on the scalar loop here.
+template <class Pattern, class Norm, class Real>
+void interior_columns(Isa isa, index_t first_col, MatrixView<const Real> D, MatrixView<Real> S,
+                      MatrixView<Real> T, MatrixView<Real> P)
+{
+#if QBESTD_X86_SIMD
+    using steps = typename Pattern::steps;
+    if constexpr (simd_real<Real> && steps::min_dn >= 1) {
+        const bool simd = D.row_stride == 1 && simd_layout(S, T, P);
+        if (isa == Isa::Avx512 && simd)
+            return avx512::columns<Avx512<Real>, Norm>(steps{}, Pattern::first_row, first_col, D,
+                                                       S, T, P);
+        if (isa == Isa::Avx2 && simd)
+            return avx2::columns<Avx2<Real>, Norm>(steps{}, Pattern::first_row, first_col, D, S,
+                                                   T, P);
+    } else if constexpr (std::is_same_v<Real, std::uint16_t> && steps::min_dn >= 1) {
+        // 16-bit lanes need AVX-512BW; AVX-512 machines run the AVX2 kernel
+        if (isa >= Isa::Avx2 && D.row_stride == 1 && simd_layout(S, T, P))
+            return avx2::columns<Avx2<Real>, Norm>(steps{}, Pattern::first_row, first_col, D, S,
+                                                   T, P);
+    }
+#endif
+    (void)isa;
+    interior_scalar<Pattern, Norm>(first_col, D, S, T, P);
+}
+
+// Rows first_row.. of one column in the packed layout of rolling.hpp.
+template <class Pattern, class Norm>
+void packed_column(Isa isa, index_t M, const double* d, const double* S0, const std::uint64_t* L0, double* S1,
+                   std::uint64_t* L1)
+{
+    using steps = typename Pattern::steps;
+#if QBESTD_X86_SIMD
+    if (isa == Isa::Avx512)
+        return avx512::packed_column<Avx512<double>, Norm>(steps{}, Pattern::first_row, M, d, S0, L0, S1, L1);
+    if (isa == Isa::Avx2)
+        return avx2::packed_column<Avx2<double>, Norm>(steps{}, Pattern::first_row, M, d, S0, L0, S1, L1);
+#endif
+    (void)isa;
+    scalar::packed_column<Scalar<double>, Norm>(steps{}, Pattern::first_row, M, d, S0, L0, S1, L1);
+}
+
+// Winning step codes of one column for path.hpp; d, s[k] and t[k] have
+// unit stride.
+template <class Pattern, class Norm, class Real>
+void winning_steps(Isa isa, const unsigned char* step_code, index_t M, const Real* d, const Real* const* s,
+                   const Real* const* t, unsigned char* codes)
+{
+    using steps = typename Pattern::steps;
+#if QBESTD_X86_SIMD
+    if constexpr (simd_real<Real>) {
+        if (isa == Isa::Avx512)
+            return avx512::winning_steps<Avx512<Real>, Norm>(steps{}, step_code, Pattern::first_row, M, d, s, t,
+                                                              codes);
+        if (isa == Isa::Avx2)
+            return avx2::winning_steps<Avx2<Real>, Norm>(steps{}, step_code, Pattern::first_row, M, d, s, t,
+                                                          codes);
+    }
+#endif
+    (void)isa;
+    scalar::winning_steps<Scalar<Real>, Norm>(steps{}, step_code, Pattern::first_row, M, d, s, t, codes);
+}
+
+} // namespace detail
+} // namespace qbestd
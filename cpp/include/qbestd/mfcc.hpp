@@ -0,0 +1,349 @@
+/*********************************************************************
+ * Native MFCC front end, computing what extract_mfcc() of
+ * python/subsequence_dtw.py computes with librosa's defaults:
+ *   - 22050 Hz mono (other WAV rates are resampled, see audio.hpp)
+ *   - frames of n_fft = 2048 samples every 512, centred, zero-padded
+ *   - periodic Hann window and power spectrum
+ *   - 128 Slaney mel bands with Slaney area normalization
+ *   - 10 log10(max(mel, 1e-10)), clipped 80 dB below the maximum
+ *   - first 40 coefficients of the orthonormal DCT-II
+ *   - per-frame normalization: mean 0 and standard deviation 1 over
+ *     the coefficients of each frame
+ * Frames run in SIMD lanes, one frame per lane as in the query lanes of
+ * search_batch(): the real FFT (a radix-2 FFT of half the size on the
+ * even and odd samples, then split), the filterbank and the DCT are all
+ * vector operations on whole groups of frames.
+ *
+ * mfcc() takes a whole signal. MfccStream takes samples as they arrive
+ * and hands out each frame as soon as its window is complete, ready for
+ * StreamSearch::push(). The 80 dB floor is the one place the two
+ * differ: mfcc() clips against the maximum of the whole signal, the
+ * stream against the maximum so far, so a quiet start can keep bins
+ * below the final floor.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "audio.hpp"
+#include "counters.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+struct MfccOptions {
+    int sample_rate = 22050;  // feature rate; librosa.load's default
+    index_t n_fft = 2048;     // window and FFT length, a power of two
+    index_t hop = 512;        // samples between frames, at most n_fft
+    index_t n_mels = 128;
+    index_t n_mfcc = 40;
+    double fmin = 0;          // mel band edges in Hz; fmax = 0 is sample_rate / 2
+    double fmax = 0;
+    double top_db = 80;       // floor below the maximum; 0 or less for none
+    bool normalize = true;    // per-frame mean 0, standard deviation 1
+};
+
+// dims values per frame, frames column-major.
+template <class Real>
+struct Features {
+    index_t dims = 0;
+    index_t frames = 0;
+    std::vector<Real> values;
+
+    MatrixView<const Real> view() const { return column_major(values.data(), dims, frames); }
+};
+
+namespace detail {
+
+// Nonzero weights of one mel filter: FFT bins first .. first+count-1.
+struct MelBand {
+    index_t first = 0, count = 0;
+    std::size_t offset = 0;  // into MfccPlan::mel_weights
+};
+
+// librosa's Slaney mel scale: linear below 1 kHz, logarithmic above.
+inline double hz_to_mel(double hz)
+{
+    const double f_sp = 200.0 / 3, min_log_mel = 1000.0 / f_sp, logstep = std::log(6.4) / 27;
+    return hz >= 1000 ? min_log_mel + std::log(hz / 1000) / logstep : hz / f_sp;
+}
+
+inline double mel_to_hz(double mel)
+{
+    const double f_sp = 200.0 / 3, min_log_mel = 1000.0 / f_sp, logstep = std::log(6.4) / 27;
+    return mel >= min_log_mel ? 1000 * std::exp(logstep * (mel - min_log_mel)) : f_sp * mel;
+}
+
+// Window, twiddles, filterbank and DCT of one set of options.
+template <class Real>
+struct MfccPlan {
+    index_t n_fft, hop, n_mels, n_mfcc;
+    double top_db;
+    bool normalize;
+    std::vector<Real> window;                    // periodic Hann
+    std::vector<index_t> bitrev;                 // of n_fft / 2 points
+    std::vector<Real> twiddle_cos, twiddle_sin;  // angle 2 pi j / (n_fft / 2), j < n_fft / 4
+    std::vector<Real> post_cos, post_sin;        // angle 2 pi k / n_fft, k <= n_fft / 2
+    std::vector<MelBand> bands;
+    std::vector<Real> mel_weights;
+    std::vector<Real> dct;                       // n_mfcc x n_mels, row-major
+
+    explicit MfccPlan(const MfccOptions& opt)
+        : n_fft(opt.n_fft), hop(opt.hop), n_mels(opt.n_mels), n_mfcc(opt.n_mfcc), top_db(opt.top_db),
+          normalize(opt.normalize)
+    {
+        const double fmax = opt.fmax > 0 ? opt.fmax : opt.sample_rate / 2.0;
+        if (opt.sample_rate < 1 || n_fft < 4 || (n_fft & (n_fft - 1)) != 0)
+            throw std::invalid_argument("mfcc: need a positive rate and a power-of-two n_fft of at least 4");
+        if (hop < 1 || hop > n_fft)
+            throw std::invalid_argument("mfcc: need 1 <= hop <= n_fft");
+        if (n_mels < 1 || n_mfcc < 1 || n_mfcc > n_mels)
+            throw std::invalid_argument("mfcc: need 1 <= n_mfcc <= n_mels");
+        if (opt.fmin < 0 || opt.fmin >= fmax || fmax > opt.sample_rate / 2.0)
+            throw std::invalid_argument("mfcc: need 0 <= fmin < fmax <= sample_rate / 2");
+
+        constexpr double pi = 3.14159265358979323846;
+        const index_t h = n_fft / 2;
+        window.resize(std::size_t(n_fft));
+        for (index_t t = 0; t < n_fft; ++t)
+            window[std::size_t(t)] = Real(0.5 - 0.5 * std::cos(2 * pi * double(t) / double(n_fft)));
+        index_t bits = 0;
+        while ((index_t(1) << bits) < h)
+            ++bits;
+        bitrev.resize(std::size_t(h));
+        for (index_t t = 0; t < h; ++t) {
+            index_t r = 0;
+            for (index_t b = 0; b < bits; ++b)
+                r |= ((t >> b) & 1) << (bits - 1 - b);
+            bitrev[std::size_t(t)] = r;
+        }
+        for (index_t j = 0; j < h / 2; ++j) {
+            twiddle_cos.push_back(Real(std::cos(2 * pi * double(j) / double(h))));
+            twiddle_sin.push_back(Real(std::sin(2 * pi * double(j) / double(h))));
+        }
+        for (index_t k = 0; k <= h; ++k) {
+            post_cos.push_back(Real(std::cos(2 * pi * double(k) / double(n_fft))));
+            post_sin.push_back(Real(std::sin(2 * pi * double(k) / double(n_fft))));
+        }
+
+        // Triangles between n_mels + 2 points equally spaced in mel,
+        // scaled to unit area as librosa.filters.mel(norm='slaney'), which
+        // returns float32 weights
+        std::vector<double> edge(std::size_t(n_mels + 2));
+        const double lo = hz_to_mel(opt.fmin), hi = hz_to_mel(fmax);
+        for (index_t i = 0; i < n_mels + 2; ++i)
+            edge[std::size_t(i)] = mel_to_hz(lo + (hi - lo) * double(i) / double(n_mels + 1));
+        for (index_t m = 0; m < n_mels; ++m) {
+            const double left = edge[std::size_t(m)], centre = edge[std::size_t(m + 1)];
+            const double right = edge[std::size_t(m + 2)];
+            const double enorm = 2.0 / (right - left);
+            MelBand band;
+            band.offset = mel_weights.size();
+            for (index_t k = 0; k <= h; ++k) {
+                const double f = double(k) * opt.sample_rate / double(n_fft);
+                const double w = std::max(0.0, std::min((f - left) / (centre - left), (right - f) / (right - centre)));
+                if (w > 0) {
+                    if (band.count == 0)
+                        band.first = k;
+                    // Bins between the first and last nonzero ones are nonzero too
+                    mel_weights.push_back(Real(float(w * enorm)));
+                    ++band.count;
+                }
+            }
+            bands.push_back(band);
+        }
+
+        // Orthonormal DCT-II: sqrt(1/M) for the first row, sqrt(2/M) below
+        dct.resize(std::size_t(n_mfcc * n_mels));
+        for (index_t k = 0; k < n_mfcc; ++k)
+            for (index_t m = 0; m < n_mels; ++m)
+                dct[std::size_t(k * n_mels + m)] =
+                    Real(std::sqrt((k == 0 ? 1.0 : 2.0) / double(n_mels))
+                         * std::cos(pi * double(k) * (2.0 * double(m) + 1) / (2.0 * double(n_mels))));
+    }
+
+    // Lowest dB value kept, given the highest one.
+    Real floor(Real highest) const
+    {
+        return top_db > 0 ? highest - Real(top_db) : -std::numeric_limits<Real>::infinity();
+    }
+};
+
+namespace scalar {
+#include "detail/mfcc_kernels.inl"
+} // namespace scalar
+
+} // namespace detail
+
+#if QBESTD_X86_SIMD
+
+QBESTD_PUSH_TARGET_AVX2
+namespace detail::avx2 {
+#include "detail/mfcc_kernels.inl"
+} // namespace detail::avx2
+QBESTD_POP_TARGET
+
+QBESTD_PUSH_TARGET_AVX512
+namespace detail::avx512 {
+#include "detail/mfcc_kernels.inl"
+} // namespace detail::avx512
+QBESTD_POP_TARGET
+
+#endif // QBESTD_X86_SIMD
+
+namespace detail {
+
+// db[f * n_mels ..] = unclipped log-mel energies of the frames whose
+// n_fft samples start at x[f].
+template <class Real>
+void log_mel(Isa isa, const MfccPlan<Real>& plan, const Real* const* x, index_t count, Real* db)
+{
+#if QBESTD_X86_SIMD
+    if constexpr (detail::simd_real<Real>) {
+        if (isa == Isa::Avx512)
+            return avx512::log_mel<Avx512<Real>>(plan, x, count, db);
+        if (isa == Isa::Avx2)
+            return avx2::log_mel<Avx2<Real>>(plan, x, count, db);
+    }
+#endif
+    (void)isa;
+    scalar::log_mel<Scalar<Real>>(plan, x, count, db);
+}
+
+// out[f * n_mfcc ..] = coefficients of the log-mel frames db, clipped
+// at floor.
+template <class Real>
+void cepstra(Isa isa, const MfccPlan<Real>& plan, const Real* db, index_t count, Real floor, Real* out)
+{
+#if QBESTD_X86_SIMD
+    if constexpr (detail::simd_real<Real>) {
+        if (isa == Isa::Avx512)
+            return avx512::cepstra<Avx512<Real>>(plan, db, count, floor, out);
+        if (isa == Isa::Avx2)
+            return avx2::cepstra<Avx2<Real>>(plan, db, count, floor, out);
+    }
+#endif
+    (void)isa;
+    scalar::cepstra<Scalar<Real>>(plan, db, count, floor, out);
+}
+
+} // namespace detail
+
+// MFCCs of a whole signal, opt.n_mfcc x (1 + samples / hop) after
+// resampling to opt.sample_rate.
+template <class Real = double>
+Features<Real> mfcc(const Audio& audio, const MfccOptions& opt = {}, Isa isa = active_isa())
+{
+    const detail::MfccPlan<Real> plan(opt);
+    const Audio* in = &audio;
+    Audio resampled;
+    if (audio.sample_rate != opt.sample_rate) {
+        resampled = resample(audio, opt.sample_rate);
+        in = &resampled;
+    }
+    if (in->samples.empty())
+        throw std::invalid_argument("mfcc: empty audio");
+
+    const detail::StageTimer load(Stage::Load);
+    const index_t length = index_t(in->samples.size()), frames = 1 + length / plan.hop;
+    // Zeros on both sides centre the frames on multiples of hop
+    Scratch<Real> signal(std::size_t(length + plan.n_fft), Real(0));
+    std::copy(in->samples.begin(), in->samples.end(), signal.begin() + plan.n_fft / 2);
+    std::vector<const Real*> starts(static_cast<std::size_t>(frames));
+    for (index_t f = 0; f < frames; ++f)
+        starts[std::size_t(f)] = signal.data() + f * plan.hop;
+
+    Scratch<Real> db(std::size_t(frames * plan.n_mels));
+    detail::log_mel(isa, plan, starts.data(), frames, db.data());
+    Features<Real> out{plan.n_mfcc, frames, std::vector<Real>(std::size_t(frames * plan.n_mfcc))};
+    detail::cepstra(isa, plan, db.data(), frames, plan.floor(*std::max_element(db.begin(), db.end())),
+                    out.values.data());
+    return out;
+}
+
+// MFCCs of a 16-bit PCM WAV file.
+template <class Real = double>
+Features<Real> mfcc(const std::string& wav, const MfccOptions& opt = {}, Isa isa = active_isa())
+{
+    return mfcc<Real>(read_wav(wav), opt, isa);
+}
+
+// MFCCs of a live signal at opt.sample_rate (put a Resampler in front
+// for other rates). Frame f is complete once the samples up to
+// f * hop + n_fft / 2 have arrived; flush() ends the signal and adds
+// the frames that reach past its end, zero-padded as in mfcc().
+template <class Real = double>
+class MfccStream {
+public:
+    explicit MfccStream(const MfccOptions& opt = {}, Isa isa = active_isa())
+        : plan_(opt), isa_(isa), signal_(std::size_t(opt.n_fft / 2), Real(0))
+    {
+    }
+
+    // Appends the frames the new samples complete to out, dims() values
+    // per frame, frames one after the other.
+    void push(const float* samples, std::size_t count, std::vector<Real>& out)
+    {
+        if (ended_)
+            throw std::logic_error("mfcc: samples pushed after flush()");
+        signal_.insert(signal_.end(), samples, samples + count);
+        received_ += index_t(count);
+        const index_t half = plan_.n_fft / 2;
+        emit(received_ >= half ? (received_ - half) / plan_.hop + 1 : 0, out);
+    }
+
+    // End of signal: appends the remaining frames to out.
+    void flush(std::vector<Real>& out)
+    {
+        if (ended_)
+            return;
+        ended_ = true;
+        signal_.resize(signal_.size() + std::size_t(plan_.n_fft / 2), Real(0));
+        emit(received_ / plan_.hop + 1, out);
+    }
+
+    index_t dims() const { return plan_.n_mfcc; }
+
+    // Frames handed out so far.
+    index_t frames() const { return emitted_; }
+
+private:
+    // Frames emitted_ .. total-1; signal_ starts at the first sample of
+    // frame emitted_ in the padded signal.
+    void emit(index_t total, std::vector<Real>& out)
+    {
+        const index_t count = total - emitted_;
+        if (count <= 0)
+            return;
+        const detail::StageTimer load(Stage::Load);
+        starts_.resize(std::size_t(count));
+        for (index_t f = 0; f < count; ++f)
+            starts_[std::size_t(f)] = signal_.data() + f * plan_.hop;
+        Scratch<Real> db(std::size_t(count * plan_.n_mels));
+        detail::log_mel(isa_, plan_, starts_.data(), count, db.data());
+        highest_ = std::max(highest_, *std::max_element(db.begin(), db.end()));
+        const std::size_t at = out.size();
+        out.resize(at + std::size_t(count * plan_.n_mfcc));
+        detail::cepstra(isa_, plan_, db.data(), count, plan_.floor(highest_), out.data() + at);
+        emitted_ = total;
+        signal_.erase(signal_.begin(), signal_.begin() + count * plan_.hop);
+    }
+
+    detail::MfccPlan<Real> plan_;
+    Isa isa_;
+    std::vector<Real> signal_;
+    std::vector<const Real*> starts_;
+    index_t received_ = 0, emitted_ = 0;
+    Real highest_ = -std::numeric_limits<Real>::infinity();
+    bool ended_ = false;
+};
+
+} // namespace qbestd
@@ -0,0 +1,270 @@
+/*********************************************************************
+ * Alignment path of the best hit. dtw_path<Pattern, Norm>(D) runs the
+ * rolling recurrence and records, for every cell, which predecessor move
+ * won as a code of 2 bits (3 for NSDTW5 and NewNSDTW) instead of keeping
+ * S, T and P: an M x N trace takes M*N/4 bytes, about 100 times less than
+ * the three double matrices the old backtracking needed. The path is then
+ * read back from the end point of the hit to its start in column 0.
+ *
+ * Codes come from the selection keys recomputed on the window after each
+ * column (winning_steps(), SIMD like the recurrence itself) with the same
+ * tie order, so the path is the one the recurrence chose and its start row
+ * is the hit's start.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "counters.hpp"
+#include "distance.hpp"
+#include "dtw.hpp"
+#include "kernels.hpp"
+#include "patterns.hpp"
+#include "rolling.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "steps.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+// Reference frame `ref` (row of D) aligned with query frame `qry`.
+struct FramePair {
+    index_t ref = 0;
+    index_t qry = 0;
+};
+
+// The hit and its path, from (start, 0) to (end, N-1).
+template <class Real>
+struct Alignment {
+    Hit<Real> hit;
+    std::vector<FramePair> path;
+};
+
+namespace detail {
+
+// Predecessor moves (dm, dn) a path can take. Code 0 marks the first cell
+// of a path and code c the move c-1.
+template <std::size_t Capacity>
+struct MoveTable {
+    index_t dm[Capacity] = {};
+    index_t dn[Capacity] = {};
+    std::size_t count = 0;
+
+    constexpr unsigned code(index_t m, index_t n) const
+    {
+        for (std::size_t c = 0; c < count; ++c)
+            if (dm[c] == m && dn[c] == n)
+                return unsigned(c + 1);
+        return 0;
+    }
+
+    constexpr void add(index_t m, index_t n)
+    {
+        if (code(m, n) == 0) {
+            dm[count] = m;
+            dn[count] = n;
+            ++count;
+        }
+    }
+
+    constexpr int bits() const
+    {
+        int b = 1;
+        while ((std::size_t(1) << b) < count + 1)
+            ++b;
+        return b;
+    }
+};
+
+// The steps, then the horizontal move of the first rows and the vertical
+// one of an anchored column 0 unless a step already covers them.
+// boundary_step() moves must be steps as well.
+template <Start S, class... Steps>
+constexpr MoveTable<sizeof...(Steps) + 2> move_table(StepList<Steps...>)
+{
+    MoveTable<sizeof...(Steps) + 2> t;
+    const index_t dm[] = {Steps::dm...}, dn[] = {Steps::dn...};
+    for (std::size_t k = 0; k < sizeof...(Steps); ++k)
+        t.add(dm[k], dn[k]);
+    t.add(0, 1);
+    if (S == Start::Anchored)
+        t.add(1, 0);
+    return t;
+}
+
+template <class Pattern>
+constexpr auto moves = move_table<Pattern::start>(typename Pattern::steps{});
+
+// Codes of `bits` bits over an M x N grid; every column starts on a new
+// 64-bit word so that a code never straddles two words.
+class Traceback {
+public:
+    Traceback(index_t rows, index_t cols, int bits)
+        : rows_(rows), bits_(bits), per_word_(64 / bits), words_((rows + per_word_ - 1) / per_word_),
+          codes_(std::size_t(words_ * cols))
+    {
+    }
+
+    // Stores codes[m] for every row m of column n.
+    void set_column(index_t n, const unsigned char* codes)
+    {
+        std::uint64_t* out = codes_.data() + n * words_;
+        for (index_t w = 0, m = 0; w < words_; ++w) {
+            std::uint64_t word = 0;
+            for (int shift = 0; shift + bits_ <= 64 && m < rows_; shift += bits_, ++m)
+                word |= std::uint64_t(codes[m]) << shift;
+            out[w] = word;
+        }
+    }
+
+    unsigned operator()(index_t m, index_t n) const
+    {
+        return unsigned(codes_[word(m, n)] >> shift(m) & ((std::uint64_t(1) << bits_) - 1));
+    }
+
+    std::size_t bytes() const { return codes_.size() * sizeof(std::uint64_t); }
+
+private:
+    std::size_t word(index_t m, index_t n) const { return std::size_t(n * words_ + m / per_word_); }
+    int shift(index_t m) const { return int(m % per_word_) * bits_; }
+
+    index_t rows_;
+    int bits_;
+    index_t per_word_, words_;
+    Scratch<std::uint64_t> codes_;
+};
+
+template <class Pattern, class... Steps>
+constexpr std::array<unsigned char, sizeof...(Steps)> step_codes(StepList<Steps...>)
+{
+    return {(unsigned char)moves<Pattern>.code(Steps::dm, Steps::dn)...};
+}
+
+// Codes of column j of the window, which is column n of the problem; D
+// has unit row stride.
+template <class Pattern, class Norm, class Real>
+void trace_column(Isa isa, index_t n, index_t j, MatrixView<const Real> D, MatrixView<Real> S,
+                  MatrixView<Real> T, Scratch<unsigned char>& codes)
+{
+    constexpr auto table = moves<Pattern>;
+    const index_t M = D.rows;
+    if (n == 0) {
+        // Free starts begin on every row, anchored ones only at (0,0)
+        std::fill(codes.begin(), codes.end(),
+                  Pattern::start == Start::Free ? 0 : (unsigned char)table.code(1, 0));
+        codes[0] = 0;
+        return;
+    }
+    const index_t rows0 = std::min(Pattern::first_row, M);
+    std::fill(codes.begin(), codes.begin() + rows0, (unsigned char)table.code(0, 1));
+    if constexpr (Pattern::first_col > 1) {
+        if (j < Pattern::first_col) {
+            for (index_t m = rows0; m < M; ++m) {
+                const std::pair<index_t, index_t> step = Pattern::template boundary_step<Norm>(m, j, D, S, T);
+                codes[std::size_t(m)] = (unsigned char)table.code(step.first, step.second);
+            }
+            return;
+        }
+    }
+    using steps = typename Pattern::steps;
+    static constexpr auto step_code = step_codes<Pattern>(steps{});
+    constexpr std::size_t K = steps::size;
+    const Real* s[K];
+    const Real* t[K];
+    std::size_t k = 0;
+    for_each_step(steps{}, [&](index_t dm, index_t dn) {
+        s[k] = &S(0, j - dn) - dm;
+        t[k] = &T(0, j - dn) - dm;
+        ++k;
+    });
+    winning_steps<Pattern, Norm>(isa, step_code.data(), M, &D(0, j), s, t, codes.data());
+}
+
+// rolling() that also fills a Traceback and walks the best hit back.
+template <class Pattern, class Norm, class Real, class Column>
+Alignment<Real> traced(index_t M, index_t N, index_t row_stride, Isa isa, Column&& column)
+{
+    static_assert(std::is_floating_point_v<Real>, "paths are traced for float and double");
+    const StageTimer timer(Stage::Dp);
+    count_cells(M * N);
+    constexpr auto table = moves<Pattern>;
+    constexpr index_t width = std::max(Pattern::steps::max_dn, Pattern::first_col) + 1;
+    ColumnWindow<Real> window(M, width);
+    Traceback trace(M, N, table.bits());
+    Scratch<unsigned char> codes(static_cast<std::size_t>(M));
+    Scratch<Real> contiguous(row_stride != 1 ? codes.size() : 0);  // strided columns of D
+    MatrixView<Real> S, T, P;
+    for (index_t n = 0; n < N; ++n) {
+        window.advance(n);
+        S = window.S(n);
+        T = window.T(n);
+        P = window.P(n);
+        const index_t j = S.cols - 1;
+        const Real* d = column(n);
+        if (row_stride != 1) {
+            for (index_t m = 0; m < M; ++m)
+                contiguous[std::size_t(m)] = d[m * row_stride];
+            d = contiguous.data();
+        }
+        const MatrixView<const Real> Dw{d, M, j + 1, 1, 0};
+        init_column<Pattern, Norm>(j, Dw, S, T, P);
+        if (j >= Pattern::first_col)
+            interior_columns<Pattern, Norm>(isa, j, Dw, S, T, P);
+        trace_column<Pattern, Norm>(isa, n, j, Dw, S, T, codes);
+        trace.set_column(n, codes.data());
+    }
+
+    Alignment<Real> out{score<Pattern>(S, T, P), {}};
+    index_t m = out.hit.end, n = N - 1;
+    for (;;) {
+        out.path.push_back(FramePair{m, n});
+        const unsigned code = trace(m, n);
+        if (code == 0)
+            break;
+        m -= table.dm[code - 1];
+        n -= table.dn[code - 1];
+    }
+    std::reverse(out.path.begin(), out.path.end());
+    return out;
+}
+
+} // namespace detail
+
+// Hit of dtw_rolling<Pattern, Norm>(D) and its path. Memory is the
+// rolling window plus 2 or 3 bits per cell of D.
+template <class Pattern, class Norm = Accumulated, class Real>
+Alignment<Real> dtw_path(MatrixView<const Real> D, Isa isa = active_isa())
+{
+    if (D.empty())
+        throw std::invalid_argument("dtw: empty distance matrix");
+    return detail::traced<Pattern, Norm, Real>(D.rows, D.cols, D.row_stride, isa,
+                                               [&](index_t n) { return &D(0, n); });
+}
+
+// Same from feature matrices, computing D one column at a time.
+template <class Pattern, class Norm = Accumulated, class Real>
+Alignment<Real> dtw_path(const FrameDistance<Real>& dist, Isa isa = active_isa())
+{
+    Scratch<Real> column(std::size_t(dist.rows()));
+    return detail::traced<Pattern, Norm, Real>(dist.rows(), dist.cols(), 1, isa, [&](index_t n) {
+        dist.column(n, column.data(), isa);
+        return static_cast<const Real*>(column.data());
+    });
+}
+
+template <class Pattern, class Norm = Accumulated, class Real>
+Alignment<Real> dtw_path(MatrixView<const Real> ref, MatrixView<const Real> qry, Metric metric,
+                         Isa isa = active_isa())
+{
+    return dtw_path<Pattern, Norm>(FrameDistance<Real>(ref, qry, metric), isa);
+}
+
+} // namespace qbestd
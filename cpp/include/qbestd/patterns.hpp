@@ -0,0 +1,174 @@
+/*********************************************************************
+ * Step patterns and normalizations of the MEX kernels in matlab/.
+ *
+ * D is M x N, rows m run over the reference and columns n over the
+ * query. A pattern lists its predecessor steps (see steps.hpp) in the
+ * order the original min_fun_ind resolved ties: the first step reaching
+ * the minimum wins. Rows below first_row of every column n >= 1 are
+ * filled by horizontal accumulation, exactly like the "first row(s)
+ * initialization" loops of the kernels.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <utility>
+
+#include "steps.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+enum class Start {
+    Free,     // column 0 is S=D, T=1, P=m: a path may start on any row
+    Anchored  // column 0 accumulates downwards: every path starts at (0,0)
+};
+
+enum class End {
+    Open,   // best (lowest S) row of the last column
+    Corner  // row M-1 of the last column
+};
+
+// Predecessor selection on the accumulated cost D+S (the offline kernels).
+struct Accumulated {
+    static constexpr bool by_length = false;
+    template <class Real>
+    static Real key(Real cost, Real /*len*/) { return cost; }
+};
+
+// Predecessor selection on (D+S)/(T+1) (the *_online kernels); S still
+// accumulates the raw cost.
+struct Normalized {
+    static constexpr bool by_length = true;
+    template <class Real>
+    static Real key(Real cost, Real len) { return cost / len; }
+};
+
+// Any step list with at most one column of look-back; rows and columns
+// that lack a predecessor are boundary cells.
+template <class Steps, Start S = Start::Free, End E = End::Open>
+struct StepPattern {
+    static_assert(Steps::max_dn <= 1, "steps skipping columns need a boundary_column rule");
+    static constexpr Start start = S;
+    static constexpr End end = E;
+    static constexpr index_t first_row = Steps::max_dm > 0 ? Steps::max_dm : 1;
+    static constexpr index_t first_col = 1;
+    using steps = Steps;
+};
+
+namespace detail {
+
+template <class Seq>
+struct vertical_jumps;
+
+template <std::size_t... J>
+struct vertical_jumps<std::index_sequence<J...>> {
+    using type = StepList<Step<index_t(sizeof...(J) - 1 - J), 1>...>;
+};
+
+} // namespace detail
+
+// NSDTW with K vertical-jump predecessors S(m-k, n-1), k = K-1..0; the
+// longest jump is preferred on ties as in NSDTW_c_skel_2/_4/_5.
+template <index_t K>
+struct NSDTWK {
+    static_assert(K >= 2, "NSDTW needs at least two predecessors");
+    static constexpr Start start = Start::Free;
+    static constexpr End end = End::Open;
+    static constexpr index_t first_row = K - 1 > 2 ? K - 1 : 2;
+    static constexpr index_t first_col = 1;
+    using steps = typename detail::vertical_jumps<std::make_index_sequence<std::size_t(K)>>::type;
+};
+
+using NSDTW2 = NSDTWK<2>; // NSDTW_c_skel_2
+using NSDTW4 = NSDTWK<4>; // NSDTW_c_skel_4
+using NSDTW5 = NSDTWK<5>; // NSDTW_c_skel_5
+
+// NSDTW_c_skel / NSDTW_c_skel_online: horizontal, diagonal, edge; unlike
+// the other jump counts the horizontal step wins ties.
+using NSDTW3 = StepPattern<StepList<Step<0, 1>, Step<1, 1>, Step<2, 1>>>;
+
+// GTTS_DTW_c_skel / GTTS_DTW_c_skel_online / sub_DTW_c_skel_online:
+// horizontal, diagonal, vertical.
+using GTTS = StepPattern<StepList<Step<0, 1>, Step<1, 1>, Step<1, 0>>>;
+
+// newNSDTW_c_skel / newNSDTW_c_skel_online: every step advances one row
+// and skips 0, 1 or 2 columns. Column 1 has no (1,2) predecessor and is
+// filled by boundary_column, where the diagonal adds 2 to the path length
+// as in the original kernel; boundary_step tells which move it took.
+struct NewNSDTW {
+    static constexpr Start start = Start::Free;
+    static constexpr End end = End::Open;
+    static constexpr index_t first_row = 1;
+    static constexpr index_t first_col = 2;
+    using steps = StepList<Step<1, 0>, Step<1, 1>, Step<1, 2>>;
+
+    // (dm, dn) of the predecessor of boundary cell (m, n): vertical on ties.
+    template <class Norm, class Real>
+    static std::pair<index_t, index_t> boundary_step(index_t m, index_t n, MatrixView<const Real> D,
+                                                     MatrixView<Real> S, MatrixView<Real> T)
+    {
+        const Real diag = detail::accumulate(D(m, n), S(m - 1, n - 1));
+        const Real vert = detail::accumulate(D(m, n), S(m - 1, n));
+        if (Norm::key(vert, Real(T(m - 1, n) + 1)) <= Norm::key(diag, Real(T(m - 1, n - 1) + 1)))
+            return {1, 0};
+        return {1, 1};
+    }
+
+    template <class Norm, class Real>
+    static void boundary_column(index_t n, MatrixView<const Real> D, MatrixView<Real> S,
+                                MatrixView<Real> T, MatrixView<Real> P)
+    {
+        for (index_t m = 1; m < D.rows; ++m) {
+            const Real diag = detail::accumulate(D(m, n), S(m - 1, n - 1));
+            const Real vert = detail::accumulate(D(m, n), S(m - 1, n));
+            if (boundary_step<Norm>(m, n, D, S, T).second == 0) {
+                S(m, n) = vert;
+                T(m, n) = T(m - 1, n) + 1;
+                P(m, n) = P(m - 1, n);
+            } else {
+                S(m, n) = diag;
+                T(m, n) = T(m - 1, n - 1) + 2;
+                P(m, n) = P(m - 1, n - 1);
+            }
+        }
+    }
+};
+
+// DTW_c_skel_nobt: anchored at (0,0), open end; diagonal preferred.
+using OpenEndDTW = StepPattern<StepList<Step<1, 1>, Step<1, 0>, Step<0, 1>>, Start::Anchored>;
+
+// DTW_c_basic_skel_nobt: full-sequence alignment ending at (M-1, N-1).
+using BasicDTW =
+    StepPattern<StepList<Step<1, 1>, Step<1, 0>, Step<0, 1>>, Start::Anchored, End::Corner>;
+
+// Sakoe-Chiba symmetric form: the diagonal counts twice, so S/T is
+// normalized by the summed weights (M+N for a full alignment).
+using SymmetricDTW =
+    StepPattern<StepList<Step<1, 1, 2>, Step<1, 0>, Step<0, 1>>, Start::Anchored, End::Corner>;
+
+namespace detail {
+
+// Every path has exactly one cell per column, so T = n+1 on column n
+// (the NSDTW patterns).
+template <class Pattern>
+constexpr bool one_cell_per_column = Pattern::start == Start::Free && Pattern::first_col == 1
+                                  && Pattern::steps::min_dn == 1 && Pattern::steps::max_dn == 1
+                                  && Pattern::steps::unit_weights;
+
+// Upper bound on T at any end point of an M x N problem.
+template <class Pattern>
+double longest_path(index_t M, index_t N)
+{
+    if constexpr (one_cell_per_column<Pattern>) {
+        return double(N);
+    } else {
+        // Every step advances m+n by at least one and adds at most its
+        // weight to T, or 2 on NewNSDTW's boundary diagonal.
+        const int w = std::max(Pattern::steps::max_weight, Pattern::first_col > 1 ? 2 : 1);
+        return 1.0 + double(w) * double(M - 1 + N - 1);
+    }
+}
+
+} // namespace detail
+
+} // namespace qbestd
@@ -0,0 +1,168 @@
+/*********************************************************************
+ * Lower bounds on the dtw_features() distance, cheap enough to decide
+ * whether a reference is worth a DP at all (LB_Keogh in feature space).
+ * An Envelope holds the per-dimension minimum and maximum of the
+ * reference frames over blocks of consecutive frames; the distance from
+ * a query frame to a block's box bounds its distance to every frame of
+ * the block. Per query frame the smallest box distance bounds its whole
+ * column of D, and the pattern turns those column bounds into a bound on
+ * S/T. One box over the whole reference costs O(N ND) per query; boxes
+ * over blocks of B frames cost O(N ND M/B) and are tighter, so search
+ * code tries the first and then the second before running the DP.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "distance.hpp"
+#include "patterns.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+// Query-reference pairs seen by a pruned search and how many were
+// dropped by the whole-reference box and by the block boxes.
+struct PruneStats {
+    std::size_t pairs = 0;
+    std::size_t coarse = 0;
+    std::size_t fine = 0;
+
+    std::size_t searched() const { return pairs - coarse - fine; }
+    double rate() const { return pairs ? double(coarse + fine) / double(pairs) : 0.0; }
+
+    PruneStats& operator+=(const PruneStats& o)
+    {
+        pairs += o.pairs;
+        coarse += o.coarse;
+        fine += o.fine;
+        return *this;
+    }
+};
+
+namespace detail {
+
+template <class Real>
+struct Envelope {
+    FrameKind kind;
+    index_t dims = 0;
+    index_t blocks = 0;
+    std::vector<Real> lo, hi;  // block b at [b*dims]
+
+    // Boxes over blocks of `block` frames of X (one box for block <= 0).
+    Envelope(const Frames<Real>& X, index_t block) : kind(X.kind), dims(X.dims)
+    {
+        if (block <= 0 || block > X.count)
+            block = X.count;
+        blocks = (X.count + block - 1) / block;
+        lo.assign(std::size_t(blocks * dims), std::numeric_limits<Real>::infinity());
+        hi.assign(lo.size(), -std::numeric_limits<Real>::infinity());
+        for (index_t f = 0; f < X.count; ++f) {
+            Real* l = lo.data() + (f / block) * dims;
+            Real* h = hi.data() + (f / block) * dims;
+            const Real* x = X.frame(f);
+            for (index_t i = 0; i < dims; ++i) {
+                l[i] = std::min(l[i], x[i]);
+                h[i] = std::max(h[i], x[i]);
+            }
+        }
+    }
+
+    // Lower bound on the distance between y (log ly) and any frame of block b.
+    Real distance(index_t b, const Real* y, const Real* ly) const
+    {
+        const Real* l = lo.data() + b * dims;
+        const Real* h = hi.data() + b * dims;
+        Real s = 0;
+        switch (kind) {
+        case FrameKind::Dot:
+            // Largest possible x . y inside the box
+            for (index_t i = 0; i < dims; ++i)
+                s += std::max(l[i] * y[i], h[i] * y[i]);
+            return neg_log(s);
+        case FrameKind::SqDiff:
+            for (index_t i = 0; i < dims; ++i) {
+                const Real e = y[i] - std::clamp(y[i], l[i], h[i]);
+                s += e * e;
+            }
+            return s;
+        case FrameKind::Kl:
+            // (x - y)(log x - log y) grows with |x - y|: take the box point
+            // nearest to y in every dimension
+            for (index_t i = 0; i < dims; ++i) {
+                const Real x = std::clamp(y[i], l[i], h[i]);
+                s += (x - y[i]) * (clamped_log(x) - ly[i]);
+            }
+            return s;
+        }
+        return s;
+    }
+};
+
+// Widens a bound by far more than the rounding differences between the
+// box sums and the kernels' reductions, so pruning never drops a tie.
+template <class Real>
+Real widened(Real bound)
+{
+    return bound - std::abs(bound) * Real(1e-9);
+}
+
+// Lower bound on S/T of every end point of the last column, given a
+// lower bound col[n] on every entry of column n of D.
+template <class Pattern, class Real>
+Real path_bound(const std::vector<Real>& col)
+{
+    if constexpr (one_cell_per_column<Pattern>) {
+        // Exactly one cell per column: T = N and S is their sum
+        Real s = 0;
+        for (Real c : col)
+            s += c;
+        return widened(s / Real(col.size()));
+    } else {
+        // S/T is a weighted mean of the cells on the path. Below first_col
+        // a cell may add 2 to T (NewNSDTW), which halves a positive bound.
+        const Real low = *std::min_element(col.begin(), col.end());
+        if constexpr (Pattern::first_col > 1)
+            return widened(low > 0 ? low / 2 : low);
+        else
+            return widened(low);
+    }
+}
+
+// Lower bound on every entry of each column of D from the boxes of env.
+template <class Real>
+std::vector<Real> column_bounds(const Envelope<Real>& env, const Frames<Real>& qry)
+{
+    std::vector<Real> col(std::size_t(qry.count), std::numeric_limits<Real>::infinity());
+    const bool logs = qry.kind == FrameKind::Kl;
+    for (index_t n = 0; n < qry.count; ++n)
+        for (index_t b = 0; b < env.blocks; ++b)
+            col[std::size_t(n)] = std::min(col[std::size_t(n)],
+                                           env.distance(b, qry.frame(n), logs ? qry.log_frame(n) : nullptr));
+    return col;
+}
+
+// Bound on the distance of query qry against the reference boxes of env.
+template <class Pattern, class Real>
+Real lower_bound(const Envelope<Real>& env, const Frames<Real>& qry)
+{
+    return path_bound<Pattern>(column_bounds(env, qry));
+}
+
+} // namespace detail
+
+// Lower bound on dtw_features<Pattern>(ref, qry, metric).dist from boxes
+// over blocks of `block` reference frames (0: one box).
+template <class Pattern, class Real>
+Real dtw_lower_bound(MatrixView<const Real> ref, MatrixView<const Real> qry, Metric metric, index_t block = 0)
+{
+    if (ref.empty() || qry.empty() || ref.rows != qry.rows)
+        throw std::invalid_argument("dtw_lower_bound: empty or mismatched feature matrices");
+    const detail::Frames<Real> r(ref, metric), q(qry, metric);
+    return detail::lower_bound<Pattern>(detail::Envelope<Real>(r, block), q);
+}
+
+} // namespace qbestd
@@ -0,0 +1,30 @@
+// Umbrella header for the QbE-STD DTW engine.
+#pragma once
+
+#include "abandon.hpp"
+#include "archive.hpp"
+#include "audio.hpp"
+#include "band.hpp"
+#include "batch.hpp"
+#include "coarse.hpp"
+#include "corpus.hpp"
+#include "counters.hpp"
+#include "distance.hpp"
+#include "distance_matrix.hpp"
+#include "dtw.hpp"
+#include "fixed.hpp"
+#include "fused.hpp"
+#include "kernels.hpp"
+#include "mfcc.hpp"
+#include "path.hpp"
+#include "patterns.hpp"
+#include "prune.hpp"
+#include "rolling.hpp"
+#include "scheduler.hpp"
+#include "scratch.hpp"
+#include "segmental.hpp"
+#include "simd.hpp"
+#include "steps.hpp"
+#include "stream.hpp"
+#include "types.hpp"
+#include "vq.hpp"
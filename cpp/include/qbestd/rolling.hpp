@@ -0,0 +1,217 @@
+/*********************************************************************
+ * O(M) memory form of the recurrence. The score only needs the last
+ * column, so dtw_rolling<Pattern, Norm>(D) keeps S, T and P for the few
+ * columns a step can reach back to and returns just the hit; memory is
+ * independent of the query length N and the full-matrix dtw() becomes a
+ * debugging aid. The columns run over the reference, so the footprint
+ * still grows with the reference length M; StreamSearch (stream.hpp)
+ * rolls over reference frames instead and keeps O(N) for references
+ * too long for that, e.g. hours of audio.
+ *
+ * Patterns whose steps all come from the previous column (the NSDTW
+ * family) run on a packed two-column layout instead: S as doubles and
+ * the path length and start as one 64-bit word T << 32 | P, both in
+ * cache-line aligned arrays. A candidate then costs two loads instead of
+ * three and the argmin moves T and P with a single blend; T and P are
+ * unpacked for the last column only, so the hit is the same.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "counters.hpp"
+#include "dtw.hpp"
+#include "kernels.hpp"
+#include "patterns.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+namespace detail {
+
+// S, T and P of the last `width` columns. In a two-column window column
+// n sits in slot n % 2 and the views flip their column stride so that
+// columns n-1, n stay in order; wider windows shift one slot per column.
+template <class Real>
+class ColumnWindow {
+public:
+    ColumnWindow(index_t rows, index_t width)
+        : rows_(rows), width_(width), S_(std::size_t(rows * width), Real(0)), T_(S_.size(), Real(0)),
+          P_(S_.size(), Real(0))
+    {
+    }
+
+    // Makes room for column n; call once per column, in order.
+    void advance(index_t n)
+    {
+        if (width_ > 2 && n >= width_)
+            for (Scratch<Real>* x : {&S_, &T_, &P_})
+                std::copy(x->begin() + rows_, x->end(), x->begin());
+    }
+
+    // Columns max(0, n-width+1)..n; column n is the last one of the view.
+    MatrixView<Real> S(index_t n) { return view(S_, n); }
+    MatrixView<Real> T(index_t n) { return view(T_, n); }
+    MatrixView<Real> P(index_t n) { return view(P_, n); }
+
+private:
+    MatrixView<Real> view(Scratch<Real>& x, index_t n) const
+    {
+        if (width_ == 2 && n >= 1) {
+            const index_t prev = (n - 1) % 2 * rows_;
+            return MatrixView<Real>{x.data() + prev, rows_, 2, 1, n % 2 ? rows_ : -rows_};
+        }
+        return column_major(x.data(), rows_, std::min(n + 1, width_));
+    }
+
+    index_t rows_, width_;
+    Scratch<Real> S_, T_, P_;
+};
+
+template <class Pattern, class Real>
+constexpr bool packed_layout = std::is_same_v<Real, double> && Pattern::first_col == 1
+                               && Pattern::steps::min_dn == 1 && Pattern::steps::max_dn == 1;
+
+inline std::uint64_t pack(index_t len, index_t start)
+{
+    return std::uint64_t(len) << 32 | std::uint64_t(start);
+}
+
+// rolling() on the packed layout; D must have unit row stride, M below
+// 2^32 and path lengths below 2^31 (high() converts signed lanes).
+template <class Pattern, class Norm, class Column, class Finish>
+auto rolling_packed(index_t M, index_t N, Isa isa, Column&& column, Finish&& finish)
+{
+    Scratch<double> S(std::size_t(2 * M));
+    Scratch<std::uint64_t> L(S.size());
+    constexpr std::uint64_t one = std::uint64_t(1) << 32;
+    const index_t rows0 = std::min(Pattern::first_row, M);
+    for (index_t n = 0; n < N; ++n) {
+        const double* d = column(n);
+        double* s1 = S.data() + n % 2 * M;
+        std::uint64_t* l1 = L.data() + n % 2 * M;
+        if (n == 0) {
+            for (index_t m = 0; m < M; ++m) {
+                if constexpr (Pattern::start == Start::Free) {
+                    s1[m] = d[m];
+                    l1[m] = pack(1, m);
+                } else {
+                    s1[m] = m == 0 ? d[0] : s1[m - 1] + d[m];
+                    l1[m] = pack(m + 1, 0);
+                }
+            }
+            continue;
+        }
+        const double* s0 = S.data() + (n - 1) % 2 * M;
+        const std::uint64_t* l0 = L.data() + (n - 1) % 2 * M;
+        for (index_t m = 0; m < rows0; ++m) {
+            s1[m] = s0[m] + d[m];
+            l1[m] = l0[m] + one;
+        }
+        packed_column<Pattern, Norm>(isa, M, d, s0, l0, s1, l1);
+    }
+
+    // Unpack the last column for the finisher
+    double* s = S.data() + (N - 1) % 2 * M;
+    const std::uint64_t* l = L.data() + (N - 1) % 2 * M;
+    Scratch<double> T(static_cast<std::size_t>(M)), P(T.size());
+    for (index_t m = 0; m < M; ++m) {
+        T[std::size_t(m)] = double(l[m] >> 32);
+        P[std::size_t(m)] = double(l[m] & (one - 1));
+    }
+    return finish(column_major(s, M, 1), column_major(T.data(), M, 1), column_major(P.data(), M, 1));
+}
+
+// Runs the recurrence over an M x N problem whose column n of D is
+// supplied by column(n) as a pointer to its M entries with row stride
+// row_stride; only the current column of D is ever read. Returns
+// finish(S, T, P) on the window holding the last column.
+template <class Pattern, class Norm, class Real, class Column, class Finish>
+auto rolling(index_t M, index_t N, index_t row_stride, Isa isa, Column&& column, Finish&& finish)
+{
+    const StageTimer timer(Stage::Dp);
+    count_cells(M * N);
+    if constexpr (packed_layout<Pattern, Real>)
+        if (row_stride == 1 && M < (index_t(1) << 32) && longest_path<Pattern>(M, N) < 2147483648.0)
+            return rolling_packed<Pattern, Norm>(M, N, isa, column, finish);
+    // Window wide enough for the longest column step and the boundary columns
+    constexpr index_t width = std::max(Pattern::steps::max_dn, Pattern::first_col) + 1;
+    ColumnWindow<Real> window(M, width);
+    MatrixView<Real> S, T, P;
+    for (index_t n = 0; n < N; ++n) {
+        window.advance(n);
+        S = window.S(n);
+        T = window.T(n);
+        P = window.P(n);
+        // Column n is column j of the window; boundary rules only depend on
+        // j, which equals n until the window is full. A zero column stride
+        // maps every column of Dw onto column n of D.
+        const index_t j = S.cols - 1;
+        const MatrixView<const Real> Dw{column(n), M, j + 1, row_stride, 0};
+        init_column<Pattern, Norm>(j, Dw, S, T, P);
+        if (j >= Pattern::first_col)
+            interior_columns<Pattern, Norm>(isa, j, Dw, S, T, P);
+    }
+    return finish(S, T, P);
+}
+
+// Finishers for rolling(): the single hit or the TopK hits.
+template <class Pattern>
+struct BestHit {
+    template <class Real>
+    Hit<Real> operator()(MatrixView<Real> S, MatrixView<Real> T, MatrixView<Real> P) const
+    {
+        return score<Pattern>(S, T, P);
+    }
+};
+
+template <class Pattern>
+struct BestHits {
+    TopK top;
+
+    template <class Real>
+    std::vector<Hit<Real>> operator()(MatrixView<Real> S, MatrixView<Real> T, MatrixView<Real> P) const
+    {
+        return best_hits<Pattern>(S, T, P, top);
+    }
+};
+
+} // namespace detail
+
+// Same hit as dtw<Pattern, Norm>(D) without the M x N outputs.
+template <class Pattern, class Norm = Accumulated, class Real>
+Hit<Real> dtw_rolling(MatrixView<const Real> D, Isa isa = active_isa())
+{
+    if (D.empty())
+        throw std::invalid_argument("dtw: empty distance matrix");
+    return detail::rolling<Pattern, Norm, Real>(D.rows, D.cols, D.row_stride, isa,
+                                                [&](index_t n) { return &D(0, n); },
+                                                detail::BestHit<Pattern>{});
+}
+
+// The top.count best hits of the last column (see TopK), best first;
+// the first one is the hit of dtw_rolling(D).
+template <class Pattern, class Norm = Accumulated, class Real>
+std::vector<Hit<Real>> dtw_rolling(MatrixView<const Real> D, const TopK& top, Isa isa = active_isa())
+{
+    if (D.empty())
+        throw std::invalid_argument("dtw: empty distance matrix");
+    return detail::rolling<Pattern, Norm, Real>(D.rows, D.cols, D.row_stride, isa,
+                                                [&](index_t n) { return &D(0, n); },
+                                                detail::BestHits<Pattern>{top});
+}
+
+// Pointer + leading-dimension form for column-major buffers.
+template <class Pattern, class Norm = Accumulated, class Real>
+Hit<Real> dtw_rolling(const Real* D, index_t M, index_t N, index_t ldd, Isa isa = active_isa())
+{
+    return dtw_rolling<Pattern, Norm>(column_major(D, M, N, ldd), isa);
+}
+
+} // namespace qbestd
@@ -0,0 +1,112 @@
+/*********************************************************************
+ * Work-stealing task runner for corpus-scale searches. Every worker owns
+ * a queue of task indices; it takes work from the front of its own queue
+ * and, once that is empty, steals from the back of the others. Tasks are
+ * coarse (a batch of queries against a chunk of utterances), so a mutex
+ * per queue costs nothing measurable.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "counters.hpp"
+
+namespace qbestd {
+
+// Number of workers for threads = 0: one per hardware thread.
+inline unsigned worker_count(unsigned threads = 0)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    return std::max(threads, 1u);
+}
+
+namespace detail {
+
+class TaskQueue {
+public:
+    void push(std::size_t task) { tasks_.push_back(task); }
+
+    bool pop_front(std::size_t& task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty())
+            return false;
+        task = tasks_.front();
+        tasks_.pop_front();
+        return true;
+    }
+
+    bool pop_back(std::size_t& task)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (tasks_.empty())
+            return false;
+        task = tasks_.back();
+        tasks_.pop_back();
+        return true;
+    }
+
+private:
+    std::mutex mutex_;
+    std::deque<std::size_t> tasks_;
+};
+
+} // namespace detail
+
+// Runs fn(task, worker) for task = 0..count-1 on worker_count(threads)
+// workers, worker 0 being the calling thread. Tasks are dealt round-robin
+// in index order, so callers list the expensive ones first. The first
+// exception thrown by a task is rethrown once all workers have stopped;
+// tasks not yet started are then skipped.
+template <class F>
+void run_tasks(std::size_t count, unsigned threads, F&& fn)
+{
+    const unsigned workers = unsigned(std::min<std::size_t>(worker_count(threads), std::max<std::size_t>(count, 1)));
+    std::vector<detail::TaskQueue> queues(workers);
+    for (std::size_t t = 0; t < count; ++t)
+        queues[t % workers].push(t);
+
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    auto work = [&](unsigned w) {
+        const detail::ThreadTimer alive(detail::Field::Worker);
+        std::size_t task;
+        for (;;) {
+            bool found = queues[w].pop_front(task);
+            for (unsigned k = 1; !found && k < workers; ++k)
+                found = queues[(w + k) % workers].pop_back(task);
+            if (!found || failed.load(std::memory_order_relaxed))
+                return;
+            try {
+                const detail::ThreadTimer busy(detail::Field::Busy);
+                fn(task, w);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(workers - 1);
+    for (unsigned w = 1; w < workers; ++w)
+        pool.emplace_back(work, w);
+    work(0);
+    for (std::thread& t : pool)
+        t.join();
+    if (error)
+        std::rethrow_exception(error);
+}
+
+} // namespace qbestd
@@ -0,0 +1,179 @@
+/*********************************************************************
+ * Per-thread scratch memory. Every call of the engine needs a few
+ * buffers (the rolling window, a column of D, kernel staging); a search
+ * over thousands of segments or utterances would allocate and free them
+ * thousands of times. Scratch<T>(n) borrows a 64-byte aligned block
+ * from a pool owned by the calling thread and hands it back when it
+ * goes out of scope, so after the first call of a given size nothing
+ * reaches the system allocator. scratch_stats() counts what did; the
+ * difference around a search is the memory it allocated.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "counters.hpp"
+
+namespace qbestd {
+
+// Counters of the calling thread's pool.
+struct ScratchStats {
+    std::size_t allocations = 0;  // blocks obtained from the system allocator
+    std::size_t bytes = 0;        // their total size
+    std::size_t held = 0;         // bytes the pool holds now, lent out or idle
+};
+
+namespace detail {
+
+class ScratchPool {
+public:
+    static constexpr std::align_val_t align{64};
+
+    struct Block {
+        void* data = nullptr;
+        std::size_t bytes = 0;
+    };
+
+    ScratchPool() { idle_.reserve(16); }
+    ScratchPool(const ScratchPool&) = delete;
+    ScratchPool& operator=(const ScratchPool&) = delete;
+    ~ScratchPool() { release(); }
+
+    // The smallest idle block of at least `bytes`. Failing that, the
+    // largest idle block is replaced by one of twice its size (at least
+    // `bytes`), so a growing workload settles after a few calls.
+    Block take(std::size_t bytes)
+    {
+        bytes = (std::max<std::size_t>(bytes, 1) + 63) / 64 * 64;
+        auto fit = idle_.end();
+        for (auto it = idle_.begin(); it != idle_.end(); ++it)
+            if (it->bytes >= bytes && (fit == idle_.end() || it->bytes < fit->bytes))
+                fit = it;
+        if (fit == idle_.end() && !idle_.empty()) {
+            fit = std::max_element(idle_.begin(), idle_.end(),
+                                   [](const Block& a, const Block& b) { return a.bytes < b.bytes; });
+            bytes = std::max(bytes, 2 * fit->bytes);
+            free(*fit);
+            fit->data = nullptr;
+        }
+        Block b;
+        if (fit != idle_.end() && fit->data) {
+            b = *fit;
+        } else {
+            b.data = ::operator new(bytes, align);
+            b.bytes = bytes;
+            ++stats_.allocations;
+            stats_.bytes += bytes;
+            stats_.held += bytes;
+            count_allocation(bytes);
+        }
+        if (fit != idle_.end())
+            idle_.erase(fit);
+        return b;
+    }
+
+    void give(Block b) { idle_.push_back(b); }
+
+    // Frees the idle blocks; lent ones come back as usual.
+    void release()
+    {
+        for (Block& b : idle_)
+            free(b);
+        idle_.clear();
+    }
+
+    const ScratchStats& stats() const { return stats_; }
+
+private:
+    void free(const Block& b)
+    {
+        ::operator delete(b.data, align);
+        stats_.held -= b.bytes;
+    }
+
+    std::vector<Block> idle_;
+    ScratchStats stats_;
+};
+
+inline ScratchPool& scratch_pool()
+{
+    thread_local ScratchPool pool;
+    return pool;
+}
+
+} // namespace detail
+
+// n elements of T from the calling thread's pool, 64-byte aligned. The
+// contents are unspecified unless a fill value is given.
+template <class T>
+class Scratch {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>,
+                  "scratch memory holds plain values");
+
+public:
+    Scratch() = default;
+    explicit Scratch(std::size_t n)
+    {
+        if (n > 0) {
+            block_ = detail::scratch_pool().take(n * sizeof(T));
+            size_ = n;
+        }
+    }
+    Scratch(std::size_t n, const T& fill) : Scratch(n) { std::fill(begin(), end(), fill); }
+
+    Scratch(Scratch&& other) noexcept
+        : block_(std::exchange(other.block_, {})), size_(std::exchange(other.size_, 0))
+    {
+    }
+    Scratch& operator=(Scratch&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            block_ = std::exchange(other.block_, {});
+            size_ = std::exchange(other.size_, 0);
+        }
+        return *this;
+    }
+    ~Scratch() { reset(); }
+
+    T* data() { return static_cast<T*>(block_.data); }
+    const T* data() const { return static_cast<const T*>(block_.data); }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](std::size_t i) { return data()[i]; }
+    const T& operator[](std::size_t i) const { return data()[i]; }
+    T* begin() { return data(); }
+    T* end() { return data() + size_; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size_; }
+
+private:
+    void reset()
+    {
+        if (block_.data)
+            detail::scratch_pool().give(block_);
+        block_ = {};
+        size_ = 0;
+    }
+
+    detail::ScratchPool::Block block_;
+    std::size_t size_ = 0;
+};
+
+inline ScratchStats scratch_stats()
+{
+    return detail::scratch_pool().stats();
+}
+
+// Returns the calling thread's idle scratch memory to the system.
+inline void release_scratch()
+{
+    detail::scratch_pool().release();
+}
+
+} // namespace qbestd
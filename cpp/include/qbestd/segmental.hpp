@@ -0,0 +1,94 @@
+/*********************************************************************
+ * Segmental DTW of Fx_do_SDTW.m in one sweep. Segment k covers rows
+ * k .. k+N2+R-1 of the N1 x N2 distance matrix D and is aligned with the
+ * DTW_c_skel_nobt recurrence (OpenEndDTW) inside the warping band
+ * |m - n| <= R, m and n counted from the segment start. The band replaces
+ * the additive Mask of masking_distMtrx_segDTW: cells outside it are +Inf
+ * in the recurrence and are never computed, so a segment costs
+ * N2 (2R+1) cells instead of N2 (N2+R). Neighbouring segments run in the
+ * SIMD lanes and share every load of D. Any Band (band.hpp), such as one
+ * with a slope for segments longer than the query, works the same way.
+ ********************************************************************/
+#pragma once
+
+#include <stdexcept>
+#include <vector>
+
+#include "band.hpp"
+#include "counters.hpp"
+#include "patterns.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+// Scores of `count` segments of `length` rows, segment k starting on
+// row k of D, each aligned with OpenEndDTW inside the band: dist[k] =
+// S/T at the end row and end[k] the 0-based end row within segment k.
+template <class Real>
+void segmental_dtw(MatrixView<const Real> D, const Band& band, index_t length, index_t count, Real* dist,
+                   index_t* end, Isa isa = active_isa())
+{
+    if (D.empty())
+        throw std::invalid_argument("segmental_dtw: empty distance matrix");
+    if (length < 1 || count < 1 || count - 1 + length > D.rows)
+        throw std::invalid_argument("segmental_dtw: segments do not fit in D");
+    detail::check_band(band);
+
+    const detail::StageTimer timer(Stage::Dp);
+    Scratch<index_t> lo(std::size_t(2 * D.cols));
+    index_t* hi = lo.data() + D.cols;
+    const auto [width, cells] = detail::band_rows(band, length, D.cols, End::Open, lo.data(), hi);
+    detail::count_cells(count * cells);
+    detail::count_pruned(count * (length * D.cols - cells));
+
+    using steps = OpenEndDTW::steps;
+    index_t k = 0;
+#if QBESTD_X86_SIMD
+    if constexpr (detail::simd_real<Real>) {
+        if (D.row_stride == 1 && isa == Isa::Avx512)
+            for (; k + Avx512<Real>::width <= count; k += Avx512<Real>::width)
+                detail::avx512::band_group<Avx512<Real>, Accumulated>(steps{}, D, lo.data(), hi, width, length, true,
+                                                                      k, dist + k, end + k);
+        if (D.row_stride == 1 && isa >= Isa::Avx2)
+            for (; k + Avx2<Real>::width <= count; k += Avx2<Real>::width)
+                detail::avx2::band_group<Avx2<Real>, Accumulated>(steps{}, D, lo.data(), hi, width, length, true, k,
+                                                                  dist + k, end + k);
+    }
+#endif
+    (void)isa;
+    for (; k < count; ++k)
+        detail::scalar::band_group<Scalar<Real>, Accumulated>(steps{}, D, lo.data(), hi, width, length, true, k,
+                                                              dist + k, end + k);
+}
+
+// Fx_do_SDTW: segments of N2+R rows in the band |m - n| <= R, count =
+// N1 - N2 - R of them.
+template <class Real>
+void segmental_dtw(MatrixView<const Real> D, index_t R, index_t count, Real* dist, index_t* end,
+                   Isa isa = active_isa())
+{
+    if (R < 0)
+        throw std::invalid_argument("segmental_dtw: negative warping window");
+    segmental_dtw(D, Band{R}, D.cols + R, count, dist, end, isa);
+}
+
+template <class Real>
+struct Segments {
+    std::vector<Real> dist;
+    std::vector<index_t> end;
+};
+
+// All N1 - N2 - R segments of Fx_do_SDTW.
+template <class Real>
+Segments<Real> segmental_dtw(MatrixView<const Real> D, index_t R, Isa isa = active_isa())
+{
+    const index_t count = D.rows - D.cols - R;
+    Segments<Real> out{std::vector<Real>(std::size_t(count > 0 ? count : 0)),
+                       std::vector<index_t>(std::size_t(count > 0 ? count : 0))};
+    segmental_dtw(D, R, count, out.dist.data(), out.end.data(), isa);
+    return out;
+}
+
+} // namespace qbestd
@@ -0,0 +1,388 @@
+/*********************************************************************
+ * Thin SIMD layer for the DP kernels: one traits struct per instruction
+ * set with the handful of operations the recurrence needs, and runtime
+ * selection of the widest set the CPU supports. Code for a given set is
+ * compiled between QBESTD_PUSH_TARGET_* and QBESTD_POP_TARGET, so no
+ * global -mavx2 is required and the same binary runs without AVX.
+ * AVX-512 brings FMA along; GCC would then fuse the separate mul and add
+ * of the kernels, so contraction is switched off inside the regions to
+ * keep every set bit-identical to the scalar code.
+ ********************************************************************/
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
+
+#include "types.hpp"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define QBESTD_X86_SIMD 1
+#include <immintrin.h>
+#if defined(__clang__)
+#define QBESTD_PUSH_TARGET_AVX2 \
+    _Pragma("clang attribute push(__attribute__((target(\"avx2\"))), apply_to = function)")
+#define QBESTD_PUSH_TARGET_AVX512 \
+    _Pragma("clang attribute push(__attribute__((target(\"avx512f\"))), apply_to = function)")
+#define QBESTD_POP_TARGET _Pragma("clang attribute pop")
+#else
+#define QBESTD_PUSH_TARGET_AVX2                                 \
+    _Pragma("GCC push_options") _Pragma("GCC target(\"avx2\")") \
+        _Pragma("GCC optimize(\"fp-contract=off\")")
+#define QBESTD_PUSH_TARGET_AVX512                                  \
+    _Pragma("GCC push_options") _Pragma("GCC target(\"avx512f\")") \
+        _Pragma("GCC optimize(\"fp-contract=off\")")
+#define QBESTD_POP_TARGET _Pragma("GCC pop_options")
+#endif
+#else
+#define QBESTD_X86_SIMD 0
+#endif
+
+namespace qbestd {
+
+enum class Isa { Scalar, Avx2, Avx512 };
+
+inline const char* isa_name(Isa isa)
+{
+    switch (isa) {
+    case Isa::Avx512: return "avx512";
+    case Isa::Avx2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+// Widest instruction set of this CPU.
+inline Isa detect_isa()
+{
+#if QBESTD_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+        return Isa::Avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return Isa::Avx2;
+#endif
+    return Isa::Scalar;
+}
+
+namespace detail {
+
+inline Isa& isa_setting()
+{
+    static Isa isa = [] {
+        const Isa best = detect_isa();
+        const char* env = std::getenv("QBESTD_ISA");
+        if (env == nullptr)
+            return best;
+        Isa want = best;
+        if (std::strcmp(env, "scalar") == 0)
+            want = Isa::Scalar;
+        else if (std::strcmp(env, "avx2") == 0)
+            want = Isa::Avx2;
+        return want < best ? want : best;
+    }();
+    return isa;
+}
+
+} // namespace detail
+
+// Instruction set used by the dispatching kernels: the detected one,
+// lowered by QBESTD_ISA=scalar|avx2 or set_isa() for comparisons.
+inline Isa active_isa() { return detail::isa_setting(); }
+
+inline void set_isa(Isa isa)
+{
+    const Isa best = detect_isa();
+    detail::isa_setting() = isa < best ? isa : best;
+}
+
+namespace detail {
+
+// Element types with vector traits for every kernel; the fixed-point
+// std::uint16_t only has the Accumulated column kernel (kernels.hpp).
+template <class Real>
+constexpr bool simd_real = std::is_same_v<Real, double> || std::is_same_v<Real, float>;
+
+} // namespace detail
+
+// Width-1 stand-in for the vector traits below, for kernels written once
+// against the traits interface.
+template <class Real>
+struct Scalar {
+    using reg = Real;
+    using mask = bool;
+    static constexpr int width = 1;
+
+    static reg zero() { return Real(0); }
+    static reg set1(Real x) { return x; }
+    static reg load(const Real* p) { return *p; }
+    static void store(Real* p, reg x) { *p = x; }
+    static reg add(reg a, reg b) { return a + b; }
+    static reg sub(reg a, reg b) { return a - b; }
+    static reg mul(reg a, reg b) { return a * b; }
+    static reg div(reg a, reg b) { return a / b; }
+    static reg max(reg a, reg b) { return a > b ? a : b; }
+    static mask lt(reg a, reg b) { return a < b; }
+    static reg blend(mask k, reg a, reg b) { return k ? a : b; }
+    static Real sum(reg x) { return x; }
+    static reg frexp(reg x, reg& e)
+    {
+        int i;
+        const Real m = std::frexp(x, &i);
+        e = Real(i);
+        return m;
+    }
+
+    // 64-bit words of the packed layout (rolling.hpp)
+    using ireg = std::uint64_t;
+    static ireg iload(const std::uint64_t* p) { return *p; }
+    static void istore(std::uint64_t* p, ireg x) { *p = x; }
+    static ireg iset1(std::uint64_t x) { return x; }
+    static ireg iadd(ireg a, ireg b) { return a + b; }
+    static ireg iblend(mask k, ireg a, ireg b) { return k ? a : b; }
+    // Upper 32 bits as a number.
+    static reg high(ireg x) { return Real(x >> 32); }
+};
+
+#if QBESTD_X86_SIMD
+
+QBESTD_PUSH_TARGET_AVX2
+
+template <class Real>
+struct Avx2;
+
+template <>
+struct Avx2<double> {
+    using reg = __m256d;
+    using mask = __m256d;
+    static constexpr int width = 4;
+
+    static reg zero() { return _mm256_setzero_pd(); }
+    static reg set1(double x) { return _mm256_set1_pd(x); }
+    static reg load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, reg x) { _mm256_storeu_pd(p, x); }
+    static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+    static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+    static mask lt(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+    // Lanes of a where the mask is set, b elsewhere.
+    static reg blend(mask k, reg a, reg b) { return _mm256_blendv_pd(b, a, k); }
+    // p[0], p[stride], p[2*stride], p[3*stride]
+    static reg gather(const double* p, index_t stride)
+    {
+        const __m256i idx = _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0);
+        return _mm256_i64gather_pd(p, idx, 8);
+    }
+    // Horizontal sum of the lanes.
+    static double sum(reg x)
+    {
+        const __m128d h = _mm_add_pd(_mm256_castpd256_pd128(x), _mm256_extractf128_pd(x, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+    }
+    // x = m * 2^e with m in [0.5, 1), for positive normal x. The exponent
+    // field becomes a double by OR-ing it into the mantissa of 2^52.
+    static reg frexp(reg x, reg& e)
+    {
+        const __m256i bits = _mm256_castpd_si256(x);
+        const __m256d two52 = _mm256_set1_pd(4503599627370496.0);
+        const __m256i field = _mm256_or_si256(_mm256_srli_epi64(bits, 52), _mm256_castpd_si256(two52));
+        e = _mm256_sub_pd(_mm256_castsi256_pd(field), _mm256_set1_pd(4503599627370496.0 + 1022));
+        const __m256i mant = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi64x(0x000FFFFFFFFFFFFF)),
+                                             _mm256_set1_epi64x(0x3FE0000000000000));
+        return _mm256_castsi256_pd(mant);
+    }
+
+    using ireg = __m256i;
+    static ireg iload(const std::uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void istore(std::uint64_t* p, ireg x) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x); }
+    static ireg iset1(std::uint64_t x) { return _mm256_set1_epi64x((long long)x); }
+    static ireg iadd(ireg a, ireg b) { return _mm256_add_epi64(a, b); }
+    static ireg iblend(mask k, ireg a, ireg b)
+    {
+        return _mm256_castpd_si256(_mm256_blendv_pd(_mm256_castsi256_pd(b), _mm256_castsi256_pd(a), k));
+    }
+    // Upper halves (below 2^31) gathered into four int32 and widened.
+    static reg high(ireg x)
+    {
+        const __m256i odd = _mm256_permutevar8x32_epi32(x, _mm256_setr_epi32(1, 3, 5, 7, 1, 3, 5, 7));
+        return _mm256_cvtepi32_pd(_mm256_castsi256_si128(odd));
+    }
+};
+
+template <>
+struct Avx2<float> {
+    using reg = __m256;
+    using mask = __m256;
+    static constexpr int width = 8;
+
+    static reg zero() { return _mm256_setzero_ps(); }
+    static reg set1(float x) { return _mm256_set1_ps(x); }
+    static reg load(const float* p) { return _mm256_loadu_ps(p); }
+    static void store(float* p, reg x) { _mm256_storeu_ps(p, x); }
+    static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    static mask lt(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    static reg blend(mask k, reg a, reg b) { return _mm256_blendv_ps(b, a, k); }
+    static reg gather(const float* p, index_t stride)
+    {
+        const int s = int(stride);
+        const __m256i idx = _mm256_set_epi32(7 * s, 6 * s, 5 * s, 4 * s, 3 * s, 2 * s, s, 0);
+        return _mm256_i32gather_ps(p, idx, 4);
+    }
+    static float sum(reg x)
+    {
+        __m128 h = _mm_add_ps(_mm256_castps256_ps128(x), _mm256_extractf128_ps(x, 1));
+        h = _mm_add_ps(h, _mm_movehl_ps(h, h));
+        return _mm_cvtss_f32(_mm_add_ss(h, _mm_movehdup_ps(h)));
+    }
+    // As for double, with the 23-bit mantissa of float and 2^23.
+    static reg frexp(reg x, reg& e)
+    {
+        const __m256i bits = _mm256_castps_si256(x);
+        const __m256i field = _mm256_or_si256(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(0x4B000000));
+        e = _mm256_sub_ps(_mm256_castsi256_ps(field), _mm256_set1_ps(8388608.0f + 126));
+        const __m256i mant = _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                             _mm256_set1_epi32(0x3F000000));
+        return _mm256_castsi256_ps(mant);
+    }
+};
+
+// Fixed-point costs: saturating unsigned 16-bit lanes. Only what the
+// Accumulated column kernel needs; there is no division or gather.
+template <>
+struct Avx2<std::uint16_t> {
+    using reg = __m256i;
+    using mask = __m256i;
+    static constexpr int width = 16;
+
+    static reg zero() { return _mm256_setzero_si256(); }
+    static reg set1(std::uint16_t x) { return _mm256_set1_epi16(short(x)); }
+    static reg load(const std::uint16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(std::uint16_t* p, reg x) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), x); }
+    static reg add(reg a, reg b) { return _mm256_adds_epu16(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_subs_epu16(a, b); }
+    // Saturates where the product needs more than 16 bits.
+    static reg mul(reg a, reg b)
+    {
+        const __m256i high = _mm256_cmpeq_epi16(_mm256_mulhi_epu16(a, b), _mm256_setzero_si256());
+        return _mm256_blendv_epi8(_mm256_set1_epi16(-1), _mm256_mullo_epi16(a, b), high);
+    }
+    static reg max(reg a, reg b) { return _mm256_max_epu16(a, b); }
+    // a < b unsigned: max(a, b) is b and a differs from b.
+    static mask lt(reg a, reg b)
+    {
+        return _mm256_andnot_si256(_mm256_cmpeq_epi16(a, b), _mm256_cmpeq_epi16(_mm256_max_epu16(a, b), b));
+    }
+    static reg blend(mask k, reg a, reg b) { return _mm256_blendv_epi8(b, a, k); }
+};
+
+QBESTD_POP_TARGET
+QBESTD_PUSH_TARGET_AVX512
+
+template <class Real>
+struct Avx512;
+
+template <>
+struct Avx512<double> {
+    using reg = __m512d;
+    using mask = __mmask8;
+    static constexpr int width = 8;
+
+    static reg zero() { return _mm512_setzero_pd(); }
+    static reg set1(double x) { return _mm512_set1_pd(x); }
+    static reg load(const double* p) { return _mm512_loadu_pd(p); }
+    static void store(double* p, reg x) { _mm512_storeu_pd(p, x); }
+    static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+    // The masked forms below avoid GCC 12's -Wmaybe-uninitialized on the
+    // undefined pass-through of the unmasked ones.
+    static reg max(reg a, reg b) { return _mm512_mask_max_pd(a, 0xFF, a, b); }
+    static mask lt(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+    static reg blend(mask k, reg a, reg b) { return _mm512_mask_blend_pd(k, b, a); }
+    static reg gather(const double* p, index_t stride)
+    {
+        const __m512i idx = _mm512_set_epi64(7 * stride, 6 * stride, 5 * stride, 4 * stride,
+                                             3 * stride, 2 * stride, stride, 0);
+        return _mm512_mask_i64gather_pd(_mm512_setzero_pd(), 0xFF, idx, p, 8);
+    }
+    // Through memory: GCC's _mm512_reduce_add_pd warns about an undefined
+    // lane in its 256-bit extract.
+    static double sum(reg x)
+    {
+        alignas(64) double t[8];
+        _mm512_store_pd(t, x);
+        return ((t[0] + t[4]) + (t[2] + t[6])) + ((t[1] + t[5]) + (t[3] + t[7]));
+    }
+    static reg frexp(reg x, reg& e)
+    {
+        e = _mm512_add_pd(_mm512_mask_getexp_pd(x, 0xFF, x), _mm512_set1_pd(1.0));
+        return _mm512_mask_getmant_pd(x, 0xFF, x, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_src);
+    }
+
+    using ireg = __m512i;
+    static ireg iload(const std::uint64_t* p) { return _mm512_loadu_si512(p); }
+    static void istore(std::uint64_t* p, ireg x) { _mm512_storeu_si512(p, x); }
+    static ireg iset1(std::uint64_t x) { return _mm512_set1_epi64((long long)x); }
+    static ireg iadd(ireg a, ireg b) { return _mm512_add_epi64(a, b); }
+    static ireg iblend(mask k, ireg a, ireg b) { return _mm512_mask_blend_epi64(k, b, a); }
+    static reg high(ireg x)
+    {
+        const __m512i odd = _mm512_mask_permutexvar_epi32(
+            x, 0xFFFF, _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 1, 3, 5, 7, 9, 11, 13, 15), x);
+        return _mm512_mask_cvtepi32_pd(_mm512_setzero_pd(), 0xFF,
+                                       _mm512_mask_extracti64x4_epi64(_mm256_setzero_si256(), 0xF, odd, 0));
+    }
+};
+
+template <>
+struct Avx512<float> {
+    using reg = __m512;
+    using mask = __mmask16;
+    static constexpr int width = 16;
+
+    static reg zero() { return _mm512_setzero_ps(); }
+    static reg set1(float x) { return _mm512_set1_ps(x); }
+    static reg load(const float* p) { return _mm512_loadu_ps(p); }
+    static void store(float* p, reg x) { _mm512_storeu_ps(p, x); }
+    static reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+    static reg max(reg a, reg b) { return _mm512_mask_max_ps(a, 0xFFFF, a, b); }
+    static mask lt(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+    static reg blend(mask k, reg a, reg b) { return _mm512_mask_blend_ps(k, b, a); }
+    static reg gather(const float* p, index_t stride)
+    {
+        const __m512i idx = _mm512_mullo_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0),
+                                               _mm512_set1_epi32(int(stride)));
+        return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), 0xFFFF, idx, p, 4);
+    }
+    static float sum(reg x)
+    {
+        alignas(64) float t[16];
+        _mm512_store_ps(t, x);
+        for (int w = 8; w > 0; w /= 2)
+            for (int i = 0; i < w; ++i)
+                t[i] += t[i + w];
+        return t[0];
+    }
+    static reg frexp(reg x, reg& e)
+    {
+        e = _mm512_add_ps(_mm512_mask_getexp_ps(x, 0xFFFF, x), _mm512_set1_ps(1.0f));
+        return _mm512_mask_getmant_ps(x, 0xFFFF, x, _MM_MANT_NORM_p5_1, _MM_MANT_SIGN_src);
+    }
+};
+
+QBESTD_POP_TARGET
+
+#endif // QBESTD_X86_SIMD
+
+} // namespace qbestd
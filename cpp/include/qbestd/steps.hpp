@@ -0,0 +1,118 @@
+/*********************************************************************
+ * Compile-time step lists. A step (dm, dn, weight) reaches cell (m,n)
+ * from (m-dm, n-dn), adds weight*D(m,n) to the cost and weight to the
+ * path length. relax() expands a StepList into straight-line code: one
+ * candidate per step, selected with conditional moves instead of the
+ * if-chains of the old min_fun_ind. Steps are listed in tie-breaking
+ * order; a later step only wins when it is strictly better.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+
+#include "types.hpp"
+
+namespace qbestd {
+
+template <index_t DM, index_t DN, int W = 1>
+struct Step {
+    static_assert(DM >= 0 && DN >= 0 && DM + DN > 0, "a step must move backwards");
+    static_assert(W > 0, "step weights must be positive");
+    static constexpr index_t dm = DM;
+    static constexpr index_t dn = DN;
+    static constexpr int weight = W;
+};
+
+template <class... Steps>
+struct StepList {
+    static_assert(sizeof...(Steps) > 0, "empty step list");
+    static constexpr std::size_t size = sizeof...(Steps);
+    static constexpr index_t max_dm = std::max({Steps::dm...});
+    static constexpr index_t max_dn = std::max({Steps::dn...});
+    static constexpr index_t min_dn = std::min({Steps::dn...});
+    // Largest anti-diagonal distance dm+dn to a predecessor.
+    static constexpr index_t reach = std::max({Steps::dm + Steps::dn...});
+    // Every step adds D(m,n) once and 1 to the path length.
+    static constexpr bool unit_weights = ((Steps::weight == 1) && ...);
+    static constexpr int max_weight = std::max({Steps::weight...});
+};
+
+// Best predecessor of one cell, carried through the unrolled selection.
+template <class Real>
+struct Candidate {
+    Real cost;
+    Real len;
+    Real key;
+    Real start;
+};
+
+namespace detail {
+
+// Calls f(dm, dn) for every step of the list.
+template <class F, class... Steps>
+void for_each_step(StepList<Steps...>, F&& f)
+{
+    (f(Steps::dm, Steps::dn), ...);
+}
+
+// a + b; fixed-point (unsigned integer) costs saturate instead of
+// wrapping, like the vector kernels' adds.
+template <class Real>
+inline Real accumulate(Real a, Real b)
+{
+    if constexpr (std::is_integral_v<Real>) {
+        const Real sum = Real(a + b);
+        return sum < a ? std::numeric_limits<Real>::max() : sum;
+    } else {
+        return a + b;
+    }
+}
+
+template <class Stp, class Real>
+inline Real weighted(Real d)
+{
+    if constexpr (Stp::weight == 1)
+        return d;
+    else if constexpr (std::is_integral_v<Real>)
+        return Real(std::min<unsigned long>(static_cast<unsigned long>(Stp::weight) * d,
+                                            std::numeric_limits<Real>::max()));
+    else
+        return Real(Stp::weight) * d;
+}
+
+template <class Stp, class Norm, class Real>
+inline Candidate<Real> candidate(index_t m, index_t n, Real d, const MatrixView<Real>& S,
+                                 const MatrixView<Real>& T, const MatrixView<Real>& P)
+{
+    const index_t pm = m - Stp::dm, pn = n - Stp::dn;
+    const Real cost = accumulate(S(pm, pn), weighted<Stp>(d));
+    const Real len = accumulate(T(pm, pn), Real(Stp::weight));
+    return {cost, len, Norm::key(cost, len), P(pm, pn)};
+}
+
+template <class Real>
+inline void select(Candidate<Real>& best, const Candidate<Real>& c)
+{
+    const bool better = c.key < best.key;
+    best.cost = better ? c.cost : best.cost;
+    best.len = better ? c.len : best.len;
+    best.key = better ? c.key : best.key;
+    best.start = better ? c.start : best.start;
+}
+
+} // namespace detail
+
+template <class Norm, class Real, class First, class... Rest>
+inline Candidate<Real> relax(StepList<First, Rest...>, index_t m, index_t n, Real d,
+                             const MatrixView<Real>& S, const MatrixView<Real>& T,
+                             const MatrixView<Real>& P)
+{
+    Candidate<Real> best = detail::candidate<First, Norm>(m, n, d, S, T, P);
+    (detail::select(best, detail::candidate<Rest, Norm>(m, n, d, S, T, P)), ...);
+    return best;
+}
+
+} // namespace qbestd
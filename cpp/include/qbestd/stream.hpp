@@ -0,0 +1,173 @@
+/*********************************************************************
+ * Online search over a live reference stream. StreamSearch holds one
+ * query and advances the recurrence by one reference frame (one row of
+ * D) at a time, keeping only the rows a step can reach back to. Every
+ * row completes an end point of the last query column; end points with
+ * S/T below the threshold are reported once their run of overlapping
+ * end points is over, so the per-frame work is O(N) and a detection is
+ * delayed only by the length of the occurrence itself. The rows are the
+ * same as those of dtw<Pattern, Norm>() on the whole stream, so the
+ * *_online kernels (Norm = Normalized) run here unchanged. The state is
+ * double only: P and T hold frame numbers of an unbounded stream, which
+ * a float stops representing exactly after 2^24 frames, and with them
+ * the overlap test that separates detections.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "counters.hpp"
+#include "distance.hpp"
+#include "patterns.hpp"
+#include "rolling.hpp"
+#include "simd.hpp"
+#include "steps.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+template <class Pattern, class Norm = Accumulated>
+class StreamSearch {
+    static_assert(Pattern::end == End::Open, "streaming needs an open end");
+
+public:
+    // query is ND x N; frames pushed later must have ND rows as well.
+    StreamSearch(MatrixView<const double> query, Metric metric, double threshold, Isa isa = active_isa())
+        : metric_(metric), threshold_(threshold), isa_(isa), qry_(query, metric),
+          window_(query.cols, std::max<index_t>(Pattern::steps::max_dm, 1) + 1),
+          d_(std::size_t(query.cols))
+    {
+        if (query.empty())
+            throw std::invalid_argument("stream: empty query");
+    }
+
+    // Advances over the reference frames (ND x count) and appends the
+    // detections they complete to out, in stream order.
+    void push(MatrixView<const double> frames, std::vector<Hit<double>>& out)
+    {
+        if (frames.cols == 0)
+            return;
+        if (frames.rows != qry_.dims)
+            throw std::invalid_argument("stream: frame dimensions do not match the query");
+        const detail::StageTimer timer(Stage::Dp);
+        detail::count_cells(frames.cols * qry_.count);
+        const detail::Frames<double> chunk(frames, metric_);
+        for (index_t f = 0; f < chunk.count; ++f) {
+            detail::distance_column(isa_, qry_, chunk, f, d_.data());
+            row();
+            detect(out);
+            ++m_;
+        }
+    }
+
+    // End of stream: reports a detection still waiting for its run to end.
+    void flush(std::vector<Hit<double>>& out)
+    {
+        if (pending_) {
+            out.push_back(best_);
+            pending_ = false;
+        }
+    }
+
+    // Reference frames consumed so far.
+    index_t frames() const { return m_; }
+
+    // End point of the latest frame: S/T at the last query column.
+    Hit<double> last() const { return last_; }
+
+private:
+    // Row m_ of S, T and P. The window keeps rows as its columns; the
+    // transposed views index them as (row, query frame) like dtw().
+    void row()
+    {
+        const index_t N = qry_.count;
+        window_.advance(m_);
+        const MatrixView<double> S = transpose(window_.S(m_)), T = transpose(window_.T(m_)),
+                               P = transpose(window_.P(m_));
+        const index_t j = S.rows - 1;
+        const double* d = d_.data();
+
+        if constexpr (Pattern::start == Start::Free) {
+            S(j, 0) = d[0];
+            T(j, 0) = 1;
+            P(j, 0) = double(m_);
+        } else if (m_ == 0) {
+            S(j, 0) = d[0];
+            T(j, 0) = 1;
+            P(j, 0) = 0;
+        } else {
+            S(j, 0) = S(j - 1, 0) + d[0];
+            T(j, 0) = double(m_ + 1);
+            P(j, 0) = 0;
+        }
+
+        if (m_ < Pattern::first_row) {
+            // First row(s): horizontal accumulation only
+            for (index_t n = 1; n < N; ++n) {
+                S(j, n) = S(j, n - 1) + d[n];
+                T(j, n) = T(j, n - 1) + 1;
+                P(j, n) = P(j, n - 1);
+            }
+            return;
+        }
+
+        if constexpr (Pattern::first_col > 1) {
+            // The boundary rule fills row 1 of two-row views, i.e. row m_;
+            // the zero row stride maps both rows of Dr onto this row of D.
+            auto rows = [&](MatrixView<double> X) {
+                return MatrixView<double>{&X(j - 1, 0), 2, X.cols, X.row_stride, X.col_stride};
+            };
+            const MatrixView<const double> Dr{d, 2, N, 0, 1};
+            for (index_t n = 1; n < std::min<index_t>(Pattern::first_col, N); ++n)
+                Pattern::template boundary_column<Norm>(n, Dr, rows(S), rows(T), rows(P));
+        }
+
+        for (index_t n = Pattern::first_col; n < N; ++n) {
+            const Candidate<double> best = relax<Norm>(typename Pattern::steps{}, j, n, d[n], S, T, P);
+            S(j, n) = best.cost;
+            T(j, n) = best.len;
+            P(j, n) = best.start;
+        }
+    }
+
+    // Consecutive end points below the threshold are one occurrence while
+    // their rows overlap its best end point so far; that one is reported
+    // when the run ends.
+    void detect(std::vector<Hit<double>>& out)
+    {
+        const index_t N = qry_.count;
+        const MatrixView<double> S = transpose(window_.S(m_)), T = transpose(window_.T(m_)),
+                               P = transpose(window_.P(m_));
+        const index_t j = S.rows - 1;
+        last_ = Hit<double>{S(j, N - 1) / T(j, N - 1), index_t(P(j, N - 1)), m_};
+
+        if (!(last_.dist < threshold_)) {
+            flush(out);
+            return;
+        }
+        if (pending_ && last_.start > best_.end)
+            flush(out);
+        if (!pending_ || last_.dist < best_.dist)
+            best_ = last_;
+        pending_ = true;
+    }
+
+    static MatrixView<double> transpose(MatrixView<double> X)
+    {
+        return MatrixView<double>{X.data, X.cols, X.rows, X.col_stride, X.row_stride};
+    }
+
+    Metric metric_;
+    double threshold_;
+    Isa isa_;
+    detail::Frames<double> qry_;
+    detail::ColumnWindow<double> window_;
+    std::vector<double> d_;
+    index_t m_ = 0;
+    Hit<double> last_, best_;
+    bool pending_ = false;
+};
+
+} // namespace qbestd
@@ -0,0 +1,60 @@
+/*********************************************************************
+ * Basic types shared by the DTW engine: index type, strided matrix
+ * views over caller-owned memory and the detection records.
+ ********************************************************************/
+#pragma once
+
+#include <cstddef>
+#include <limits>
+
+namespace qbestd {
+
+using index_t = std::ptrdiff_t;
+
+// Strided 2-D view over memory owned by the caller. Element (m,n) lives at
+// data[m*row_stride + n*col_stride], so the MATLAB layout m+M*n is
+// row_stride = 1, col_stride = M.
+template <class T>
+struct MatrixView {
+    T* data = nullptr;
+    index_t rows = 0;
+    index_t cols = 0;
+    index_t row_stride = 1;
+    index_t col_stride = 0;
+
+    T& operator()(index_t m, index_t n) const { return data[m * row_stride + n * col_stride]; }
+    bool empty() const { return data == nullptr || rows == 0 || cols == 0; }
+};
+
+// Column-major view; ld is the distance between columns (defaults to rows).
+template <class T>
+MatrixView<T> column_major(T* data, index_t rows, index_t cols, index_t ld = 0)
+{
+    return MatrixView<T>{data, rows, cols, 1, ld ? ld : rows};
+}
+
+// One detection: normalized distance S/T at the end point and the
+// 0-based start (from P) and end rows of the reference.
+template <class Real>
+struct Hit {
+    Real dist = Real(0);
+    index_t start = 0;
+    index_t end = 0;
+};
+
+// Several detections per call: up to `count` end rows, best first. A hit
+// is suppressed when its rows [start, end] overlap those of a better one
+// by more than max_overlap (intersection over union), so 0 keeps only
+// disjoint detections.
+struct TopK {
+    std::size_t count = 1;
+    double max_overlap = 0.0;
+};
+
+// Early-abandon threshold: only a hit with dist below `dist` is wanted,
+// typically the worst of the hits a search has kept so far.
+struct BestSoFar {
+    double dist = std::numeric_limits<double>::infinity();
+};
+
+} // namespace qbestd
@@ -0,0 +1,248 @@
+/*********************************************************************
+ * Vector-quantized references. train_codebook() learns K centers from
+ * reference frames by splitting k-means, as python/k-means.py does:
+ * start from the mean, split centers in two, refine with Lloyd
+ * iterations and repeat until there are K. encode() then stores every
+ * reference frame as the index of its nearest center, one byte for
+ * K <= 256 instead of dims floats.
+ *
+ * At query time CodeDistance computes the K x N distances between the
+ * centers and the query frames once. Column n of D is then one table
+ * lookup per reference frame, whatever the feature dimension, and
+ * dtw_features() runs on it as on a FrameDistance. The result is the
+ * search of the query in the reference rebuilt from its centers.
+ ********************************************************************/
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "distance.hpp"
+#include "distance_matrix.hpp"
+#include "fused.hpp"
+#include "patterns.hpp"
+#include "scratch.hpp"
+#include "simd.hpp"
+#include "types.hpp"
+
+namespace qbestd {
+
+struct CodebookOptions {
+    index_t size = 256;       // centers
+    int max_iter = 50;        // Lloyd iterations after each split
+    double tolerance = 1e-4;  // refinement stops when the distortion drops by less (relative)
+    double split = 0.01;      // a center c splits into c * (1 - split) and c * (1 + split)
+    Isa isa = active_isa();
+};
+
+// K centers of dims values each, one per column.
+template <class Real>
+struct Codebook {
+    index_t dims = 0;
+    index_t size = 0;
+    std::vector<Real> centers;
+
+    MatrixView<const Real> view() const { return column_major(centers.data(), dims, size); }
+};
+
+namespace detail {
+
+// Frames per block of the frame x center distances.
+inline constexpr index_t vq_block = 4096;
+
+// Nearest center of every frame (the first on ties) and its distance;
+// returns the sum of those distances.
+template <class Real, class Index>
+double nearest_centers(MatrixView<const Real> centers, MatrixView<const Real> frames, Metric metric, Isa isa,
+                       Index* nearest, Real* best)
+{
+    const index_t K = centers.cols;
+    Scratch<Real> D(std::size_t(K * std::min(vq_block, frames.cols)));
+    double total = 0;
+    for (index_t f0 = 0; f0 < frames.cols; f0 += vq_block) {
+        const index_t count = std::min(vq_block, frames.cols - f0);
+        const MatrixView<const Real> block{&frames(0, f0), frames.rows, count, frames.row_stride,
+                                           frames.col_stride};
+        distance_matrix(centers, block, metric, column_major(D.data(), K, count), isa);
+        for (index_t j = 0; j < count; ++j) {
+            const Real* d = D.data() + j * K;
+            const index_t k = index_t(std::min_element(d, d + K) - d);
+            nearest[f0 + j] = Index(k);
+            best[f0 + j] = d[k];
+            total += double(d[k]);
+        }
+    }
+    return total;
+}
+
+} // namespace detail
+
+// Splitting k-means over the frames (dims x count, one per column) under
+// `metric`. Centers left without frames restart on the frame farthest
+// from its center.
+template <class Real>
+Codebook<Real> train_codebook(MatrixView<const Real> frames, Metric metric, const CodebookOptions& opt = {})
+{
+    const index_t dims = frames.rows, F = frames.cols;
+    if (frames.empty())
+        throw std::invalid_argument("vq: empty feature matrix");
+    if (opt.size < 1 || opt.size > F)
+        throw std::invalid_argument("vq: codebook size must be between 1 and the number of frames");
+
+    Codebook<Real> cb{dims, 1, std::vector<Real>(static_cast<std::size_t>(dims))};
+    std::vector<double> sum(std::size_t(dims * opt.size));
+    std::vector<index_t> count(static_cast<std::size_t>(opt.size)), nearest(static_cast<std::size_t>(F));
+    std::vector<Real> best(static_cast<std::size_t>(F));
+    std::vector<double> distortion(std::size_t(opt.size));
+
+    // Centers become the means of their frames
+    auto update = [&] {
+        std::fill(sum.begin(), sum.end(), 0.0);
+        std::fill(count.begin(), count.end(), 0);
+        std::fill(distortion.begin(), distortion.end(), 0.0);
+        for (index_t f = 0; f < F; ++f) {
+            const index_t k = nearest[std::size_t(f)];
+            for (index_t d = 0; d < dims; ++d)
+                sum[std::size_t(k * dims + d)] += double(frames(d, f));
+            ++count[std::size_t(k)];
+            distortion[std::size_t(k)] += double(best[std::size_t(f)]);
+        }
+        for (index_t k = 0; k < cb.size; ++k) {
+            Real* c = cb.centers.data() + k * dims;
+            if (count[std::size_t(k)] > 0) {
+                for (index_t d = 0; d < dims; ++d)
+                    c[d] = Real(sum[std::size_t(k * dims + d)] / double(count[std::size_t(k)]));
+                continue;
+            }
+            const index_t far = index_t(std::max_element(best.begin(), best.end()) - best.begin());
+            for (index_t d = 0; d < dims; ++d)
+                c[d] = frames(d, far);
+            best[std::size_t(far)] = Real(0);
+        }
+    };
+
+    std::fill(nearest.begin(), nearest.end(), 0);
+    std::fill(best.begin(), best.end(), Real(0));
+    update();
+    for (;;) {
+        double previous = 0;
+        for (int it = 0; it < opt.max_iter; ++it) {
+            const double total =
+                detail::nearest_centers(cb.view(), frames, metric, opt.isa, nearest.data(), best.data());
+            update();
+            if (it > 0 && previous - total <= opt.tolerance * std::abs(previous))
+                break;
+            previous = total;
+        }
+        if (cb.size == opt.size)
+            return cb;
+
+        // Split the centers that explain the most distortion
+        const index_t splits = std::min(cb.size, opt.size - cb.size);
+        std::vector<index_t> order(std::size_t(cb.size));
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](index_t a, index_t b) {
+            return distortion[std::size_t(a)] > distortion[std::size_t(b)];
+        });
+        cb.centers.resize(std::size_t(dims * (cb.size + splits)));
+        for (index_t s = 0; s < splits; ++s) {
+            Real* c = cb.centers.data() + order[std::size_t(s)] * dims;
+            Real* twin = cb.centers.data() + (cb.size + s) * dims;
+            for (index_t d = 0; d < dims; ++d) {
+                twin[d] = c[d] * Real(1 + opt.split);
+                c[d] *= Real(1 - opt.split);
+            }
+        }
+        cb.size += splits;
+    }
+}
+
+// Index of the nearest center of every frame.
+template <class Code = std::uint8_t, class Real>
+std::vector<Code> encode(const Codebook<Real>& codebook, MatrixView<const Real> frames, Metric metric,
+                         Isa isa = active_isa())
+{
+    static_assert(std::is_integral_v<Code> && std::is_unsigned_v<Code>, "codes are unsigned integers");
+    if (std::uint64_t(codebook.size) - 1 > std::numeric_limits<Code>::max())
+        throw std::invalid_argument("vq: codebook too large for the code type");
+    if (frames.empty())
+        throw std::invalid_argument("vq: empty feature matrix");
+    if (frames.rows != codebook.dims)
+        throw std::invalid_argument("vq: frame and codebook dimensions differ");
+    std::vector<Code> codes(std::size_t(frames.cols));
+    Scratch<Real> best(codes.size());
+    detail::nearest_centers(codebook.view(), frames, metric, isa, codes.data(), best.data());
+    return codes;
+}
+
+// D(m, n) = distance between center codes[m] and query frame n, from a
+// table of codebook.size x N distances computed up front.
+template <class Real, class Code = std::uint8_t>
+class CodeDistance {
+public:
+    using value_type = Real;
+
+    CodeDistance(const Codebook<Real>& codebook, const Code* codes, index_t count, MatrixView<const Real> qry,
+                 Metric metric, Isa isa = active_isa())
+        : size_(codebook.size), rows_(count), cols_(qry.cols), codes_(codes),
+          table_(std::size_t(codebook.size * qry.cols))
+    {
+        if (codes == nullptr || count <= 0)
+            throw std::invalid_argument("vq: empty reference");
+        if (std::any_of(codes, codes + count, [&](Code c) { return index_t(c) >= size_; }))
+            throw std::invalid_argument("vq: code outside the codebook");
+        const FrameDistance<Real> dist(codebook.view(), qry, metric);
+        for (index_t n = 0; n < cols_; ++n)
+            dist.column(n, table_.data() + n * size_, isa);
+    }
+
+    CodeDistance(const Codebook<Real>& codebook, const std::vector<Code>& codes, MatrixView<const Real> qry,
+                 Metric metric, Isa isa = active_isa())
+        : CodeDistance(codebook, codes.data(), index_t(codes.size()), qry, metric, isa)
+    {
+    }
+
+    index_t rows() const { return rows_; }
+    index_t cols() const { return cols_; }
+
+    // Column n of D into out[0 .. rows()).
+    void column(index_t n, Real* out, Isa isa = active_isa()) const { column_rows(n, 0, rows_, out, isa); }
+
+    // Entries first..last-1 of column n into out[first .. last).
+    void column_rows(index_t n, index_t first, index_t last, Real* out, Isa = active_isa()) const
+    {
+        const Real* t = table(n);
+        for (index_t m = first; m < last; ++m)
+            out[m] = t[codes_[m]];
+    }
+
+    // Distances of every center to query frame n.
+    const Real* table(index_t n) const { return table_.data() + n * size_; }
+
+private:
+    index_t size_, rows_, cols_;
+    const Code* codes_;
+    Scratch<Real> table_;
+};
+
+template <class Pattern, class Norm = Accumulated, class Real, class Code>
+Hit<Real> dtw_features(const CodeDistance<Real, Code>& dist, Isa isa = active_isa())
+{
+    return detail::features<Pattern, Norm>(dist, isa, detail::BestHit<Pattern>{});
+}
+
+template <class Pattern, class Norm = Accumulated, class Real, class Code>
+std::vector<Hit<Real>> dtw_features(const CodeDistance<Real, Code>& dist, const TopK& top,
+                                    Isa isa = active_isa())
+{
+    return detail::features<Pattern, Norm>(dist, isa, detail::BestHits<Pattern>{top});
+}
+
+} // namespace qbestd
@@ -0,0 +1,92 @@
+// Minimal self-registering test harness; every test file is its own
+// executable and returns non-zero when a CHECK fails.
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <vector>
+
+namespace check {
+
+struct Case {
+    const char* name;
+    std::function<void()> fn;
+};
+
+inline std::vector<Case>& registry()
+{
+    static std::vector<Case> cases;
+    return cases;
+}
+
+inline int& failures()
+{
+    static int count = 0;
+    return count;
+}
+
+struct Registrar {
+    Registrar(const char* name, std::function<void()> fn) { registry().push_back({name, std::move(fn)}); }
+};
+
+inline int run_all()
+{
+    for (const Case& c : registry()) {
+        const int before = failures();
+        try {
+            c.fn();
+        } catch (const std::exception& e) {
+            std::printf("%s: unexpected exception: %s\n", c.name, e.what());
+            ++failures();
+        }
+        std::printf("[%s] %s\n", failures() == before ? "  OK  " : " FAIL ", c.name);
+    }
+    return failures() == 0 ? 0 : 1;
+}
+
+} // namespace check
+
+#define CHECK_CAT2(a, b) a##b
+#define CHECK_CAT(a, b) CHECK_CAT2(a, b)
+
+#define TEST_CASE(name)                                                                  \
+    static void CHECK_CAT(test_, __LINE__)();                                            \
+    static check::Registrar CHECK_CAT(reg_, __LINE__)(name, &CHECK_CAT(test_, __LINE__)); \
+    static void CHECK_CAT(test_, __LINE__)()
+
+#define CHECK(cond)                                                               \
+    do {                                                                          \
+        if (!(cond)) {                                                            \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++check::failures();                                                  \
+        }                                                                         \
+    } while (0)
+
+#define CHECK_NEAR(a, b, tol)                                                              \
+    do {                                                                                   \
+        const double check_a_ = (a), check_b_ = (b);                                       \
+        if (!(std::fabs(check_a_ - check_b_) <= (tol))) {                                  \
+            std::printf("%s:%d: CHECK_NEAR(%s, %s) failed: %.17g vs %.17g\n", __FILE__,    \
+                        __LINE__, #a, #b, check_a_, check_b_);                             \
+            ++check::failures();                                                           \
+        }                                                                                  \
+    } while (0)
+
+#define CHECK_THROWS(expr)                                                          \
+    do {                                                                            \
+        bool check_threw_ = false;                                                  \
+        try {                                                                       \
+            (void)(expr);                                                           \
+        } catch (...) {                                                             \
+            check_threw_ = true;                                                    \
+        }                                                                           \
+        if (!check_threw_) {                                                        \
+            std::printf("%s:%d: CHECK_THROWS(%s) did not throw\n", __FILE__, __LINE__, #expr); \
+            ++check::failures();                                                    \
+        }                                                                           \
+    } while (0)
+
+#define TEST_MAIN() \
+    int main() { return check::run_all(); }
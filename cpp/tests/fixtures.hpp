@@ -0,0 +1,64 @@
+// Random inputs shared by the test files.
+#pragma once
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "qbestd/simd.hpp"
+#include "qbestd/types.hpp"
+
+// Instruction sets this machine runs, Scalar first.
+inline std::vector<qbestd::Isa> available_isas()
+{
+    std::vector<qbestd::Isa> out;
+    for (qbestd::Isa isa : {qbestd::Isa::Scalar, qbestd::Isa::Avx2, qbestd::Isa::Avx512})
+        if (isa <= qbestd::detect_isa())
+            out.push_back(isa);
+    return out;
+}
+
+// count values uniform in [lo, hi).
+template <class Real = double>
+std::vector<Real> random_values(std::size_t count, std::mt19937& gen, Real lo = Real(0.01), Real hi = Real(1))
+{
+    std::uniform_real_distribution<Real> u(lo, hi);
+    std::vector<Real> X(count);
+    for (Real& x : X)
+        x = u(gen);
+    return X;
+}
+
+// dims x count column-major frames, uniform in [lo, hi).
+template <class Real = double>
+std::vector<Real> random_frames(qbestd::index_t dims, qbestd::index_t count, std::mt19937& gen, Real lo = Real(0.01),
+                                Real hi = Real(1))
+{
+    return random_values(std::size_t(dims * count), gen, lo, hi);
+}
+
+// dims x frames positive columns that sum to 1, like posteriorgrams.
+inline std::vector<double> random_posteriors(qbestd::index_t dims, qbestd::index_t frames, std::mt19937& gen)
+{
+    std::vector<double> X = random_frames(dims, frames, gen);
+    for (qbestd::index_t f = 0; f < frames; ++f) {
+        double sum = 0;
+        for (qbestd::index_t i = 0; i < dims; ++i)
+            sum += X[std::size_t(f * dims + i)];
+        for (qbestd::index_t i = 0; i < dims; ++i)
+            X[std::size_t(f * dims + i)] /= sum;
+    }
+    return X;
+}
+
+// M x N distance matrix of multiples of step, from 0 to levels * step;
+// few levels force ties between the steps of a pattern.
+inline std::vector<double> random_levels(qbestd::index_t M, qbestd::index_t N, std::mt19937& gen, int levels,
+                                         double step = 0.5)
+{
+    std::uniform_int_distribution<int> level(0, levels);
+    std::vector<double> D(std::size_t(M * N));
+    for (double& d : D)
+        d = step * level(gen);
+    return D;
+}
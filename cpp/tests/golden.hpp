@@ -0,0 +1,265 @@
+// Reference ports of the recurrences the MEX kernels ran before the
+// engine replaced them (matlab/*.cpp at the baseline commit), kept free
+// of MATLAB and of the engine so the engine can be checked against them.
+// Every port fills S, T and P cell by cell in the original loop order and
+// picks predecessors with the original min_fun_ind, including its
+// tie-breaking. Outputs keep the MEX conventions: P and ep are 1-based,
+// except for DTW_c_skel_nobt, whose ep is the 0-based row.
+//
+// The originals write outside D for shapes below the rows and columns
+// they initialize up front; callers keep M >= 5 and N >= 2.
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace golden {
+
+// [dist, ep, S, T, P] as returned by the kernel; the DTW kernels return
+// [dist, ep, P, P1], held here in S and T with P left empty.
+struct Output {
+    double dist = 0;
+    double ep = 0;
+    std::vector<double> S, T, P;
+};
+
+// Column-major M x N distance matrix.
+struct Matrix {
+    const double* D;
+    int M, N;
+
+    double operator()(int m, int n) const { return D[m + M * n]; }
+};
+
+namespace detail {
+
+// First index of the smallest of c[0..k), as the min_fun_ind of
+// NSDTW_c_skel_2/_4/_5 and the DTW kernels (x is tested first).
+inline int first_min(const double* c, int k)
+{
+    for (int i = 0; i < k; ++i) {
+        bool smallest = true;
+        for (int j = 0; j < k; ++j)
+            smallest = smallest && c[i] <= c[j];
+        if (smallest)
+            return i;
+    }
+    return k - 1;
+}
+
+// Last index of the smallest of c[0..k), as the three-argument
+// min_fun_ind of NSDTW_c_skel, newNSDTW and GTTS (z is tested first).
+inline int last_min(const double* c, int k)
+{
+    for (int i = k - 1; i >= 0; --i) {
+        bool smallest = true;
+        for (int j = 0; j < k; ++j)
+            smallest = smallest && c[i] <= c[j];
+        if (smallest)
+            return i;
+    }
+    return 0;
+}
+
+// find_min_value_ind: first row of the smallest S in the last column.
+inline int find_min_value_ind(const std::vector<double>& S, int M, int N)
+{
+    double best = S[std::size_t(M * (N - 1))];
+    int at = 0;
+    for (int m = 1; m < M; ++m)
+        if (S[std::size_t(m + M * (N - 1))] < best) {
+            best = S[std::size_t(m + M * (N - 1))];
+            at = m;
+        }
+    return at;
+}
+
+inline Output scored(Output out, int M, int N)
+{
+    const int i = find_min_value_ind(out.S, M, N);
+    const std::size_t ep = std::size_t(i + M * (N - 1));
+    out.dist = out.S[ep] / out.T[ep];
+    out.ep = i + 1;
+    return out;
+}
+
+inline Output allocated(int M, int N, bool with_p = true)
+{
+    Output out;
+    out.S.resize(std::size_t(M * N));
+    out.T.resize(out.S.size());
+    if (with_p)
+        out.P.resize(out.S.size());
+    return out;
+}
+
+} // namespace detail
+
+// NSDTW_c_skel (jumps 3, rows 0-1 initialized, ties to the horizontal
+// step), NSDTW_c_skel_2 (jumps 2, rows 0-1, ties to the diagonal),
+// NSDTW_c_skel_4 and _5 (rows 0-2 and 0-3, ties to the longest jump) and
+// NSDTW_c_skel_online (as NSDTW_c_skel, choosing by (D + S) / (T + 1)).
+// Each candidate in candidates order comes from row m - jumps + 1 + c.
+inline Output nsdtw(Matrix D, int jumps, int first_rows, bool prefer_last, bool normalized)
+{
+    const int M = D.M, N = D.N;
+    Output out = detail::allocated(M, N);
+    std::vector<double>&S = out.S, &T = out.T, &P = out.P;
+    for (int m = 0; m < M; ++m) {
+        P[m] = m + 1;
+        S[m] = D(m, 0);
+        T[m] = 1;
+    }
+    for (int m = 0; m < first_rows; ++m)
+        for (int n = 1; n < N; ++n) {
+            P[m + M * n] = m + 1;
+            S[m + M * n] = S[m + M * (n - 1)] + D(m, n);
+            T[m + M * n] = n + 1;
+        }
+    double c[5];
+    for (int m = first_rows; m < M; ++m)
+        for (int n = 1; n < N; ++n) {
+            for (int k = 0; k < jumps; ++k) {
+                const int from = (m - jumps + 1 + k) + M * (n - 1);
+                c[k] = normalized ? (D(m, n) + S[from]) / (T[from] + 1) : D(m, n) + S[from];
+            }
+            const int k = prefer_last ? detail::last_min(c, jumps) : detail::first_min(c, jumps);
+            const int from = (m - jumps + 1 + k) + M * (n - 1);
+            T[m + M * n] = T[from] + 1;
+            P[m + M * n] = P[from];
+            S[m + M * n] = normalized ? S[from] + D(m, n) : c[k];
+        }
+    return detail::scored(out, M, N);
+}
+
+inline Output NSDTW_c_skel(Matrix D) { return nsdtw(D, 3, 2, true, false); }
+inline Output NSDTW_c_skel_2(Matrix D) { return nsdtw(D, 2, 2, false, false); }
+inline Output NSDTW_c_skel_4(Matrix D) { return nsdtw(D, 4, 3, false, false); }
+inline Output NSDTW_c_skel_5(Matrix D) { return nsdtw(D, 5, 4, false, false); }
+inline Output NSDTW_c_skel_online(Matrix D) { return nsdtw(D, 3, 2, true, true); }
+
+// newNSDTW_c_skel(_online): vertical, diagonal and two-column steps, all
+// from row m - 1; the second column has no two-column step and its
+// diagonal counts twice in T.
+inline Output newNSDTW(Matrix D, bool normalized)
+{
+    const int M = D.M, N = D.N;
+    Output out = detail::allocated(M, N);
+    std::vector<double>&S = out.S, &T = out.T, &P = out.P;
+    for (int m = 0; m < M; ++m) {
+        P[m] = m + 1;
+        S[m] = D(m, 0);
+        T[m] = 1;
+    }
+    for (int n = 1; n < N; ++n) {
+        P[M * n] = 1;
+        S[M * n] = S[M * (n - 1)] + D(0, n);
+        T[M * n] = n + 1;
+    }
+    auto candidate = [&](int m, int n, int from) {
+        return normalized ? (D(m, n) + S[from]) / (T[from] + 1) : D(m, n) + S[from];
+    };
+    for (int m = 1; m < M; ++m) {
+        const int n = 1, diag = (m - 1) + M * (n - 1), vert = (m - 1) + M * n;
+        const double c[3] = {candidate(m, n, diag) + 1, candidate(m, n, diag), candidate(m, n, vert)};
+        switch (detail::last_min(c, 3)) {
+        case 1:
+            T[m + M * n] = T[diag] + 2;
+            P[m + M * n] = P[diag];
+            S[m + M * n] = D(m, n) + S[diag];
+            break;
+        case 2:
+            T[m + M * n] = T[vert] + 1;
+            P[m + M * n] = P[vert];
+            S[m + M * n] = D(m, n) + S[vert];
+            break;
+        default:
+            break;
+        }
+    }
+    for (int m = 1; m < M; ++m)
+        for (int n = 2; n < N; ++n) {
+            const int from[3] = {(m - 1) + M * (n - 2), (m - 1) + M * (n - 1), (m - 1) + M * n};
+            const double c[3] = {candidate(m, n, from[0]), candidate(m, n, from[1]), candidate(m, n, from[2])};
+            const int k = from[detail::last_min(c, 3)];
+            T[m + M * n] = T[k] + 1;
+            P[m + M * n] = P[k];
+            S[m + M * n] = D(m, n) + S[k];
+        }
+    return detail::scored(out, M, N);
+}
+
+inline Output newNSDTW_c_skel(Matrix D) { return newNSDTW(D, false); }
+inline Output newNSDTW_c_skel_online(Matrix D) { return newNSDTW(D, true); }
+
+// GTTS_DTW_c_skel(_online) and sub_DTW_c_skel_online: vertical, diagonal
+// and horizontal steps, ties to the horizontal one.
+inline Output gtts(Matrix D, bool normalized)
+{
+    const int M = D.M, N = D.N;
+    Output out = detail::allocated(M, N);
+    std::vector<double>&A = out.S, &L = out.T, &P = out.P;
+    for (int m = 0; m < M; ++m) {
+        P[m] = m + 1;
+        A[m] = D(m, 0);
+        L[m] = 1;
+    }
+    for (int n = 1; n < N; ++n) {
+        P[M * n] = 1;
+        A[M * n] = A[M * (n - 1)] + D(0, n);
+        L[M * n] = n + 1;
+    }
+    for (int m = 1; m < M; ++m)
+        for (int n = 1; n < N; ++n) {
+            const int from[3] = {(m - 1) + M * n, (m - 1) + M * (n - 1), m + M * (n - 1)};
+            double c[3];
+            for (int k = 0; k < 3; ++k)
+                c[k] = normalized ? (D(m, n) + A[from[k]]) / (L[from[k]] + 1) : D(m, n) + A[from[k]];
+            const int k = from[detail::last_min(c, 3)];
+            P[m + M * n] = P[k];
+            A[m + M * n] = A[k] + D(m, n);
+            L[m + M * n] = L[k] + 1;
+        }
+    return detail::scored(out, M, N);
+}
+
+inline Output GTTS_DTW_c_skel(Matrix D) { return gtts(D, false); }
+inline Output GTTS_DTW_c_skel_online(Matrix D) { return gtts(D, true); }
+inline Output sub_DTW_c_skel_online(Matrix D) { return gtts(D, true); }
+
+// DTW_c_skel_nobt and DTW_c_basic_skel_nobt: anchored DTW with unit
+// weights, ties to the diagonal. The first ends at the smallest cost of
+// the last column (0-based ep), the second in the corner (ep = M).
+inline Output anchored_dtw(Matrix D, bool corner)
+{
+    const int M = D.M, N = D.N;
+    Output out = detail::allocated(M, N, false);
+    std::vector<double>&P = out.S, &P1 = out.T;
+    P[0] = D(0, 0);
+    P1[0] = 1;
+    for (int n = 1; n < N; ++n) {
+        P[M * n] = D(0, n) + P[M * (n - 1)];
+        P1[M * n] = n + 1;
+    }
+    for (int m = 1; m < M; ++m) {
+        P[m] = D(m, 0) + P[m - 1];
+        P1[m] = m + 1;
+    }
+    for (int m = 1; m < M; ++m)
+        for (int n = 1; n < N; ++n) {
+            const int from[3] = {(m - 1) + M * (n - 1), (m - 1) + M * n, m + M * (n - 1)};
+            const double c[3] = {P[from[0]] + D(m, n), P[from[1]] + D(m, n), P[from[2]] + D(m, n)};
+            const int k = detail::first_min(c, 3);
+            P[m + M * n] = c[k];
+            P1[m + M * n] = P1[from[k]] + 1;
+        }
+    const int end = corner ? M - 1 : detail::find_min_value_ind(P, M, N);
+    out.dist = P[std::size_t(end + M * (N - 1))] / P1[std::size_t(end + M * (N - 1))];
+    out.ep = corner ? M : end;
+    return out;
+}
+
+inline Output DTW_c_skel_nobt(Matrix D) { return anchored_dtw(D, false); }
+inline Output DTW_c_basic_skel_nobt(Matrix D) { return anchored_dtw(D, true); }
+
+} // namespace golden
@@ -0,0 +1,157 @@
+// The early-abandon cutoff must return exactly the unpruned hit whenever
+// it beats the cutoff, nothing otherwise, and skip most of the matrix
+// when the cutoff is tight.
+#include <limits>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/abandon.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+void check_same(const std::optional<Hit<double>>& got, const Hit<double>& want, double cutoff)
+{
+    CHECK(got.has_value() == (want.dist < cutoff));
+    if (got && want.dist < cutoff) {
+        CHECK(got->end == want.end);
+        CHECK(got->start == want.start);
+        CHECK_NEAR(got->dist, want.dist, 0.0);
+    }
+}
+
+// expensive: column N/2 costs 100 more everywhere, so a path stepping
+// over it (NewNSDTW's (1, 2)) is the only cheap one.
+template <class Pattern, class Norm>
+void compare_unpruned(bool expensive = false)
+{
+    std::mt19937 gen(23);
+    for (int trial = 0; trial < 40; ++trial) {
+        const index_t M = 1 + (trial * 11) % 97, N = 1 + (trial * 5) % 23;
+        std::vector<double> D = random_levels(M, N, gen, trial % 2 ? 4 : 1000);
+        // A cheap occurrence, so that most rows die early
+        const index_t at = (trial * 13) % M;
+        for (index_t n = 0; n < N; ++n)
+            D[std::size_t(n * M + std::min(at + n, M - 1))] = 0.1 * (n % 3);
+        if (expensive)
+            for (index_t m = 0; m < M; ++m)
+                D[std::size_t(N / 2 * M + m)] += 100;
+        const MatrixView<const double> view = column_major<const double>(D.data(), M, N);
+
+        for (Isa isa : available_isas()) {
+            const Hit<double> want = dtw_rolling<Pattern, Norm>(view, isa);
+            for (double c : {0.0, want.dist * 0.5, want.dist, want.dist * 1.000001, want.dist * 2 + 1,
+                             std::numeric_limits<double>::infinity()})
+                check_same(dtw_rolling<Pattern, Norm>(view, BestSoFar{c}, isa), want, c);
+        }
+    }
+}
+
+template <class Pattern, class Norm>
+void compare_features(Metric metric, bool expensive = false)
+{
+    std::mt19937 gen(29);
+    const index_t dims = 6;
+    for (int trial = 0; trial < 20; ++trial) {
+        const index_t M = 20 + trial * 9, N = 2 + trial % 11;
+        std::vector<double> R = random_frames(dims, M, gen), Q = random_frames(dims, N, gen);
+        // Plant the query in the reference
+        const index_t at = (trial * 7) % (M - N);
+        std::copy(Q.begin(), Q.end(), R.begin() + at * dims);
+        if (expensive)
+            for (index_t k = 0; k < dims; ++k)
+                Q[std::size_t(N / 2 * dims + k)] = 100;
+        const FrameDistance<double> dist(column_major<const double>(R.data(), dims, M),
+                                         column_major<const double>(Q.data(), dims, N), metric);
+
+        for (Isa isa : available_isas()) {
+            const Hit<double> want = dtw_features<Pattern, Norm>(dist, isa);
+            for (double c : {want.dist * 0.5, want.dist, want.dist * 1.01 + 1e-3, want.dist * 3 + 1})
+                check_same(dtw_features<Pattern, Norm>(dist, BestSoFar{c}, isa), want, c);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("Cutoff keeps the unpruned hit")
+{
+    compare_unpruned<NSDTW2, Accumulated>();
+    compare_unpruned<NSDTW3, Accumulated>();
+    compare_unpruned<NSDTW3, Normalized>();
+    compare_unpruned<NSDTW5, Accumulated>();
+    compare_unpruned<NSDTW5, Normalized>();
+    compare_unpruned<GTTS, Accumulated>();
+    compare_unpruned<NewNSDTW, Accumulated>();
+    compare_unpruned<NewNSDTW, Accumulated>(true);
+    compare_unpruned<GTTS, Accumulated>(true);
+    compare_unpruned<OpenEndDTW, Accumulated>();
+    compare_unpruned<BasicDTW, Accumulated>();
+    compare_unpruned<SymmetricDTW, Accumulated>();
+}
+
+TEST_CASE("Fused cutoff keeps the unpruned hit")
+{
+    for (Metric metric : {Metric::SqEuclidean, Metric::SymmetricKL, Metric::InnerProduct,
+                          Metric::NormInnerProduct, Metric::Bhattacharyya}) {
+        compare_features<NSDTW3, Accumulated>(metric);
+        compare_features<NSDTW3, Normalized>(metric);
+        compare_features<GTTS, Accumulated>(metric);
+        compare_features<NewNSDTW, Accumulated>(metric);
+    }
+    compare_features<NewNSDTW, Accumulated>(Metric::SqEuclidean, true);
+    compare_features<NewNSDTW, Accumulated>(Metric::SymmetricKL, true);
+}
+
+TEST_CASE("A step over an expensive column is kept")
+{
+    // NewNSDTW's (1, 2) step skips column 1; no path through it is cheap
+    std::vector<double> D(12, 0.0);
+    for (index_t m = 0; m < 4; ++m)
+        D[std::size_t(4 + m)] = 100;
+    const MatrixView<const double> view = column_major<const double>(D.data(), 4, 3);
+    const Hit<double> want = dtw_rolling<NewNSDTW>(view);
+    CHECK(want.dist == 0);
+    check_same(dtw_rolling<NewNSDTW>(view, BestSoFar{1.0}), want, 1.0);
+}
+
+TEST_CASE("Tight cutoff skips most rows")
+{
+    const index_t M = 2000, N = 200;
+    std::mt19937 gen(31);
+    std::vector<double> D = random_values(std::size_t(M * N), gen, 1.0, 2.0);
+    for (index_t n = 0; n < N; ++n)
+        D[std::size_t(n * M + 700 + n)] = 1.0;
+    const MatrixView<const double> view = column_major<const double>(D.data(), M, N);
+    const Hit<double> want = dtw_rolling<NSDTW3>(view);
+
+    const std::vector<double> floor(std::size_t(N), 1.0);
+    index_t rows = 0;
+    const std::optional<Hit<double>> got = detail::rolling_cutoff<NSDTW3, Accumulated, double>(
+        M, N, 1, active_isa(), 1.01, floor, [&](index_t n, index_t first, index_t last) {
+            rows += last - first;
+            return &view(0, n);
+        });
+    CHECK(got.has_value());
+    check_same(got, want, 1.01);
+    CHECK(rows < M * N / 10);
+}
+
+TEST_CASE("Negative distances are rejected")
+{
+    std::vector<double> D(12, 1.0);
+    D[5] = -1.0;
+    bool threw = false;
+    try {
+        (void)dtw_rolling<NSDTW3>(column_major<const double>(D.data(), 4, 3), BestSoFar{10.0});
+    } catch (const std::invalid_argument&) {
+        threw = true;
+    }
+    CHECK(threw);
+}
+
+TEST_MAIN()
@@ -0,0 +1,166 @@
+// An archive must hand back exactly the frames written into it, as views
+// into the mapping, search like the in-memory corpus, and refuse files
+// that are truncated, unfinished or not archives at all.
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/archive.hpp"
+#include "qbestd/corpus.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+std::string temp_path(const char* tag)
+{
+    return (std::filesystem::temp_directory_path() /
+            ("qbestd_" + std::string(tag) + "_" + std::to_string(::getpid()) + ".qfa"))
+        .string();
+}
+
+} // namespace
+
+TEST_CASE("Float32 archive maps the written frames")
+{
+    std::mt19937 gen(81);
+    const index_t dims = 13;
+    std::vector<std::vector<float>> data;
+    const std::string path = temp_path("f32");
+    {
+        ArchiveWriter out(path, dims);
+        for (index_t u = 0; u < 9; ++u) {
+            data.push_back(random_frames<float>(dims, 5 + u * 7, gen));
+            out.add("utt" + std::to_string(u),
+                    column_major<const float>(data.back().data(), dims, index_t(data.back().size()) / dims));
+        }
+        // Row-major double input is converted on the way in
+        const std::vector<double> rows = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+                                          -1, -2, -3, -4, -5, -6, -7, -8, -9, -10, -11, -12, -13};
+        out.add("rows", MatrixView<const double>{rows.data(), dims, 2, 1, dims});
+        data.emplace_back(rows.begin(), rows.end());
+        out.finish();
+    }
+
+    const Archive archive(path);
+    CHECK(archive.size() == data.size());
+    CHECK(archive.dims() == dims);
+    CHECK(archive.type() == FrameType::Float32);
+    index_t total = 0;
+    for (std::size_t u = 0; u < data.size(); ++u) {
+        const MatrixView<const float> v = archive.utterance(u);
+        CHECK(v.rows == dims);
+        CHECK(v.cols * dims == index_t(data[u].size()));
+        CHECK(reinterpret_cast<std::uintptr_t>(v.data) % 64 == 0);
+        for (index_t n = 0; n < v.cols; ++n)
+            for (index_t d = 0; d < dims; ++d)
+                CHECK(v(d, n) == data[u][std::size_t(n * dims + d)]);
+        total += v.cols;
+    }
+    CHECK(archive.total_frames() == total);
+    CHECK(archive.name(3) == "utt3");
+    CHECK(archive.name(9) == "rows");
+    CHECK_THROWS(archive.half_utterance(0));
+
+    // Searching the mapping is searching the frames
+    std::vector<MatrixView<const float>> memory;
+    for (const std::vector<float>& x : data)
+        memory.push_back(column_major(x.data(), dims, index_t(x.size()) / dims));
+    std::vector<std::vector<float>> qdata;
+    std::vector<MatrixView<const float>> queries;
+    for (index_t q = 0; q < 5; ++q)
+        qdata.push_back(random_frames<float>(dims, 3 + q, gen));
+    for (const std::vector<float>& x : qdata)
+        queries.push_back(column_major(x.data(), dims, index_t(x.size()) / dims));
+    const CorpusOptions opt{3, 2};
+    const auto want = search_corpus<GTTS>(queries, memory, Metric::SqEuclidean, opt);
+    const auto got = search_corpus<GTTS>(queries, archive.utterances(), Metric::SqEuclidean, opt);
+    CHECK(got.size() == want.size());
+    for (std::size_t q = 0; q < got.size() && q < want.size(); ++q) {
+        CHECK(got[q].size() == want[q].size());
+        for (std::size_t k = 0; k < got[q].size() && k < want[q].size(); ++k) {
+            CHECK(got[q][k].utterance == want[q][k].utterance);
+            CHECK(got[q][k].hit.dist == want[q][k].hit.dist);
+        }
+    }
+
+    Archive moved = Archive(path);
+    moved = Archive(path);
+    CHECK(moved.frames(1) == 12);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Float16 archive rounds to nearest even")
+{
+    const float values[] = {0.0f, -0.0f, 1.0f, -2.5f, 65504.0f, 65519.0f, 65520.0f, 1e-8f, 5.96e-8f,
+                            6.1e-5f, 1.0f + 1.0f / 2048, 1.0f + 3.0f / 2048, 0.1f, INFINITY, -INFINITY};
+    const float rounded[] = {0.0f, -0.0f, 1.0f, -2.5f, 65504.0f, 65504.0f, INFINITY, 0.0f, 0x1p-24f,
+                             0x1.ff8p-15f, 1.0f, 1.0f + 4.0f / 2048, 0x1.998p-4f, INFINITY, -INFINITY};
+    for (std::size_t i = 0; i < std::size(values); ++i) {
+        const float back = detail::half_to_float(detail::float_to_half(values[i]));
+        CHECK(back == rounded[i]);
+        CHECK(std::signbit(back) == std::signbit(rounded[i]));
+    }
+    CHECK(std::isnan(detail::half_to_float(detail::float_to_half(NAN))));
+
+    std::mt19937 gen(83);
+    const index_t dims = 7;
+    const std::vector<float> x = random_frames<float>(dims, 40, gen);
+    const std::string path = temp_path("f16");
+    {
+        ArchiveWriter out(path, dims, FrameType::Float16);
+        out.add("only", column_major<const float>(x.data(), dims, 40));
+        out.add("empty", column_major<const float>(x.data(), dims, 0));
+        out.finish();
+    }
+    const Archive archive(path);
+    CHECK(archive.type() == FrameType::Float16);
+    CHECK_THROWS(archive.utterance(0));
+    CHECK(archive.frames(1) == 0);
+    CHECK(archive.name(1) == "empty");
+    std::vector<float> wide(x.size());
+    archive.decode(0, wide.data());
+    for (std::size_t i = 0; i < x.size(); ++i) {
+        CHECK(wide[i] == detail::half_to_float(detail::float_to_half(x[i])));
+        CHECK(std::fabs(wide[i] - x[i]) <= x[i] / 2048);
+    }
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Damaged archives are rejected")
+{
+    const std::string path = temp_path("bad");
+    const std::vector<float> x(26, 1.0f);
+    {
+        ArchiveWriter out(path, 13);
+        out.add("a", column_major<const float>(x.data(), 13, 2));
+        // not finished: the header is still blank
+    }
+    CHECK_THROWS(Archive(path));
+    {
+        ArchiveWriter out(path, 13);
+        out.add("a", column_major<const float>(x.data(), 13, 2));
+        out.finish();
+    }
+    CHECK(Archive(path).frames(0) == 2);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    CHECK_THROWS(Archive(path));
+    std::ofstream(path, std::ios::binary) << std::string(200, 'x');
+    CHECK_THROWS(Archive(path));
+    std::remove(path.c_str());
+    CHECK_THROWS(Archive(path));
+    CHECK_THROWS(ArchiveWriter(path, 13).add("a", column_major<const float>(x.data(), 2, 13)));
+    std::remove(path.c_str());
+}
+
+TEST_MAIN()
@@ -0,0 +1,140 @@
+// WAV files must round-trip through write_wav() and read_wav(), with
+// stereo mixed down to mono, and the resampler must keep a tone below
+// the cut-off while removing one above it, whether the signal arrives
+// at once or in pieces.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "qbestd/qbestd.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+
+std::vector<float> tone(double hz, int rate, std::size_t count)
+{
+    std::vector<float> x(count);
+    for (std::size_t t = 0; t < count; ++t)
+        x[t] = float(0.5 * std::sin(2 * pi * hz * double(t) / rate));
+    return x;
+}
+
+std::string temp_path(const char* name)
+{
+    return std::string(std::getenv("TMPDIR") ? std::getenv("TMPDIR") : "/tmp") + "/" + name;
+}
+
+// Largest |x[t] - tone(t)| away from the ends.
+double tone_error(const std::vector<float>& x, double hz, int rate)
+{
+    double worst = 0;
+    for (std::size_t t = 200; t + 200 < x.size(); ++t)
+        worst = std::max(worst, std::abs(double(x[t]) - 0.5 * std::sin(2 * pi * hz * double(t) / rate)));
+    return worst;
+}
+
+double rms(const std::vector<float>& x)
+{
+    double s = 0;
+    for (std::size_t t = 200; t + 200 < x.size(); ++t)
+        s += double(x[t]) * x[t];
+    return std::sqrt(s / double(x.size() - 400));
+}
+
+} // namespace
+
+TEST_CASE("WAV files round-trip")
+{
+    const std::string path = temp_path("qbestd_test_audio.wav");
+    Audio a{16000, tone(440, 16000, 1000)};
+    a.samples[0] = -1.0f;
+    write_wav(path, a);
+    const Audio b = read_wav(path);
+    CHECK(b.sample_rate == 16000);
+    CHECK(b.samples.size() == a.samples.size());
+    double worst = 0;
+    for (std::size_t t = 0; t < a.samples.size(); ++t)
+        worst = std::max(worst, double(std::abs(a.samples[t] - b.samples[t])));
+    CHECK(worst <= 0.5 / 32768);
+    CHECK(b.samples[0] == -1.0f);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Stereo is averaged and other formats are rejected")
+{
+    const std::string path = temp_path("qbestd_test_stereo.wav");
+    auto write = [&](std::uint16_t format, std::uint16_t bits) {
+        std::ofstream out(path, std::ios::binary);
+        auto u32 = [&](std::uint32_t v) { out.write(reinterpret_cast<const char*>(&v), 4); };
+        auto u16 = [&](std::uint16_t v) { out.write(reinterpret_cast<const char*>(&v), 2); };
+        out.write("RIFF", 4);
+        u32(4 + 8 + 16 + 8 + 8 + 8 + 8);
+        out.write("WAVEfmt ", 8);
+        u32(16);
+        u16(format);
+        u16(2);
+        u32(8000);
+        u32(8000 * 4);
+        u16(4);
+        u16(bits);
+        out.write("LIST", 4);  // a chunk to skip
+        u32(4);
+        out.write("INFO", 4);
+        out.write("data", 4);
+        u32(8);
+        for (std::int16_t s : {std::int16_t(16384), std::int16_t(0), std::int16_t(-32768), std::int16_t(-32768)})
+            u16(std::uint16_t(s));
+    };
+    write(1, 16);
+    const Audio a = read_wav(path);
+    CHECK(a.sample_rate == 8000);
+    CHECK(a.samples.size() == 2);
+    CHECK(a.samples[0] == 0.25f);
+    CHECK(a.samples[1] == -1.0f);
+    write(3, 32);
+    CHECK_THROWS(read_wav(path));
+    std::remove(path.c_str());
+    CHECK_THROWS(read_wav(path));
+}
+
+TEST_CASE("Resampling keeps the passband and removes what cannot be represented")
+{
+    // 1 kHz survives 44.1 -> 22.05 kHz and 16 -> 22.05 kHz
+    const Audio down = resample(Audio{44100, tone(1000, 44100, 44100)}, 22050);
+    CHECK(down.samples.size() == 22050);
+    CHECK(tone_error(down.samples, 1000, 22050) < 1e-3);
+    const Audio up = resample(Audio{16000, tone(1000, 16000, 16000)}, 22050);
+    CHECK(up.samples.size() == 22050);
+    CHECK(tone_error(up.samples, 1000, 22050) < 1e-3);
+
+    // 15 kHz is above the new Nyquist frequency
+    const Audio alias = resample(Audio{44100, tone(15000, 44100, 44100)}, 22050);
+    CHECK(rms(alias.samples) < 1e-3);
+
+    // The same rate is a copy
+    const Audio same = resample(Audio{22050, tone(1000, 22050, 100)}, 22050);
+    CHECK(same.samples == tone(1000, 22050, 100));
+}
+
+TEST_CASE("Streamed resampling matches the whole signal")
+{
+    const std::vector<float> x = tone(700, 48000, 9000);
+    const Audio whole = resample(Audio{48000, x}, 22050);
+    Resampler r(48000, 22050);
+    std::vector<float> out;
+    for (std::size_t at = 0; at < x.size(); at += 777)
+        r.push(x.data() + at, std::min<std::size_t>(777, x.size() - at), out);
+    r.flush(out);
+    CHECK(out == whole.samples);
+}
+
+TEST_MAIN()
@@ -0,0 +1,149 @@
+// Band row ranges against their defining inequalities, and banded
+// alignments against dtw() on D with +Inf outside the band, the Mask
+// of masking_distMtrx_segDTW.
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/band.hpp"
+#include "qbestd/dtw.hpp"
+#include "qbestd/segmental.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+constexpr double inf = std::numeric_limits<double>::infinity();
+
+// Row m of column n admitted by the band, straight from the definition.
+bool admits(const Band& band, index_t m, index_t n, index_t M, index_t N, End end)
+{
+    const double e = 1e-9;
+    if (band.radius >= 0 && std::abs(double(m) - band.slope * double(n)) > double(band.radius) + e)
+        return false;
+    if (band.max_slope > 0) {
+        const double s = band.max_slope;
+        if (double(m) > s * double(n) + e || double(n) > s * double(m) + e)
+            return false;
+        const double dm = double(M - 1 - m), dn = double(N - 1 - n);
+        if (end == End::Corner && (dm > s * dn + e || dn > s * dm + e))
+            return false;
+    }
+    return true;
+}
+
+std::vector<Band> bands(index_t M, index_t N)
+{
+    const double diagonal = N > 1 ? double(M - 1) / double(N - 1) : 1.0;
+    return {Band{},
+            Band{0},
+            Band{2},
+            Band{5},
+            Band{3, diagonal},
+            Band{1, 0.5},
+            Band{-1, 1, 2},
+            Band{-1, 1, 1.5},
+            Band{4, diagonal, 2}};
+}
+
+template <class Pattern, class Norm>
+void check_against_mask(const std::vector<double>& D, index_t M, index_t N, const Band& band)
+{
+    std::vector<double> masked(D);
+    for (index_t n = 0; n < N; ++n)
+        for (index_t m = 0; m < M; ++m)
+            if (!admits(band, m, n, M, N, Pattern::end))
+                masked[std::size_t(n * M + m)] = inf;
+    const Hit<double> want = dtw<Pattern, Norm>(column_major<const double>(masked.data(), M, N), Isa::Scalar);
+    const Hit<double> got = dtw_band<Pattern, Norm>(column_major<const double>(D.data(), M, N), band);
+    if (std::isinf(want.dist)) {
+        CHECK(std::isinf(got.dist));
+        return;
+    }
+    CHECK(got.dist == want.dist);
+    CHECK(got.end == want.end);
+    CHECK(got.start == 0);
+}
+
+} // namespace
+
+TEST_CASE("Row ranges are the rows the band admits")
+{
+    for (index_t M : {1, 7, 20, 53})
+        for (index_t N : {1, 6, 20, 31})
+            for (const Band& band : bands(M, N))
+                for (End end : {End::Open, End::Corner})
+                    for (index_t n = 0; n < N; ++n) {
+                        const auto [lo, hi] = band.rows(n, M, N, end);
+                        index_t want_lo = M, want_hi = -1;
+                        for (index_t m = 0; m < M; ++m)
+                            if (admits(band, m, n, M, N, end)) {
+                                want_lo = std::min(want_lo, m);
+                                want_hi = m;
+                            }
+                        if (want_hi < 0) {
+                            CHECK(lo > hi);
+                        } else {
+                            CHECK(lo == want_lo);
+                            CHECK(hi == want_hi);
+                        }
+                    }
+}
+
+TEST_CASE("Banded alignments equal masked full alignments")
+{
+    std::mt19937 gen(11);
+    for (index_t M : {1, 5, 17, 40})
+        for (index_t N : {1, 4, 17, 29}) {
+            const std::vector<double> D = random_levels(M, N, gen, (M + N) % 2 ? 3 : 1000);
+            for (const Band& band : bands(M, N)) {
+                check_against_mask<OpenEndDTW, Accumulated>(D, M, N, band);
+                check_against_mask<OpenEndDTW, Normalized>(D, M, N, band);
+                check_against_mask<BasicDTW, Accumulated>(D, M, N, band);
+                check_against_mask<SymmetricDTW, Accumulated>(D, M, N, band);
+                check_against_mask<SymmetricDTW, Normalized>(D, M, N, band);
+            }
+        }
+
+    // No band is the plain recurrence
+    const std::vector<double> D = random_levels(30, 12, gen, 1000);
+    const Hit<double> a = dtw<BasicDTW>(column_major<const double>(D.data(), 30, 12));
+    const Hit<double> b = dtw_band<BasicDTW>(column_major<const double>(D.data(), 30, 12), Band{});
+    CHECK(a.dist == b.dist && a.end == b.end);
+
+    // A diagonal band cannot reach the corner of a tall grid
+    CHECK(std::isinf(dtw_band<BasicDTW>(column_major<const double>(D.data(), 30, 12), Band{2}).dist));
+    CHECK(std::isfinite(dtw_band<BasicDTW>(column_major<const double>(D.data(), 30, 12), Band{2, 29.0 / 11}).dist));
+
+    CHECK_THROWS(dtw_band<BasicDTW>(column_major<const double>(D.data(), 30, 12), Band{2, -1}));
+    CHECK_THROWS(dtw_band<BasicDTW>(column_major<const double>(D.data(), 30, 12), Band{-1, 1, 0.5}));
+}
+
+TEST_CASE("Segments in a sloped band match one banded alignment each")
+{
+    std::mt19937 gen(12);
+    const index_t N1 = 90, N2 = 10, length = 25, count = N1 - length + 1;
+    const std::vector<double> D = random_levels(N1, N2, gen, 1000);
+    const Band band{3, double(length - 1) / double(N2 - 1)};
+    for (Isa isa : available_isas()) {
+        std::vector<double> dist(static_cast<std::size_t>(count));
+        std::vector<index_t> end(dist.size());
+        segmental_dtw(column_major<const double>(D.data(), N1, N2), band, length, count, dist.data(), end.data(),
+                      isa);
+        for (index_t k = 0; k < count; ++k) {
+            const Hit<double> h =
+                dtw_band<OpenEndDTW>(MatrixView<const double>{D.data() + k, length, N2, 1, N1}, band);
+            CHECK(dist[std::size_t(k)] == h.dist);
+            CHECK(end[std::size_t(k)] == h.end);
+        }
+    }
+    std::vector<double> dist(static_cast<std::size_t>(count + 1));
+    std::vector<index_t> end(dist.size());
+    CHECK_THROWS(segmental_dtw(column_major<const double>(D.data(), N1, N2), band, length, count + 1, dist.data(),
+                               end.data()));
+}
+
+TEST_MAIN()
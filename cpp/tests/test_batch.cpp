@@ -0,0 +1,68 @@
+// Query-lane batches must give each query exactly its single-query hit.
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/batch.hpp"
+#include "qbestd/fused.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+template <class Pattern, class Norm>
+void compare_single(Metric metric)
+{
+    std::mt19937 gen(9);
+    const index_t dims = 6, M = 47;
+    const std::vector<double> R = random_frames(dims, M, gen);
+    const MatrixView<const double> ref = column_major(R.data(), dims, M);
+
+    // 11 queries: not a multiple of any lane count, lengths 1..20
+    std::vector<std::vector<double>> data;
+    std::vector<MatrixView<const double>> queries;
+    for (index_t q = 0; q < 11; ++q)
+        data.push_back(random_frames(dims, 1 + (q * 7) % 20, gen));
+    for (const std::vector<double>& x : data)
+        queries.push_back(column_major(x.data(), dims, index_t(x.size()) / dims));
+
+    for (Isa isa : available_isas()) {
+        const std::vector<Hit<double>> hits = search_batch<Pattern, Norm>(ref, queries, metric, isa);
+        CHECK(hits.size() == queries.size());
+        for (std::size_t q = 0; q < queries.size(); ++q) {
+            const Hit<double> want =
+                dtw_features<Pattern, Norm>(ref, queries[q], metric, Isa::Scalar);
+            CHECK(hits[q].end == want.end);
+            CHECK(hits[q].start == want.start);
+            CHECK_NEAR(hits[q].dist, want.dist, 0.0);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("NSDTW batches")
+{
+    compare_single<NSDTW3, Accumulated>(Metric::SqEuclidean);
+    compare_single<NSDTW5, Accumulated>(Metric::InnerProduct);
+    compare_single<NSDTW3, Normalized>(Metric::SymmetricKL);
+}
+
+TEST_CASE("In-column patterns run in query lanes too")
+{
+    compare_single<GTTS, Accumulated>(Metric::NormInnerProduct);
+    compare_single<GTTS, Normalized>(Metric::Bhattacharyya);
+    compare_single<NewNSDTW, Accumulated>(Metric::SqEuclidean);
+    compare_single<OpenEndDTW, Accumulated>(Metric::InnerProduct);
+}
+
+TEST_CASE("Batch input checks")
+{
+    const std::vector<double> R(12, 0.5), Q(8, 0.5);
+    const std::vector<MatrixView<const double>> bad = {column_major(Q.data(), 4, 2)};
+    CHECK_THROWS(search_batch<GTTS>(column_major(R.data(), 3, 4), bad, Metric::SqEuclidean));
+    CHECK(search_batch<GTTS>(column_major(R.data(), 3, 4), {}, Metric::SqEuclidean).empty());
+}
+
+TEST_MAIN()
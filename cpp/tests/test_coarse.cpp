@@ -0,0 +1,115 @@
+// The coarse pass must lead the refinement to the hits of the full
+// search when the query occurs in the reference, and pooling must
+// average whole groups of frames.
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/coarse.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+struct Planted {
+    std::vector<double> ref, qry;
+    index_t dims, M, N;
+};
+
+// A random reference holding noisy copies of the query at `at`.
+Planted planted(const std::vector<index_t>& at, std::mt19937& gen)
+{
+    Planted p{{}, {}, 12, 3000, 48};
+    std::normal_distribution<double> noise(0.0, 0.02);
+    p.ref = random_frames(p.dims, p.M, gen, 0.05);
+    p.qry = random_frames(p.dims, p.N, gen, 0.05);
+    for (std::size_t k = 0; k < at.size(); ++k)
+        for (index_t i = 0; i < p.dims * p.N; ++i)
+            p.ref[std::size_t(at[k] * p.dims + i)] = p.qry[std::size_t(i)] + double(k) * 0.01 + noise(gen);
+    return p;
+}
+
+template <class Pattern>
+void compare_full(Metric metric)
+{
+    std::mt19937 gen(101);
+    const Planted p = planted({310, 1777, 2600}, gen);
+    const MatrixView<const double> ref = column_major(p.ref.data(), p.dims, p.M);
+    const MatrixView<const double> qry = column_major(p.qry.data(), p.dims, p.N);
+    for (Isa isa : available_isas()) {
+        // The distance reductions round differently per instruction set
+        const Hit<double> want = dtw_features<Pattern>(ref, qry, metric, isa);
+        const std::vector<Hit<double>> want_top = dtw_features<Pattern>(ref, qry, metric, TopK{3, 0.0}, isa);
+        for (index_t factor : {1, 2, 4}) {
+            const CoarseOptions opt{factor, 4, 0.5, isa};
+            const Hit<double> got = dtw_coarse<Pattern>(ref, qry, metric, opt);
+            CHECK(got.end == want.end);
+            CHECK(got.start == want.start);
+            CHECK(got.dist == want.dist);
+            const std::vector<Hit<double>> top = dtw_coarse<Pattern>(ref, qry, metric, TopK{3, 0.0}, opt);
+            CHECK(top.size() == want_top.size());
+            for (std::size_t k = 0; k < top.size() && k < want_top.size(); ++k) {
+                CHECK(top[k].end == want_top[k].end);
+                CHECK(top[k].start == want_top[k].start);
+                CHECK(top[k].dist == want_top[k].dist);
+            }
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("Pooling averages groups of frames")
+{
+    const std::vector<double> X = {1, 10, 3, 30, 5, 50, 7, 70, 9, 90};
+    const Scratch<double> p = detail::pool(column_major(X.data(), 2, 5), 2);
+    CHECK(p.size() == 6);
+    const std::vector<double> want = {2, 20, 6, 60, 9, 90};
+    for (std::size_t i = 0; i < want.size(); ++i)
+        CHECK_NEAR(p[i], want[i], 0.0);
+
+    const std::vector<Hit<double>> coarse = {{0, 10, 12}, {0, 0, 1}, {0, 14, 20}};
+    const auto regions = detail::fine_regions(coarse, 4, 3, 70);
+    CHECK(regions.size() == 2);
+    CHECK(regions[0].first == 0 && regions[0].second == 10);
+    CHECK(regions[1].first == 37 && regions[1].second == 69);
+}
+
+TEST_CASE("Refined hits match the full search")
+{
+    compare_full<NSDTW3>(Metric::SqEuclidean);
+    compare_full<GTTS>(Metric::SqEuclidean);
+    compare_full<NSDTW5>(Metric::SymmetricKL);
+}
+
+TEST_CASE("A region without margin still holds a path that climbs at once")
+{
+    // Factor 1 makes the coarse pass the full search; the refinement
+    // must not turn the first rows of its region into boundary rows
+    std::mt19937 gen(103);
+    const Planted p = planted({1200}, gen);
+    const MatrixView<const double> ref = column_major(p.ref.data(), p.dims, p.M);
+    const MatrixView<const double> qry = column_major(p.qry.data(), p.dims, p.N);
+    const CoarseOptions opt{1, 1, 0.0, active_isa()};
+    const Hit<double> want3 = dtw_features<NSDTW3>(ref, qry, Metric::SqEuclidean, opt.isa);
+    const Hit<double> got3 = dtw_coarse<NSDTW3>(ref, qry, Metric::SqEuclidean, opt);
+    CHECK(got3.start == want3.start && got3.end == want3.end && got3.dist == want3.dist);
+    const Hit<double> want5 = dtw_features<NSDTW5>(ref, qry, Metric::SqEuclidean, opt.isa);
+    const Hit<double> got5 = dtw_coarse<NSDTW5>(ref, qry, Metric::SqEuclidean, opt);
+    CHECK(got5.start == want5.start && got5.end == want5.end && got5.dist == want5.dist);
+}
+
+TEST_CASE("Invalid options")
+{
+    const std::vector<double> X(24, 0.5);
+    const MatrixView<const double> v = column_major(X.data(), 2, 12);
+    CHECK_THROWS(dtw_coarse<NSDTW3>(v, v, Metric::SqEuclidean, CoarseOptions{0}));
+    CHECK_THROWS(dtw_coarse<NSDTW3>(v, v, Metric::SqEuclidean, CoarseOptions{2, 0}));
+    CHECK_THROWS(dtw_coarse<NSDTW3>(v, v, Metric::SqEuclidean, CoarseOptions{2, 1, -1.0}));
+    // A factor beyond both lengths pools each into a single frame
+    const MatrixView<const double> q = column_major(X.data(), 2, 3);
+    CHECK(dtw_coarse<NSDTW3>(v, q, Metric::SqEuclidean, CoarseOptions{20}).dist == 0.0);
+}
+
+TEST_MAIN()
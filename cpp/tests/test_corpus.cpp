@@ -0,0 +1,94 @@
+// Corpus search must match a serial loop of dtw_features calls for any
+// thread count, batch size and chunking.
+#include <atomic>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/corpus.hpp"
+#include "qbestd/fused.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+std::vector<MatrixView<const double>> views(const std::vector<std::vector<double>>& data, index_t dims)
+{
+    std::vector<MatrixView<const double>> out;
+    for (const std::vector<double>& x : data)
+        out.push_back(column_major(x.data(), dims, index_t(x.size()) / dims));
+    return out;
+}
+
+template <class Pattern>
+void compare_serial(Metric metric)
+{
+    std::mt19937 gen(21);
+    const index_t dims = 5;
+    std::vector<std::vector<double>> qdata, udata;
+    for (index_t q = 0; q < 13; ++q)
+        qdata.push_back(random_frames(dims, 2 + (q * 5) % 17, gen));
+    for (index_t u = 0; u < 23; ++u)
+        udata.push_back(random_frames(dims, 20 + (u * 13) % 50, gen));
+    const std::vector<MatrixView<const double>> queries = views(qdata, dims), utts = views(udata, dims);
+
+    for (const CorpusOptions& opt : {CorpusOptions{3, 1, 32, 20000, Isa::Scalar},
+                                     CorpusOptions{3, 4, 5, 60, active_isa()},
+                                     CorpusOptions{30, 7, 1, 1, active_isa()}}) {
+        const std::vector<std::vector<CorpusHit<double>>> got =
+            search_corpus<Pattern>(queries, utts, metric, opt);
+        CHECK(got.size() == queries.size());
+        for (std::size_t q = 0; q < queries.size(); ++q) {
+            std::vector<CorpusHit<double>> want;
+            for (std::size_t u = 0; u < utts.size(); ++u)
+                want.push_back({index_t(u), dtw_features<Pattern>(utts[u], queries[q], metric, Isa::Scalar)});
+            std::stable_sort(want.begin(), want.end(), [](const auto& a, const auto& b) {
+                return a.hit.dist < b.hit.dist;
+            });
+            want.resize(std::min(opt.top_k, want.size()));
+            CHECK(got[q].size() == want.size());
+            for (std::size_t k = 0; k < want.size() && k < got[q].size(); ++k) {
+                CHECK(got[q][k].utterance == want[k].utterance);
+                CHECK(got[q][k].hit.end == want[k].hit.end);
+                CHECK(got[q][k].hit.start == want[k].hit.start);
+                CHECK_NEAR(got[q][k].hit.dist, want[k].hit.dist, 0.0);
+            }
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("Corpus search matches the serial loop")
+{
+    compare_serial<NSDTW3>(Metric::SqEuclidean);
+    compare_serial<GTTS>(Metric::NormInnerProduct);
+}
+
+TEST_CASE("Every task runs once and errors propagate")
+{
+    std::vector<std::atomic<int>> runs(1000);
+    run_tasks(runs.size(), 8, [&](std::size_t t, unsigned) { ++runs[t]; });
+    bool once = true;
+    for (const std::atomic<int>& r : runs)
+        once = once && r == 1;
+    CHECK(once);
+
+    CHECK_THROWS(run_tasks(100, 4, [](std::size_t t, unsigned) {
+        if (t == 37)
+            throw std::runtime_error("task failed");
+    }));
+    run_tasks(0, 4, [](std::size_t, unsigned) { throw std::runtime_error("no tasks"); });
+}
+
+TEST_CASE("Corpus input checks")
+{
+    const std::vector<double> R(12, 0.5), Q(8, 0.5);
+    const std::vector<MatrixView<const double>> utts = {column_major(R.data(), 3, 4)};
+    CHECK_THROWS(search_corpus<GTTS>({column_major(Q.data(), 4, 2)}, utts, Metric::SqEuclidean));
+    CHECK(search_corpus<GTTS>({}, utts, Metric::SqEuclidean).empty());
+}
+
+TEST_MAIN()
@@ -0,0 +1,171 @@
+// The counters must add up to the work each search states: M x N cells
+// and distances for a full search, computed plus pruned cells for a cut
+// off one, every pair of a corpus search. The other tests build without
+// them, which covers the empty hooks.
+#define QBESTD_COUNTERS 1
+
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/qbestd.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+double seconds(const Counters& c, Stage stage)
+{
+    return c.seconds[std::size_t(stage)];
+}
+
+} // namespace
+
+TEST_CASE("Full searches count every cell")
+{
+    std::mt19937 gen(5);
+    const index_t dims = 13, M = 300, N = 40;
+    const std::vector<double> D = random_values(std::size_t(M * N), gen);
+    const std::vector<double> R = random_frames(dims, M, gen), Q = random_frames(dims, N, gen);
+
+    reset_counters();
+    dtw_rolling<NSDTW3>(column_major(D.data(), M, N));
+    CounterSnapshot snap = counter_snapshot();
+    CHECK(snap.enabled);
+    CHECK(snap.total.cells == std::uint64_t(M * N));
+    CHECK(snap.total.distances == 0);
+    CHECK(snap.total.cells_pruned == 0);
+    CHECK(seconds(snap.total, Stage::Dp) > 0);
+    CHECK(seconds(snap.total, Stage::Distance) == 0);
+
+    reset_counters();
+    dtw_features<GTTS, Normalized>(column_major(R.data(), dims, M), column_major(Q.data(), dims, N),
+                                   Metric::SqEuclidean);
+    snap = counter_snapshot();
+    CHECK(snap.total.cells == std::uint64_t(M * N));
+    CHECK(snap.total.distances == std::uint64_t(M * N));
+    for (Stage stage : {Stage::Load, Stage::Distance, Stage::Dp})
+        CHECK(seconds(snap.total, stage) > 0);
+
+    reset_counters();
+    std::vector<double> full(D.size());
+    distance_matrix(column_major<const double>(R.data(), dims, M), column_major<const double>(Q.data(), dims, N),
+                    Metric::SqEuclidean, column_major(full.data(), M, N));
+    snap = counter_snapshot();
+    CHECK(snap.total.distances == std::uint64_t(M * N));
+    CHECK(snap.total.cells == 0);
+}
+
+TEST_CASE("Cut off searches count what they skip")
+{
+    std::mt19937 gen(6);
+    const index_t M = 500, N = 30;
+    const std::vector<double> D = random_values(std::size_t(M * N), gen);
+    const MatrixView<const double> Dv = column_major(D.data(), M, N);
+
+    // A loose cutoff prunes cells but reaches the last column
+    const Hit<double> best = dtw_rolling<NSDTW3>(Dv);
+    reset_counters();
+    dtw_rolling<NSDTW3>(Dv, BestSoFar{best.dist * 1.05});
+    CounterSnapshot snap = counter_snapshot();
+    CHECK(snap.total.cells + snap.total.cells_pruned == std::uint64_t(M * N));
+    CHECK(snap.total.cells_pruned > 0);
+    CHECK(snap.total.columns_abandoned == 0);
+
+    // One no path meets abandons the search in its first column
+    reset_counters();
+    CHECK(!dtw_rolling<NSDTW3>(Dv, BestSoFar{1e-9}));
+    snap = counter_snapshot();
+    CHECK(snap.total.cells == std::uint64_t(M));
+    CHECK(snap.total.cells_pruned == std::uint64_t(M * (N - 1)));
+    CHECK(snap.total.columns_abandoned == std::uint64_t(N - 1));
+}
+
+TEST_CASE("Corpus searches count every pair and every worker")
+{
+    std::mt19937 gen(7);
+    const index_t dims = 8;
+    std::vector<std::vector<double>> r, q;
+    std::vector<MatrixView<const double>> refs, queries;
+    std::uint64_t pairs = 0;
+    for (index_t u = 0; u < 12; ++u)
+        r.push_back(random_frames(dims, 100 + 10 * u, gen));
+    for (index_t i = 0; i < 5; ++i)
+        q.push_back(random_frames(dims, 10 + i, gen));
+    for (const std::vector<double>& x : r)
+        refs.push_back(column_major(x.data(), dims, index_t(x.size()) / dims));
+    for (const std::vector<double>& x : q)
+        queries.push_back(column_major(x.data(), dims, index_t(x.size()) / dims));
+    for (MatrixView<const double> ref : refs)
+        for (MatrixView<const double> qry : queries)
+            pairs += std::uint64_t(ref.cols * qry.cols);
+
+    CorpusOptions opt;
+    opt.top_k = 3;
+    opt.threads = 3;
+    opt.chunk_frames = 300;
+    for (bool prune : {false, true}) {
+        opt.prune = prune;
+        reset_counters();
+        search_corpus<GTTS, Normalized>(queries, refs, Metric::SqEuclidean, opt);
+        const CounterSnapshot snap = counter_snapshot();
+        CHECK(snap.total.cells == snap.total.distances);
+        CHECK(snap.total.cells + snap.total.cells_pruned == pairs);
+        CHECK(prune || snap.total.cells_pruned == 0);
+        CHECK(seconds(snap.total, Stage::Merge) > 0);
+
+        std::uint64_t tasks = 0;
+        for (const ThreadCounters& t : snap.threads) {
+            tasks += t.tasks;
+            CHECK(t.busy_seconds <= t.worker_seconds);
+            CHECK(t.utilization() >= 0 && t.utilization() <= 1);
+        }
+        CHECK(tasks > 1);
+    }
+}
+
+TEST_CASE("Scratch allocations are counted")
+{
+    std::thread([] {
+        release_scratch();
+        reset_counters();
+        {
+            Scratch<double> a(1000);
+            Scratch<double> b(10);
+        }
+        Scratch<double> again(1000);
+        const CounterSnapshot snap = counter_snapshot();
+        CHECK(snap.total.bytes_allocated == 8000 + 128);
+    }).join();
+}
+
+TEST_CASE("Snapshots export as JSON and Prometheus text")
+{
+    std::mt19937 gen(8);
+    const std::vector<double> D = random_values(200, gen);
+    reset_counters();
+    dtw_rolling<GTTS>(column_major(D.data(), 20, 10));
+    const CounterSnapshot snap = counter_snapshot();
+
+    const std::string json = to_json(snap);
+    CHECK(json.find("\"enabled\": true") != std::string::npos);
+    CHECK(json.find("\"cells\": 200") != std::string::npos);
+    CHECK(json.find("\"dp\": ") != std::string::npos);
+    CHECK(json.find("\"utilization\": ") != std::string::npos);
+
+    const std::string text = to_prometheus(snap);
+    CHECK(text.find("# TYPE qbestd_cells_total counter\n") != std::string::npos);
+    CHECK(text.find("qbestd_cells_total{slot=\"") != std::string::npos);
+    CHECK(text.find("qbestd_stage_seconds_total{stage=\"merge\",slot=\"") != std::string::npos);
+    CHECK(text.find("qbestd_counters_enabled 1\n") != std::string::npos);
+
+    reset_counters();
+    const CounterSnapshot zero = counter_snapshot();
+    CHECK(zero.total.cells == 0);
+    CHECK(zero.threads.empty());
+}
+
+TEST_MAIN()
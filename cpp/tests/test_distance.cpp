@@ -0,0 +1,104 @@
+// Local distances of Fx_do_SDTW.m and the fused feature -> DTW path.
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/fused.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+// Straight transcription of the MATLAB formulas.
+double reference(Metric metric, const double* x, const double* y, index_t dims)
+{
+    double acc = 0, ex = 0, ey = 0;
+    for (index_t i = 0; i < dims; ++i) {
+        ex += x[i] * x[i];
+        ey += y[i] * y[i];
+    }
+    for (index_t i = 0; i < dims; ++i) {
+        switch (metric) {
+        case Metric::SqEuclidean: acc += (x[i] - y[i]) * (x[i] - y[i]); break;
+        case Metric::InnerProduct: acc += x[i] * y[i]; break;
+        case Metric::NormInnerProduct: acc += (x[i] / ex) * (y[i] / ey); break;
+        case Metric::SymmetricKL: acc += (x[i] - y[i]) * (std::log(x[i]) - std::log(y[i])); break;
+        case Metric::Bhattacharyya: acc += std::sqrt(x[i] * y[i]); break;
+        }
+    }
+    if (metric == Metric::SqEuclidean || metric == Metric::SymmetricKL)
+        return acc;
+    return -std::log(acc);
+}
+
+const Metric all_metrics[] = {Metric::SqEuclidean, Metric::InnerProduct, Metric::NormInnerProduct,
+                              Metric::SymmetricKL, Metric::Bhattacharyya};
+
+} // namespace
+
+TEST_CASE("Type_localdist codes")
+{
+    CHECK(parse_metric("s") == Metric::SqEuclidean);
+    CHECK(parse_metric("i") == Metric::InnerProduct);
+    CHECK(parse_metric("in") == Metric::NormInnerProduct);
+    CHECK(parse_metric("k") == Metric::SymmetricKL);
+    CHECK(parse_metric("b") == Metric::Bhattacharyya);
+    CHECK_THROWS(parse_metric("x"));
+}
+
+TEST_CASE("Frame distances match the MATLAB formulas on every ISA")
+{
+    for (index_t dims : {1, 3, 8, 39}) {
+        const index_t N1 = 23, N2 = 5;
+        std::mt19937 gen(1);
+        const std::vector<double> R = random_posteriors(dims, N1, gen), Q = random_posteriors(dims, N2, gen);
+        for (Metric metric : all_metrics) {
+            const FrameDistance<double> dist(column_major(R.data(), dims, N1),
+                                             column_major(Q.data(), dims, N2), metric);
+            CHECK(dist.rows() == N1 && dist.cols() == N2);
+            for (Isa isa : available_isas()) {
+                std::vector<double> col(static_cast<std::size_t>(N1));
+                for (index_t n = 0; n < N2; ++n) {
+                    dist.column(n, col.data(), isa);
+                    for (index_t m = 0; m < N1; ++m)
+                        CHECK_NEAR(col[m], reference(metric, &R[m * dims], &Q[n * dims], dims),
+                                   1e-12);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Fused DTW equals DTW over the materialized matrix")
+{
+    const index_t dims = 13, N1 = 61, N2 = 9;
+    std::mt19937 gen(3);
+    const std::vector<double> R = random_posteriors(dims, N1, gen), Q = random_posteriors(dims, N2, gen);
+    const MatrixView<const double> ref = column_major(R.data(), dims, N1);
+    const MatrixView<const double> qry = column_major(Q.data(), dims, N2);
+    for (Metric metric : all_metrics) {
+        const FrameDistance<double> dist(ref, qry, metric);
+        std::vector<double> D(std::size_t(N1 * N2));
+        for (index_t n = 0; n < N2; ++n)
+            dist.column(n, &D[n * N1]);
+        const MatrixView<const double> Dv = column_major<const double>(D.data(), N1, N2);
+
+        const Hit<double> a = dtw<NSDTW3>(Dv), b = dtw_features<NSDTW3>(ref, qry, metric);
+        CHECK(a.end == b.end && a.start == b.start);
+        CHECK_NEAR(a.dist, b.dist, 0.0);
+        const Hit<double> c = dtw<GTTS, Normalized>(Dv), d = dtw_features<GTTS, Normalized>(dist);
+        CHECK(c.end == d.end && c.start == d.start);
+        CHECK_NEAR(c.dist, d.dist, 0.0);
+    }
+}
+
+TEST_CASE("Mismatched feature dimensions are rejected")
+{
+    const std::vector<double> R(12, 0.5), Q(12, 0.5);
+    CHECK_THROWS(FrameDistance<double>(column_major(R.data(), 3, 4), column_major(Q.data(), 4, 3),
+                                       Metric::SqEuclidean));
+}
+
+TEST_MAIN()
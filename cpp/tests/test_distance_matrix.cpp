@@ -0,0 +1,66 @@
+// Blocked distance matrix against the per-column distances, and the
+// polynomial log against std::log (the SIMD builds run the same code,
+// checked through the 'i' metric).
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/distance_matrix.hpp"
+
+using namespace qbestd;
+
+TEST_CASE("Vectorized log")
+{
+    for (double x : {1e-300, 2.2250738585072014e-308, 1e-8, 0.25, 0.70710678, 0.7071068, 1.0,
+                     1.0 + 1e-12, 1.5, 2.0, 10.0, 12345.678, 1e300}) {
+        const double want = std::log(x);
+        CHECK_NEAR(detail::scalar::vlog<Scalar<double>>(x), want, 4e-16 * std::fabs(want) + 1e-300);
+    }
+}
+
+TEST_CASE("Blocked product matches the per-column distances")
+{
+    const Metric metrics[] = {Metric::SqEuclidean, Metric::InnerProduct, Metric::NormInnerProduct,
+                              Metric::SymmetricKL, Metric::Bhattacharyya};
+    // dims 300 spans two k blocks; frame counts are not tile multiples.
+    for (index_t dims : {1, 39, 300}) {
+        const index_t N1 = 150, N2 = 7;
+        std::mt19937 gen(7);
+        const std::vector<double> R = random_posteriors(dims, N1, gen), Q = random_posteriors(dims, N2, gen);
+        const MatrixView<const double> ref = column_major(R.data(), dims, N1);
+        const MatrixView<const double> qry = column_major(Q.data(), dims, N2);
+        for (Metric metric : metrics) {
+            const FrameDistance<double> dist(ref, qry, metric);
+            std::vector<double> want(std::size_t(N1 * N2));
+            for (index_t n = 0; n < N2; ++n)
+                dist.column(n, &want[n * N1], Isa::Scalar);
+            for (Isa isa : available_isas()) {
+                const std::vector<double> D = distance_matrix(ref, qry, metric, isa);
+                for (std::size_t i = 0; i < D.size(); ++i)
+                    CHECK_NEAR(D[i], want[i], 1e-12 * (1 + std::fabs(want[i])));
+            }
+        }
+    }
+}
+
+TEST_CASE("Strided output and shape checks")
+{
+    const index_t dims = 5, N1 = 9, N2 = 3;
+    std::mt19937 gen(1);
+    const std::vector<double> R = random_posteriors(dims, N1, gen), Q = random_posteriors(dims, N2, gen);
+    const MatrixView<const double> ref = column_major(R.data(), dims, N1);
+    const MatrixView<const double> qry = column_major(Q.data(), dims, N2);
+    const std::vector<double> want = distance_matrix(ref, qry, Metric::SqEuclidean);
+
+    std::vector<double> row_major(std::size_t(N1 * N2));
+    distance_matrix(ref, qry, Metric::SqEuclidean, MatrixView<double>{row_major.data(), N1, N2, N2, 1});
+    for (index_t m = 0; m < N1; ++m)
+        for (index_t n = 0; n < N2; ++n)
+            CHECK_NEAR(row_major[m * N2 + n], want[n * N1 + m], 0.0);
+
+    CHECK_THROWS(distance_matrix(ref, qry, Metric::SqEuclidean, column_major(row_major.data(), N2, N1)));
+}
+
+TEST_MAIN()
@@ -0,0 +1,132 @@
+// Hand-worked examples for every step pattern of the reference engine.
+#include <vector>
+
+#include "check.hpp"
+#include "qbestd/dtw.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+MatrixView<const double> view(const std::vector<double>& d, index_t M, index_t N)
+{
+    return column_major(d.data(), M, N);
+}
+
+} // namespace
+
+TEST_CASE("NSDTW3 recurrence and start tracking")
+{
+    const std::vector<double> D = {1, 5, 2, 7, /**/ 3, 1, 4, 0};
+    std::vector<double> S(8), T(8), P(8);
+    const Hit<double> h = dtw<NSDTW3>(D.data(), 4, 2, 4, S.data(), T.data(), P.data());
+    CHECK_NEAR(S[4 + 2], 5.0, 0.0); // edge step from row 0
+    CHECK_NEAR(P[4 + 2], 0.0, 0.0);
+    CHECK_NEAR(S[4 + 3], 2.0, 0.0); // diagonal from row 2
+    CHECK(h.end == 3);
+    CHECK(h.start == 2);
+    CHECK_NEAR(h.dist, 1.0, 0.0);
+}
+
+TEST_CASE("NSDTW tie-breaking follows the original kernels")
+{
+    // NSDTW_c_skel prefers the horizontal predecessor...
+    const std::vector<double> D3 = {1, 1, 1, /**/ 0, 0, 0};
+    std::vector<double> S(6), T(6), P(6);
+    dtw<NSDTW3>(D3.data(), 3, 2, 3, S.data(), T.data(), P.data());
+    CHECK_NEAR(P[3 + 2], 2.0, 0.0);
+
+    // ...NSDTW_c_skel_4 the longest jump...
+    const std::vector<double> D4 = {1, 1, 1, 1, /**/ 0, 0, 0, 0};
+    std::vector<double> S4(8), T4(8), P4(8);
+    dtw<NSDTW4>(D4.data(), 4, 2, 4, S4.data(), T4.data(), P4.data());
+    CHECK_NEAR(P4[4 + 3], 0.0, 0.0);
+
+    // ...and NSDTW_c_skel_2 the diagonal.
+    const std::vector<double> D2 = {1, 1, 1, /**/ 0, 0, 0};
+    std::vector<double> S2(6), T2(6), P2(6);
+    dtw<NSDTW2>(D2.data(), 3, 2, 3, S2.data(), T2.data(), P2.data());
+    CHECK_NEAR(P2[3 + 2], 1.0, 0.0);
+}
+
+TEST_CASE("GTTS recurrence")
+{
+    const std::vector<double> D = {2, 1, 3, /**/ 1, 4, 1, /**/ 3, 1, 2};
+    const Hit<double> h = dtw<GTTS>(view(D, 3, 3));
+    CHECK(h.end == 1);
+    CHECK(h.start == 0);
+    CHECK_NEAR(h.dist, 4.0 / 3.0, 1e-15);
+}
+
+TEST_CASE("Normalized selection of the online kernels")
+{
+    const std::vector<double> D = {3, 3, /**/ 1, 0};
+    std::vector<double> S(4), T(4), P(4);
+    dtw<GTTS>(D.data(), 2, 2, 2, S.data(), T.data(), P.data());
+    CHECK_NEAR(S[3], 3.0, 0.0);
+    CHECK_NEAR(T[3], 2.0, 0.0);
+    CHECK_NEAR(P[3], 1.0, 0.0);
+
+    dtw<GTTS, Normalized>(D.data(), 2, 2, 2, S.data(), T.data(), P.data());
+    CHECK_NEAR(S[3], 4.0, 0.0);
+    CHECK_NEAR(T[3], 3.0, 0.0);
+    CHECK_NEAR(P[3], 0.0, 0.0);
+}
+
+TEST_CASE("newNSDTW second column")
+{
+    const std::vector<double> D = {1, 2, 3, /**/ 1, 1, 1, /**/ 2, 0, 1};
+    std::vector<double> S(9), T(9), P(9);
+    const Hit<double> h = dtw<NewNSDTW>(D.data(), 3, 3, 3, S.data(), T.data(), P.data());
+    CHECK_NEAR(T[3 + 1], 3.0, 0.0); // diagonal adds two in column 1
+    CHECK_NEAR(T[3 + 2], 4.0, 0.0);
+    CHECK(h.end == 1);
+    CHECK(h.start == 0);
+    CHECK_NEAR(h.dist, 0.5, 0.0);
+}
+
+TEST_CASE("Anchored DTW, open end and corner")
+{
+    const std::vector<double> D = {1, 2, 3, /**/ 2, 1, 5};
+    const Hit<double> open = dtw<OpenEndDTW>(view(D, 3, 2));
+    CHECK(open.end == 1);
+    CHECK_NEAR(open.dist, 1.0, 0.0);
+
+    const Hit<double> corner = dtw<BasicDTW>(view(D, 3, 2));
+    CHECK(corner.end == 2);
+    CHECK(corner.start == 0);
+    CHECK_NEAR(corner.dist, 7.0 / 3.0, 1e-15);
+}
+
+TEST_CASE("Strided and row-major inputs")
+{
+    const std::vector<double> D = {1, 5, 2, 7, /**/ 3, 1, 4, 0};
+    const Hit<double> ref = dtw<NSDTW3>(view(D, 4, 2));
+
+    std::vector<double> padded(2 * 6, -1.0);
+    for (index_t n = 0; n < 2; ++n)
+        for (index_t m = 0; m < 4; ++m)
+            padded[m + 6 * n] = D[m + 4 * n];
+    const Hit<double> ld = dtw<NSDTW3>(column_major<const double>(padded.data(), 4, 2, 6));
+
+    std::vector<double> row_major(8);
+    for (index_t n = 0; n < 2; ++n)
+        for (index_t m = 0; m < 4; ++m)
+            row_major[m * 2 + n] = D[m + 4 * n];
+    const Hit<double> rm = dtw<NSDTW3>(MatrixView<const double>{row_major.data(), 4, 2, 2, 1});
+
+    CHECK(ld.end == ref.end && rm.end == ref.end);
+    CHECK_NEAR(ld.dist, ref.dist, 0.0);
+    CHECK_NEAR(rm.dist, ref.dist, 0.0);
+}
+
+TEST_CASE("Invalid shapes are rejected")
+{
+    const std::vector<double> D = {1, 2, 3, 4};
+    std::vector<double> S(4), T(4), P(4);
+    CHECK_THROWS(dtw<GTTS>(view(D, 2, 2), column_major(S.data(), 2, 2),
+                           column_major(T.data(), 2, 2), column_major(P.data(), 2, 1)));
+    CHECK_THROWS(dtw<GTTS>(view(D, 0, 2)));
+}
+
+TEST_MAIN()
@@ -0,0 +1,235 @@
+// Every engine must return what the original MEX kernels returned: dist,
+// ep and the start row from P, on random inputs whose small integer
+// distances make ties frequent, so the tie-breaking of every original
+// min_fun_ind is exercised. The largest deviation of every engine is
+// printed; double engines must match exactly, float and fixed point up
+// to the rounding of their final division.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "golden.hpp"
+#include "qbestd/qbestd.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+struct Deviation {
+    double dist = 0;     // largest |dist - original dist|, relative for float and fixed point
+    long index = 0;      // runs with a different ep, start row or S/T/P cell
+    long runs = 0;
+    std::string kernel;  // where the largest deviation or the first mismatch occurred
+};
+
+std::map<std::string, Deviation>& report()
+{
+    static std::map<std::string, Deviation> engines;
+    return engines;
+}
+
+// The hit the original reports, as the engine states it.
+struct Expected {
+    double dist;
+    index_t end, start;
+};
+
+void note(const char* kernel, const std::string& engine, double dist, bool mismatch)
+{
+    Deviation& d = report()[engine];
+    if (dist > d.dist || (mismatch && d.index == 0 && d.dist == 0))
+        d.kernel = kernel;
+    d.dist = std::max(d.dist, dist);
+    d.index += mismatch;
+    ++d.runs;
+}
+
+template <class Real>
+void note(const char* kernel, const std::string& engine, const Expected& want, const Hit<Real>& got,
+          double scale = 1)
+{
+    note(kernel, engine, std::fabs(double(got.dist) - want.dist) / scale,
+         got.end != want.end || got.start != want.start);
+}
+
+template <class Pattern>
+Expected expected(const golden::Output& out, index_t M, index_t N, int ep_offset)
+{
+    const index_t end = index_t(out.ep) - ep_offset;
+    const index_t start = out.P.empty() ? 0 : index_t(out.P[std::size_t(end + M * (N - 1))]) - 1;
+    return {out.dist, end, start};
+}
+
+// An original kernel and the engine pattern behind its wrapper.
+template <class Pattern, class Norm>
+struct Kernel {
+    const char* name;
+    golden::Output (*original)(golden::Matrix);
+    int ep_offset;  // ep = end row + ep_offset
+};
+
+// Engines that take the distance matrix.
+template <class Pattern, class Norm>
+void on_matrix(const Kernel<Pattern, Norm>& k, const std::vector<double>& D, index_t M, index_t N)
+{
+    const golden::Output out = k.original(golden::Matrix{D.data(), int(M), int(N)});
+    const Expected want = expected<Pattern>(out, M, N, k.ep_offset);
+    const MatrixView<const double> Dv = column_major(D.data(), M, N);
+
+    for (Isa isa : available_isas()) {
+        std::vector<double> S(D.size()), T(D.size()), P(D.size());
+        const Hit<double> full = dtw<Pattern, Norm>(D.data(), M, N, M, S.data(), T.data(), P.data(), isa);
+        note(k.name, "dtw", want, full);
+        // The matrices the kernels returned, cell by cell
+        bool same = S == out.S && T == out.T;
+        for (std::size_t i = 0; i < out.P.size(); ++i)
+            same = same && P[i] + 1 == out.P[i];
+        note(k.name, "dtw S/T/P", 0.0, !same);
+
+        note(k.name, "dtw_rolling", want, dtw_rolling<Pattern, Norm>(Dv, isa));
+        note(k.name, "dtw_rolling top-k", want, dtw_rolling<Pattern, Norm>(Dv, TopK{1, 0.0}, isa).front());
+        note(k.name, "dtw_path", want, dtw_path<Pattern, Norm>(Dv, isa).hit);
+        if constexpr (!Norm::by_length || detail::one_cell_per_column<Pattern>) {
+            // A cutoff just above the hit, as tight as the pruning gets
+            const double cutoff = std::nextafter(want.dist, std::numeric_limits<double>::infinity());
+            const std::optional<Hit<double>> kept = dtw_rolling<Pattern, Norm>(Dv, BestSoFar{cutoff}, isa);
+            if (kept)
+                note(k.name, "dtw_rolling cutoff", want, *kept);
+            else
+                note(k.name, "dtw_rolling cutoff", 0.0, true);
+        }
+
+        // Integer sums are exact in float; only the final division rounds
+        const std::vector<float> Df(D.begin(), D.end());
+        note(k.name, "float32", want, dtw_rolling<Pattern, Norm>(column_major<const float>(Df.data(), M, N), isa),
+             std::max(want.dist, 1.0));
+        if constexpr (std::is_same_v<Norm, Accumulated>) {
+            const std::vector<std::uint16_t> Dq = quantize(Dv, 1.0);
+            const MatrixView<const std::uint16_t> Dqv = column_major<const std::uint16_t>(Dq.data(), M, N);
+            note(k.name, "fixed16", want, dtw_fixed<Pattern>(Dqv, 1.0, isa), std::max(want.dist, 1.0));
+        }
+    }
+}
+
+// D(m, n) between reference frame m and query frame n, as the fused
+// engines compute it on isa.
+std::vector<double> distances(MatrixView<const double> ref, MatrixView<const double> qry, Isa isa)
+{
+    const FrameDistance<double> dist(ref, qry, Metric::SqEuclidean);
+    std::vector<double> D(std::size_t(ref.cols * qry.cols));
+    for (index_t n = 0; n < qry.cols; ++n)
+        dist.column(n, D.data() + n * ref.cols, isa);
+    return D;
+}
+
+// Engines that compute the distances from feature frames.
+template <class Pattern, class Norm>
+void on_frames(const Kernel<Pattern, Norm>& k, const std::vector<MatrixView<const double>>& refs,
+               const std::vector<MatrixView<const double>>& queries)
+{
+    for (Isa isa : available_isas()) {
+        // want[q][u]: query q in reference u
+        std::vector<std::vector<Expected>> want(queries.size());
+        for (std::size_t q = 0; q < queries.size(); ++q)
+            for (MatrixView<const double> ref : refs) {
+                const index_t M = ref.cols, N = queries[q].cols;
+                const std::vector<double> D = distances(ref, queries[q], isa);
+                const golden::Output out = k.original(golden::Matrix{D.data(), int(M), int(N)});
+                want[q].push_back(expected<Pattern>(out, M, N, k.ep_offset));
+
+                note(k.name, "dtw_features", want[q].back(),
+                     dtw_features<Pattern, Norm>(ref, queries[q], Metric::SqEuclidean, isa));
+                if constexpr (Pattern::end == End::Open) {
+                    // The end point of every row as it arrives
+                    StreamSearch<Pattern, Norm> stream(queries[q], Metric::SqEuclidean, 0.0, isa);
+                    std::vector<Hit<double>> hits;
+                    for (index_t m = 0; m < M; ++m) {
+                        stream.push(MatrixView<const double>{&ref(0, m), ref.rows, 1, ref.row_stride, ref.col_stride},
+                                    hits);
+                        const std::size_t at = std::size_t(m + M * (N - 1));
+                        const index_t start = out.P.empty() ? 0 : index_t(out.P[at]) - 1;
+                        note(k.name, "StreamSearch", Expected{out.S[at] / out.T[at], m, start}, stream.last());
+                    }
+                }
+            }
+
+        const std::vector<Hit<double>> batch = search_batch<Pattern, Norm>(refs[0], queries, Metric::SqEuclidean, isa);
+        for (std::size_t q = 0; q < queries.size(); ++q)
+            note(k.name, "search_batch", want[q][0], batch[q]);
+
+        CorpusOptions opt;
+        opt.top_k = refs.size();
+        opt.threads = 2;
+        opt.isa = isa;
+        const std::vector<std::vector<CorpusHit<double>>> corpus =
+            search_corpus<Pattern, Norm>(queries, refs, Metric::SqEuclidean, opt);
+        for (std::size_t q = 0; q < queries.size(); ++q)
+            for (const CorpusHit<double>& h : corpus[q])
+                note(k.name, "search_corpus", want[q][std::size_t(h.utterance)], h.hit);
+    }
+}
+
+template <class Pattern, class Norm>
+void compare(const Kernel<Pattern, Norm>& k)
+{
+    std::mt19937 gen(2024);
+    std::uniform_int_distribution<int> rows(5, 60), cols(2, 16);
+    for (int trial = 0; trial < 40; ++trial) {
+        const index_t M = rows(gen), N = cols(gen);
+        on_matrix(k, random_levels(M, N, gen, 4, 1.0), M, N);
+    }
+
+    // Frames on a small integer grid: squared distances are exact
+    // integers on every instruction set
+    const index_t dims = 3;
+    auto frames = [&](index_t count) { return random_levels(dims, count, gen, 2, 1.0); };
+    for (int trial = 0; trial < 8; ++trial) {
+        std::vector<std::vector<double>> r, q;
+        std::vector<MatrixView<const double>> refs, queries;
+        for (int u = 0; u < 3; ++u)
+            r.push_back(frames(rows(gen)));
+        for (int i = 0; i < 5; ++i)
+            q.push_back(frames(cols(gen)));
+        for (const std::vector<double>& x : r)
+            refs.push_back(column_major(x.data(), dims, index_t(x.size()) / dims));
+        for (const std::vector<double>& x : q)
+            queries.push_back(column_major(x.data(), dims, index_t(x.size()) / dims));
+        on_frames(k, refs, queries);
+    }
+}
+
+} // namespace
+
+TEST_CASE("Engines reproduce the original kernels")
+{
+    compare(Kernel<NSDTW3, Accumulated>{"NSDTW_c_skel", golden::NSDTW_c_skel, 1});
+    compare(Kernel<NSDTW2, Accumulated>{"NSDTW_c_skel_2", golden::NSDTW_c_skel_2, 1});
+    compare(Kernel<NSDTW4, Accumulated>{"NSDTW_c_skel_4", golden::NSDTW_c_skel_4, 1});
+    compare(Kernel<NSDTW5, Accumulated>{"NSDTW_c_skel_5", golden::NSDTW_c_skel_5, 1});
+    compare(Kernel<NSDTW3, Normalized>{"NSDTW_c_skel_online", golden::NSDTW_c_skel_online, 1});
+    compare(Kernel<NewNSDTW, Accumulated>{"newNSDTW_c_skel", golden::newNSDTW_c_skel, 1});
+    compare(Kernel<NewNSDTW, Normalized>{"newNSDTW_c_skel_online", golden::newNSDTW_c_skel_online, 1});
+    compare(Kernel<GTTS, Accumulated>{"GTTS_DTW_c_skel", golden::GTTS_DTW_c_skel, 1});
+    compare(Kernel<GTTS, Normalized>{"GTTS_DTW_c_skel_online", golden::GTTS_DTW_c_skel_online, 1});
+    compare(Kernel<GTTS, Normalized>{"sub_DTW_c_skel_online", golden::sub_DTW_c_skel_online, 1});
+    compare(Kernel<OpenEndDTW, Accumulated>{"DTW_c_skel_nobt", golden::DTW_c_skel_nobt, 0});
+    compare(Kernel<BasicDTW, Accumulated>{"DTW_c_basic_skel_nobt", golden::DTW_c_basic_skel_nobt, 1});
+
+    std::printf("%-20s %8s %12s %10s  %s\n", "engine", "runs", "max |dist|", "mismatches", "worst kernel");
+    for (const auto& [engine, d] : report()) {
+        std::printf("%-20s %8ld %12.3g %10ld  %s\n", engine.c_str(), d.runs, d.dist, d.index, d.kernel.c_str());
+        const bool rounded = engine == "float32" || engine == "fixed16";
+        CHECK(d.index == 0);
+        CHECK(d.dist <= (rounded ? 1e-6 : 0.0));
+    }
+}
+
+TEST_MAIN()
@@ -0,0 +1,220 @@
+// The front end must compute librosa's MFCC recipe on every instruction
+// set: the lane FFT, filterbank and DCT are checked against a direct
+// O(n^2) DFT of every frame. Streaming in pieces must give the frames
+// of the whole signal, and a query cut from a signal must be found
+// there when the frames stream straight into StreamSearch.
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/qbestd.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+
+// Speech-like test signal: a few drifting tones in noise.
+Audio signal(int rate, std::size_t count, unsigned seed)
+{
+    std::mt19937 gen(seed);
+    std::normal_distribution<float> noise(0.0f, 0.02f);
+    Audio a{rate, std::vector<float>(count)};
+    for (std::size_t t = 0; t < count; ++t) {
+        const double s = double(t) / rate;
+        a.samples[t] = float(0.3 * std::sin(2 * pi * (300 + 200 * std::sin(3 * s)) * s)
+                             + 0.2 * std::sin(2 * pi * 1800 * s) * std::sin(2 * pi * 2 * s))
+                     + noise(gen);
+    }
+    return a;
+}
+
+// librosa's recipe with a direct DFT per frame, in double.
+std::vector<double> direct_mfcc(const Audio& a, const MfccOptions& opt)
+{
+    const index_t n = opt.n_fft, bins = n / 2 + 1, length = index_t(a.samples.size());
+    const index_t frames = 1 + length / opt.hop;
+    std::vector<double> fb(std::size_t(opt.n_mels * bins));
+    auto mel = [](double hz) { return hz >= 1000 ? 15 + std::log(hz / 1000) / (std::log(6.4) / 27) : hz * 3 / 200; };
+    auto hz = [](double m) { return m >= 15 ? 1000 * std::exp(std::log(6.4) / 27 * (m - 15)) : m * 200 / 3; };
+    const double top = mel(opt.sample_rate / 2.0);
+    for (index_t m = 0; m < opt.n_mels; ++m) {
+        const double step = top / double(opt.n_mels + 1);
+        const double l = hz(step * double(m)), c = hz(step * double(m + 1)), r = hz(step * double(m + 2));
+        for (index_t k = 0; k < bins; ++k) {
+            const double f = double(k) * opt.sample_rate / double(n);
+            const double weight = std::max(0.0, std::min((f - l) / (c - l), (r - f) / (r - c)));
+            fb[std::size_t(m * bins + k)] = float(weight * 2 / (r - l));
+        }
+    }
+    std::vector<double> db(std::size_t(frames * opt.n_mels));
+    for (index_t f = 0; f < frames; ++f) {
+        std::vector<double> power(static_cast<std::size_t>(bins));
+        for (index_t k = 0; k < bins; ++k) {
+            double re = 0, im = 0;
+            for (index_t t = 0; t < n; ++t) {
+                const index_t i = f * opt.hop + t - n / 2;
+                const double x = i >= 0 && i < length ? a.samples[std::size_t(i)] : 0.0;
+                const double w = 0.5 - 0.5 * std::cos(2 * pi * double(t) / double(n));
+                re += w * x * std::cos(2 * pi * double(k * t) / double(n));
+                im -= w * x * std::sin(2 * pi * double(k * t) / double(n));
+            }
+            power[std::size_t(k)] = re * re + im * im;
+        }
+        for (index_t m = 0; m < opt.n_mels; ++m) {
+            double e = 0;
+            for (index_t k = 0; k < bins; ++k)
+                e += fb[std::size_t(m * bins + k)] * power[std::size_t(k)];
+            db[std::size_t(f * opt.n_mels + m)] = 10 * std::log10(std::max(e, 1e-10));
+        }
+    }
+    const double floor = *std::max_element(db.begin(), db.end()) - opt.top_db;
+    std::vector<double> out(std::size_t(frames * opt.n_mfcc));
+    for (index_t f = 0; f < frames; ++f) {
+        double* c = out.data() + f * opt.n_mfcc;
+        for (index_t k = 0; k < opt.n_mfcc; ++k) {
+            for (index_t m = 0; m < opt.n_mels; ++m)
+                c[k] += std::max(db[std::size_t(f * opt.n_mels + m)], floor)
+                      * std::cos(pi * double(k) * (2.0 * double(m) + 1) / (2.0 * double(opt.n_mels)));
+            c[k] *= std::sqrt((k == 0 ? 1.0 : 2.0) / double(opt.n_mels));
+        }
+        double mean = 0, var = 0;
+        for (index_t k = 0; k < opt.n_mfcc; ++k)
+            mean += c[k] / double(opt.n_mfcc);
+        for (index_t k = 0; k < opt.n_mfcc; ++k)
+            var += (c[k] - mean) * (c[k] - mean) / double(opt.n_mfcc);
+        for (index_t k = 0; k < opt.n_mfcc; ++k)
+            c[k] = (c[k] - mean) / std::sqrt(var);
+    }
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("Lane FFTs match a direct DFT on every instruction set")
+{
+    MfccOptions opt;
+    opt.sample_rate = 8000;
+    opt.n_fft = 256;
+    opt.hop = 80;
+    opt.n_mels = 40;
+    opt.n_mfcc = 13;
+    const Audio a = signal(8000, 2000, 1);
+    const std::vector<double> want = direct_mfcc(a, opt);
+    for (Isa isa : available_isas()) {
+        const Features<double> got = mfcc<double>(a, opt, isa);
+        CHECK(got.dims == 13);
+        CHECK(got.frames == 1 + 2000 / 80);
+        double worst = 0;
+        for (std::size_t i = 0; i < want.size(); ++i)
+            worst = std::max(worst, std::abs(got.values[i] - want[i]));
+        CHECK(worst < 1e-9);
+
+        const Features<float> single = mfcc<float>(a, opt, isa);
+        worst = 0;
+        for (std::size_t i = 0; i < want.size(); ++i)
+            worst = std::max(worst, std::abs(double(single.values[i]) - want[i]));
+        CHECK(worst < 1e-3);
+    }
+}
+
+TEST_CASE("Default options give 40 normalized coefficients per hop")
+{
+    const Audio a = signal(22050, 22050, 2);
+    const Features<double> f = mfcc<double>(a);
+    CHECK(f.dims == 40);
+    CHECK(f.frames == 1 + 22050 / 512);
+    for (index_t n = 0; n < f.frames; ++n) {
+        double mean = 0, var = 0;
+        for (index_t k = 0; k < 40; ++k)
+            mean += f.view()(k, n) / 40;
+        for (index_t k = 0; k < 40; ++k)
+            var += (f.view()(k, n) - mean) * (f.view()(k, n) - mean) / 40;
+        CHECK(std::abs(mean) < 1e-12);
+        CHECK(std::abs(var - 1) < 1e-12);
+    }
+
+    // Other rates are resampled first
+    const Features<double> g = mfcc<double>(signal(16000, 16000, 2));
+    CHECK(g.frames == 1 + 22050 / 512);
+
+    MfccOptions bad;
+    bad.n_fft = 1000;
+    CHECK_THROWS(mfcc<double>(a, bad));
+    bad = MfccOptions{};
+    bad.n_mfcc = 200;
+    CHECK_THROWS(mfcc<double>(a, bad));
+    CHECK_THROWS(mfcc<double>(Audio{22050, {}}));
+}
+
+TEST_CASE("Streamed frames are the frames of the whole signal")
+{
+    const Audio a = signal(22050, 30000, 3);
+    for (double top_db : {0.0, 80.0})
+        for (Isa isa : available_isas()) {
+            MfccOptions opt;
+            opt.top_db = top_db;
+            const Features<double> whole = mfcc<double>(a, opt, isa);
+            MfccStream<double> stream(opt, isa);
+            std::vector<double> out;
+            std::mt19937 gen(4);
+            std::uniform_int_distribution<std::size_t> piece(0, 3000);
+            for (std::size_t at = 0; at < a.samples.size();) {
+                const std::size_t count = std::min(piece(gen), a.samples.size() - at);
+                stream.push(a.samples.data() + at, count, out);
+                at += count;
+                CHECK(stream.frames() == index_t(out.size()) / 40);
+                // A frame is out as soon as its window is complete
+                CHECK(stream.frames() == (index_t(at) >= 1024 ? (index_t(at) - 1024) / 512 + 1 : 0));
+            }
+            stream.flush(out);
+            CHECK(stream.frames() == whole.frames);
+            // Without the floor, or once the loudest frame has passed, the
+            // frames agree exactly
+            CHECK(out.size() == whole.values.size());
+            if (top_db == 0)
+                CHECK(out == whole.values);
+            else
+                CHECK(std::equal(out.end() - 400, out.end(), whole.values.end() - 400));
+        }
+}
+
+TEST_CASE("A spoken query streams from audio to a detection")
+{
+    // The query is a second of the reference, about 2 s in
+    const Audio ref = signal(22050, 5 * 22050, 5);
+    const std::size_t from = 2 * 22050 + 1000, length = 22050;
+    const Audio query{22050, std::vector<float>(ref.samples.begin() + std::ptrdiff_t(from),
+                                                ref.samples.begin() + std::ptrdiff_t(from + length))};
+    const Features<double> q = mfcc<double>(query);
+
+    StreamSearch<GTTS, Normalized> search(q.view(), Metric::SqEuclidean, std::numeric_limits<double>::infinity());
+    MfccStream<double> frames;
+    std::vector<double> chunk;
+    std::vector<Hit<double>> hits;
+    Hit<double> best{std::numeric_limits<double>::infinity(), 0, 0};
+    auto consume = [&] {
+        search.push(column_major<const double>(chunk.data(), 40, index_t(chunk.size()) / 40), hits);
+        chunk.clear();
+    };
+    for (std::size_t at = 0; at < ref.samples.size(); at += 2205) {
+        frames.push(ref.samples.data() + at, std::min<std::size_t>(2205, ref.samples.size() - at), chunk);
+        consume();
+    }
+    frames.flush(chunk);
+    consume();
+    search.flush(hits);
+    for (const Hit<double>& h : hits)
+        if (h.dist < best.dist)
+            best = h;
+    const index_t start = index_t(from / 512), end = index_t((from + length) / 512);
+    CHECK(std::abs(best.start - start) <= 2);
+    CHECK(std::abs(best.end - end) <= 2);
+}
+
+TEST_MAIN()
@@ -0,0 +1,143 @@
+// The traced path must start at the hit's start row, end at its end row,
+// move only by the pattern's steps and add up to the accumulated cost of
+// the full recurrence.
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/path.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+// Weight the recurrence puts on D for a move into a cell.
+template <class... Steps>
+int weight_of(StepList<Steps...>, index_t dm, index_t dn)
+{
+    int w = 1;
+    ((w = Steps::dm == dm && Steps::dn == dn ? Steps::weight : w), ...);
+    return w;
+}
+
+template <class Pattern, class Norm>
+void check_paths()
+{
+    std::mt19937 gen(61);
+    for (int trial = 0; trial < 40; ++trial) {
+        const index_t M = 1 + (trial * 11) % 73, N = 1 + (trial * 5) % 19;
+        const std::vector<double> D = random_levels(M, N, gen, trial % 2 ? 3 : 1000);
+        const MatrixView<const double> view = column_major<const double>(D.data(), M, N);
+        std::vector<double> S(D.size()), T(D.size()), P(D.size());
+        const Hit<double> want = dtw<Pattern, Norm>(D.data(), M, N, M, S.data(), T.data(), P.data(), Isa::Scalar);
+
+        for (Isa isa : available_isas()) {
+            const Alignment<double> got = dtw_path<Pattern, Norm>(view, isa);
+            CHECK(got.hit.end == want.end);
+            CHECK(got.hit.start == want.start);
+            CHECK_NEAR(got.hit.dist, want.dist, 0.0);
+            CHECK(!got.path.empty());
+            if (got.path.empty())
+                continue;
+            CHECK(got.path.front().qry == 0);
+            CHECK(got.path.front().ref == (Pattern::start == Start::Free ? want.start : 0));
+            CHECK(got.path.back().qry == N - 1);
+            CHECK(got.path.back().ref == want.end);
+
+            double cost = view(got.path.front().ref, 0);
+            for (std::size_t i = 1; i < got.path.size(); ++i) {
+                const index_t dm = got.path[i].ref - got.path[i - 1].ref;
+                const index_t dn = got.path[i].qry - got.path[i - 1].qry;
+                CHECK(detail::moves<Pattern>.code(dm, dn) != 0);
+                cost += weight_of(typename Pattern::steps{}, dm, dn) * view(got.path[i].ref, got.path[i].qry);
+            }
+            CHECK_NEAR(cost, S[std::size_t((N - 1) * M + want.end)], 0.0);
+
+            // Strided D gives the same path
+            std::vector<double> Dt(D.size());
+            for (index_t m = 0; m < M; ++m)
+                for (index_t n = 0; n < N; ++n)
+                    Dt[std::size_t(m * N + n)] = D[std::size_t(n * M + m)];
+            const MatrixView<const double> row_major{Dt.data(), M, N, N, 1};
+            const Alignment<double> strided = dtw_path<Pattern, Norm>(row_major, isa);
+            CHECK(strided.path.size() == got.path.size());
+            for (std::size_t i = 0; i < got.path.size() && i < strided.path.size(); ++i)
+                CHECK(strided.path[i].ref == got.path[i].ref && strided.path[i].qry == got.path[i].qry);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("Code widths")
+{
+    CHECK(detail::moves<NSDTW3>.bits() == 2);
+    CHECK(detail::moves<NSDTW2>.bits() == 2);
+    CHECK(detail::moves<NSDTW5>.bits() == 3);
+    CHECK(detail::moves<GTTS>.bits() == 2);
+    CHECK(detail::moves<NewNSDTW>.bits() == 3);
+    CHECK(detail::moves<OpenEndDTW>.bits() == 2);
+    CHECK(detail::moves<SymmetricDTW>.bits() == 2);
+
+    detail::Traceback trace(100, 3, 3);
+    std::vector<unsigned char> codes(100, 0);
+    codes[20] = 5;
+    codes[21] = 7;
+    trace.set_column(1, codes.data());
+    codes.assign(100, 0);
+    codes[99] = 1;
+    trace.set_column(2, codes.data());
+    CHECK(trace(20, 1) == 5);
+    CHECK(trace(21, 1) == 7);
+    CHECK(trace(22, 1) == 0);
+    CHECK(trace(99, 2) == 1);
+    CHECK(trace(99, 1) == 0);
+    CHECK(trace.bytes() == 3 * 5 * 8);
+}
+
+TEST_CASE("Hand-worked NSDTW3 path")
+{
+    const std::vector<double> D = {1, 5, 2, 7, /**/ 3, 1, 4, 0};
+    const Alignment<double> a = dtw_path<NSDTW3>(column_major<const double>(D.data(), 4, 2));
+    CHECK(a.hit.end == 3);
+    CHECK(a.path.size() == 2);
+    CHECK(a.path[0].ref == 2 && a.path[0].qry == 0);
+    CHECK(a.path[1].ref == 3 && a.path[1].qry == 1);
+}
+
+TEST_CASE("Paths follow the recurrence")
+{
+    check_paths<NSDTW2, Accumulated>();
+    check_paths<NSDTW3, Accumulated>();
+    check_paths<NSDTW3, Normalized>();
+    check_paths<NSDTW5, Accumulated>();
+    check_paths<GTTS, Accumulated>();
+    check_paths<GTTS, Normalized>();
+    check_paths<NewNSDTW, Accumulated>();
+    check_paths<NewNSDTW, Normalized>();
+    check_paths<OpenEndDTW, Accumulated>();
+    check_paths<BasicDTW, Accumulated>();
+    check_paths<SymmetricDTW, Accumulated>();
+}
+
+TEST_CASE("Fused path matches the path on D")
+{
+    std::mt19937 gen(67);
+    const index_t dims = 8, M = 120, N = 15;
+    const std::vector<double> R = random_frames(dims, M, gen), Q = random_frames(dims, N, gen);
+    const MatrixView<const double> ref = column_major<const double>(R.data(), dims, M);
+    const MatrixView<const double> qry = column_major<const double>(Q.data(), dims, N);
+    const FrameDistance<double> dist(ref, qry, Metric::SqEuclidean);
+    std::vector<double> D(std::size_t(M * N));
+    for (index_t n = 0; n < N; ++n)
+        dist.column(n, D.data() + n * M);
+    const Alignment<double> want = dtw_path<GTTS>(column_major<const double>(D.data(), M, N));
+    const Alignment<double> got = dtw_path<GTTS>(ref, qry, Metric::SqEuclidean);
+    CHECK(got.hit.end == want.hit.end);
+    CHECK(got.path.size() == want.path.size());
+    for (std::size_t i = 0; i < got.path.size() && i < want.path.size(); ++i)
+        CHECK(got.path[i].ref == want.path[i].ref && got.path[i].qry == want.path[i].qry);
+}
+
+TEST_MAIN()
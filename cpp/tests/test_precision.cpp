@@ -0,0 +1,175 @@
+// float kernels must be bit-identical across instruction sets and agree
+// with double; the fixed-point recurrence must match double on exact
+// integer distances and saturate instead of wrapping.
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/batch.hpp"
+#include "qbestd/distance_matrix.hpp"
+#include "qbestd/fixed.hpp"
+#include "qbestd/fused.hpp"
+#include "qbestd/rolling.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+template <class Pattern, class Norm>
+void compare_float()
+{
+    std::mt19937 gen(41);
+    for (int trial = 0; trial < 30; ++trial) {
+        const index_t M = 1 + (trial * 13) % 83, N = 1 + (trial * 5) % 19;
+        const std::vector<double> D = random_levels(M, N, gen, 8);
+        const std::vector<float> Df(D.begin(), D.end());
+        const Hit<double> want = dtw_rolling<Pattern, Norm>(column_major<const double>(D.data(), M, N));
+        const Hit<float> ref = dtw_rolling<Pattern, Norm>(column_major<const float>(Df.data(), M, N), Isa::Scalar);
+        // Sums of halves are exact in float, so only the final division rounds
+        CHECK(ref.end == want.end);
+        CHECK(ref.start == want.start);
+        CHECK_NEAR(ref.dist, want.dist, 1e-6 * want.dist);
+
+        std::vector<float> S(Df.size()), T(Df.size()), P(Df.size());
+        for (Isa isa : available_isas()) {
+            const Hit<float> got = dtw_rolling<Pattern, Norm>(column_major<const float>(Df.data(), M, N), isa);
+            CHECK(got.end == ref.end);
+            CHECK(got.start == ref.start);
+            CHECK(got.dist == ref.dist);
+            const Hit<float> full = dtw<Pattern, Norm>(Df.data(), M, N, M, S.data(), T.data(), P.data(), isa);
+            CHECK(full.end == ref.end);
+            CHECK(full.dist == ref.dist);
+        }
+    }
+}
+
+template <class Pattern>
+void compare_float_features(Metric metric)
+{
+    std::mt19937 gen(43);
+    const index_t dims = 13, M = 150, N = 17;
+    std::vector<float> R = random_frames<float>(dims, M, gen);
+    const std::vector<float> Q = random_frames<float>(dims, N, gen);
+    std::copy(Q.begin(), Q.end(), R.begin() + 60 * dims);
+    const std::vector<double> Rd(R.begin(), R.end()), Qd(Q.begin(), Q.end());
+    const Hit<double> want = dtw_features<Pattern>(column_major<const double>(Rd.data(), dims, M),
+                                                   column_major<const double>(Qd.data(), dims, N), metric);
+    const FrameDistance<float> dist(column_major<const float>(R.data(), dims, M),
+                                    column_major<const float>(Q.data(), dims, N), metric);
+    std::vector<float> D(std::size_t(M * N));
+    for (Isa isa : available_isas()) {
+        for (index_t n = 0; n < N; ++n)
+            dist.column(n, D.data() + n * M, isa);
+        const Hit<float> got = dtw_features<Pattern>(dist, isa);
+        const Hit<float> on_d = dtw_rolling<Pattern>(column_major<const float>(D.data(), M, N), isa);
+        CHECK(got.end == on_d.end);
+        CHECK(got.dist == on_d.dist);
+        CHECK(got.end == want.end);
+        CHECK(got.start == want.start);
+        CHECK_NEAR(got.dist, want.dist, 1e-4 * (1 + std::fabs(want.dist)));
+    }
+}
+
+// Quantized D against double on the same integers.
+template <class Pattern>
+void compare_fixed()
+{
+    std::mt19937 gen(47);
+    for (int trial = 0; trial < 30; ++trial) {
+        const index_t M = 1 + (trial * 17) % 120, N = 1 + (trial * 3) % 21;
+        const std::vector<double> D = random_levels(M, N, gen, trial % 2 ? 3 : 400, 1 / 8.0);
+        const std::vector<std::uint16_t> q = quantize(column_major<const double>(D.data(), M, N), 8.0);
+        const Hit<double> want = dtw_rolling<Pattern>(column_major<const double>(D.data(), M, N));
+        for (Isa isa : available_isas()) {
+            const Hit<double> got = dtw_fixed<Pattern>(column_major(q.data(), M, N), 8.0, isa);
+            CHECK(got.end == want.end);
+            CHECK(got.start == want.start);
+            CHECK_NEAR(got.dist, want.dist, 1e-12 * want.dist);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("float recurrence")
+{
+    compare_float<NSDTW3, Accumulated>();
+    compare_float<NSDTW3, Normalized>();
+    compare_float<NSDTW5, Accumulated>();
+    compare_float<GTTS, Accumulated>();
+    compare_float<GTTS, Normalized>();
+    compare_float<NewNSDTW, Normalized>();
+    compare_float<OpenEndDTW, Accumulated>();
+    compare_float<SymmetricDTW, Accumulated>();
+}
+
+TEST_CASE("float features, matrix and batches")
+{
+    for (Metric metric : {Metric::SqEuclidean, Metric::InnerProduct, Metric::SymmetricKL, Metric::Bhattacharyya}) {
+        compare_float_features<NSDTW3>(metric);
+        compare_float_features<GTTS>(metric);
+    }
+
+    std::mt19937 gen(53);
+    const index_t dims = 20, M = 70, N = 33;
+    const std::vector<float> R = random_frames<float>(dims, M, gen), Q = random_frames<float>(dims, N, gen);
+    const MatrixView<const float> ref = column_major(R.data(), dims, M), qry = column_major(Q.data(), dims, N);
+    const std::vector<double> Rd(R.begin(), R.end()), Qd(Q.begin(), Q.end());
+    const std::vector<double> want = distance_matrix(column_major<const double>(Rd.data(), dims, M),
+                                                     column_major<const double>(Qd.data(), dims, N),
+                                                     Metric::InnerProduct);
+    for (Isa isa : available_isas()) {
+        const std::vector<float> D = distance_matrix(ref, qry, Metric::InnerProduct, isa);
+        for (std::size_t i = 0; i < D.size(); ++i)
+            CHECK_NEAR(D[i], want[i], 1e-5 * (1 + std::fabs(want[i])));
+
+        std::vector<MatrixView<const float>> queries;
+        for (index_t q = 0; q < 9; ++q)
+            queries.push_back(column_major(Q.data() + q * dims, dims, 1 + (q * 5) % (N - q)));
+        const std::vector<Hit<float>> hits = search_batch<GTTS>(ref, queries, Metric::SqEuclidean, isa);
+        for (std::size_t q = 0; q < queries.size(); ++q) {
+            const Hit<float> one = dtw_features<GTTS>(ref, queries[q], Metric::SqEuclidean, Isa::Scalar);
+            CHECK(hits[q].end == one.end);
+            CHECK(hits[q].start == one.start);
+            CHECK(hits[q].dist == one.dist);
+        }
+    }
+}
+
+TEST_CASE("Fixed point matches double on integer distances")
+{
+    compare_fixed<NSDTW3>();
+    compare_fixed<NSDTW5>();
+    compare_fixed<GTTS>();
+    compare_fixed<NewNSDTW>();
+    compare_fixed<OpenEndDTW>();
+    compare_fixed<SymmetricDTW>();
+}
+
+TEST_CASE("Fixed point saturates")
+{
+    const std::vector<double> raw{-1.0, 0.26, 0.24, 1e9, std::nan("")};
+    const std::vector<std::uint16_t> q = quantize(column_major<const double>(raw.data(), 5, 1), 4.0);
+    CHECK(q[0] == 0);
+    CHECK(q[1] == 1);
+    CHECK(q[2] == 1);
+    CHECK(q[3] == 65535);
+    CHECK(q[4] == 65535);
+
+    // Every path but the planted one saturates; it must still win
+    const index_t M = 300, N = 40;
+    std::vector<std::uint16_t> D(std::size_t(M * N), 40000);
+    for (index_t n = 0; n < N; ++n)
+        D[std::size_t(n * M + 100 + n)] = 7;
+    for (Isa isa : available_isas()) {
+        const Hit<double> got = dtw_fixed<NSDTW3>(column_major<const std::uint16_t>(D.data(), M, N), 1.0, isa);
+        CHECK(got.end == 100 + N - 1);
+        CHECK(got.start == 100);
+        CHECK_NEAR(got.dist, 7.0, 0.0);
+    }
+}
+
+TEST_MAIN()
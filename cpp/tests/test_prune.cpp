@@ -0,0 +1,98 @@
+// Lower bounds must never exceed the DP distance, and pruned corpus
+// searches must return exactly the unpruned hits.
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/corpus.hpp"
+#include "qbestd/fused.hpp"
+#include "qbestd/prune.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+template <class Pattern>
+void check_bounds(Metric metric)
+{
+    std::mt19937 gen(17);
+    const index_t dims = 5;
+    for (int trial = 0; trial < 30; ++trial) {
+        const index_t M = 10 + trial * 7, N = 1 + trial % 13;
+        const std::vector<double> R = random_frames(dims, M, gen), Q = random_frames(dims, N, gen);
+        const MatrixView<const double> ref = column_major(R.data(), dims, M), qry = column_major(Q.data(), dims, N);
+        const double dist = dtw_features<Pattern>(ref, qry, metric).dist;
+        const double coarse = dtw_lower_bound<Pattern>(ref, qry, metric);
+        const double fine = dtw_lower_bound<Pattern>(ref, qry, metric, 4);
+        CHECK(coarse <= fine);
+        CHECK(fine <= dist);
+    }
+}
+
+template <class Pattern>
+void check_all_metrics()
+{
+    for (Metric metric : {Metric::SqEuclidean, Metric::InnerProduct, Metric::NormInnerProduct,
+                          Metric::SymmetricKL, Metric::Bhattacharyya})
+        check_bounds<Pattern>(metric);
+}
+
+} // namespace
+
+TEST_CASE("Bounds stay below the DP distance")
+{
+    check_all_metrics<NSDTW3>();
+    check_all_metrics<NSDTW5>();
+    check_all_metrics<GTTS>();
+    check_all_metrics<NewNSDTW>();
+    check_all_metrics<OpenEndDTW>();
+}
+
+TEST_CASE("Pruned corpus search returns the unpruned hits")
+{
+    // Utterances in separate regions of feature space; each query is
+    // drawn near a few of them, so most pairs are far apart
+    std::mt19937 gen(23);
+    const index_t dims = 6;
+    std::vector<std::vector<double>> udata, qdata;
+    for (index_t u = 0; u < 40; ++u) {
+        const double base = 2.0 * double(u % 8);
+        udata.push_back(random_frames(dims, 30 + (u * 11) % 40, gen, base, base + 1.0));
+    }
+    for (index_t q = 0; q < 9; ++q) {
+        const double base = 2.0 * double(q % 8);
+        qdata.push_back(random_frames(dims, 3 + q, gen, base, base + 1.0));
+    }
+    std::vector<MatrixView<const double>> utts, queries;
+    for (const std::vector<double>& x : udata)
+        utts.push_back(column_major(x.data(), dims, index_t(x.size()) / dims));
+    for (const std::vector<double>& x : qdata)
+        queries.push_back(column_major(x.data(), dims, index_t(x.size()) / dims));
+
+    CorpusOptions opt;
+    opt.top_k = 3;
+    opt.chunk_frames = 1000;
+    opt.prune_block = 8;
+    PruneStats stats;
+    const auto pruned = search_corpus<NSDTW3>(queries, utts, Metric::SqEuclidean, opt, &stats);
+    opt.prune = false;
+    PruneStats none;
+    const auto full = search_corpus<NSDTW3>(queries, utts, Metric::SqEuclidean, opt, &none);
+
+    CHECK(stats.pairs == queries.size() * utts.size());
+    CHECK(none.pairs == stats.pairs && none.rate() == 0.0);
+    CHECK(stats.rate() > 0.7);
+    CHECK(stats.searched() + stats.coarse + stats.fine == stats.pairs);
+    CHECK(pruned.size() == full.size());
+    for (std::size_t q = 0; q < full.size() && q < pruned.size(); ++q) {
+        CHECK(pruned[q].size() == full[q].size());
+        for (std::size_t k = 0; k < full[q].size() && k < pruned[q].size(); ++k) {
+            CHECK(pruned[q][k].utterance == full[q][k].utterance);
+            CHECK(pruned[q][k].hit.end == full[q][k].hit.end);
+            CHECK(pruned[q][k].hit.dist == full[q][k].hit.dist);
+        }
+    }
+}
+
+TEST_MAIN()
@@ -0,0 +1,171 @@
+// The rolling-window form must return the same hit as the full matrices.
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/rolling.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+template <class Pattern, class Norm>
+void compare_full(bool row_major)
+{
+    std::mt19937 gen(5);
+    for (int trial = 0; trial < 40; ++trial) {
+        const index_t M = 1 + (trial * 7) % 41, N = 1 + (trial * 3) % 17;
+        const std::vector<double> D = random_levels(M, N, gen, trial % 2 ? 4 : 1000);
+        const MatrixView<const double> view =
+            row_major ? MatrixView<const double>{D.data(), M, N, N, 1}
+                      : column_major<const double>(D.data(), M, N);
+
+        const Hit<double> want = dtw<Pattern, Norm>(view, Isa::Scalar);
+        for (Isa isa : available_isas()) {
+            const Hit<double> got = dtw_rolling<Pattern, Norm>(view, isa);
+            CHECK(got.end == want.end);
+            CHECK(got.start == want.start);
+            CHECK_NEAR(got.dist, want.dist, 0.0);
+        }
+    }
+}
+
+template <class Pattern>
+void compare_all()
+{
+    compare_full<Pattern, Accumulated>(false);
+    compare_full<Pattern, Normalized>(false);
+    compare_full<Pattern, Accumulated>(true);
+}
+
+// Greedy suppression over all end rows of the full matrices, sorted by S.
+template <class Pattern>
+std::vector<Hit<double>> greedy_top(const std::vector<double>& D, index_t M, index_t N, const TopK& top)
+{
+    std::vector<double> S(D.size()), T(D.size()), P(D.size());
+    dtw<Pattern>(D.data(), M, N, M, S.data(), T.data(), P.data(), Isa::Scalar);
+    std::vector<index_t> rows;
+    for (index_t m = Pattern::end == End::Open ? 0 : M - 1; m < M; ++m)
+        rows.push_back(m);
+    const double* s = S.data() + (N - 1) * M;
+    std::stable_sort(rows.begin(), rows.end(), [&](index_t a, index_t b) { return s[a] < s[b]; });
+    std::vector<Hit<double>> hits;
+    for (index_t m : rows) {
+        const Hit<double> h{s[m] / T[(N - 1) * M + m], index_t(P[(N - 1) * M + m]), m};
+        bool keep = hits.size() < top.count;
+        for (const Hit<double>& k : hits) {
+            const index_t common = std::min(h.end, k.end) - std::max(h.start, k.start) + 1;
+            const index_t total = (h.end - h.start + 1) + (k.end - k.start + 1) - common;
+            keep = keep && !(common > 0 && double(common) > top.max_overlap * double(total));
+        }
+        if (keep)
+            hits.push_back(h);
+    }
+    return hits;
+}
+
+template <class Pattern>
+void compare_top(const TopK& top)
+{
+    std::mt19937 gen(8);
+    for (int trial = 0; trial < 20; ++trial) {
+        const index_t M = 30 + trial * 9, N = 2 + trial % 7;
+        const std::vector<double> D = random_levels(M, N, gen, trial % 2 ? 4 : 1000);
+        const MatrixView<const double> view = column_major<const double>(D.data(), M, N);
+        const std::vector<Hit<double>> want = greedy_top<Pattern>(D, M, N, top);
+        const std::vector<Hit<double>> got = dtw_rolling<Pattern>(view, top);
+        CHECK(got.size() == want.size());
+        for (std::size_t k = 0; k < got.size() && k < want.size(); ++k) {
+            CHECK(got[k].end == want[k].end);
+            CHECK(got[k].start == want[k].start);
+            CHECK_NEAR(got[k].dist, want[k].dist, 0.0);
+        }
+        const Hit<double> best = dtw_rolling<Pattern>(view);
+        CHECK(!got.empty() && got[0].end == best.end && got[0].dist == best.dist);
+    }
+}
+
+// Column-major D runs on the packed layout, a row-major copy on the
+// split S, T, P window; both must agree exactly.
+template <class Pattern, class Norm>
+void compare_packed()
+{
+    std::mt19937 gen(9);
+    for (int trial = 0; trial < 20; ++trial) {
+        const index_t M = 50 + trial * 37, N = 1 + trial % 13;
+        const std::vector<double> D = random_levels(M, N, gen, trial % 2 ? 3 : 1000, 0.25);
+        std::vector<double> Dt(D.size());
+        for (index_t m = 0; m < M; ++m)
+            for (index_t n = 0; n < N; ++n)
+                Dt[std::size_t(m * N + n)] = D[std::size_t(n * M + m)];
+        const MatrixView<const double> packed = column_major<const double>(D.data(), M, N);
+        const MatrixView<const double> split{Dt.data(), M, N, N, 1};
+        for (Isa isa : available_isas()) {
+            const std::vector<Hit<double>> want = dtw_rolling<Pattern, Norm>(split, TopK{4, 0.0}, Isa::Scalar);
+            const std::vector<Hit<double>> got = dtw_rolling<Pattern, Norm>(packed, TopK{4, 0.0}, isa);
+            CHECK(got.size() == want.size());
+            for (std::size_t k = 0; k < got.size() && k < want.size(); ++k) {
+                CHECK(got[k].end == want[k].end);
+                CHECK(got[k].start == want[k].start);
+                CHECK_NEAR(got[k].dist, want[k].dist, 0.0);
+            }
+        }
+    }
+}
+
+using Weighted = StepPattern<StepList<Step<0, 1>, Step<1, 1, 2>, Step<3, 1>>>;
+using AnchoredColumns = StepPattern<StepList<Step<1, 1>, Step<2, 1, 2>>, Start::Anchored>;
+
+} // namespace
+
+TEST_CASE("Two-column window: NSDTW, GTTS and anchored DTW")
+{
+    compare_all<NSDTW2>();
+    compare_all<NSDTW3>();
+    compare_all<NSDTW5>();
+    compare_all<GTTS>();
+    compare_all<OpenEndDTW>();
+    compare_all<BasicDTW>();
+    compare_all<SymmetricDTW>();
+}
+
+TEST_CASE("Packed layout matches the split window")
+{
+    compare_packed<NSDTW3, Accumulated>();
+    compare_packed<NSDTW3, Normalized>();
+    compare_packed<NSDTW5, Normalized>();
+    compare_packed<Weighted, Accumulated>();
+    compare_packed<Weighted, Normalized>();
+    compare_packed<AnchoredColumns, Accumulated>();
+    compare_packed<AnchoredColumns, Normalized>();
+}
+
+TEST_CASE("Three-column window: newNSDTW")
+{
+    compare_all<NewNSDTW>();
+}
+
+TEST_CASE("Top-K hits with overlap suppression")
+{
+    compare_top<NSDTW3>(TopK{5, 0.0});
+    compare_top<GTTS>(TopK{3, 0.5});
+    compare_top<NewNSDTW>(TopK{1000, 0.0});
+    compare_top<BasicDTW>(TopK{4, 0.0});
+    CHECK(dtw_rolling<GTTS>(column_major<const double>(std::vector<double>(6, 1.0).data(), 3, 2),
+                            TopK{0, 0.0})
+              .empty());
+}
+
+TEST_CASE("Pointer form and empty input")
+{
+    const std::vector<double> D = {1, 5, 2, 7, /**/ 3, 1, 4, 0};
+    const Hit<double> h = dtw_rolling<NSDTW3>(D.data(), 4, 2, 4);
+    CHECK(h.end == 3);
+    CHECK(h.start == 2);
+    CHECK_NEAR(h.dist, 1.0, 0.0);
+    CHECK_THROWS(dtw_rolling<GTTS>(column_major<const double>(D.data(), 0, 2)));
+}
+
+TEST_MAIN()
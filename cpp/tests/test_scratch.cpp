@@ -0,0 +1,77 @@
+// Once a call has run, repeating it (or running a smaller one) must not
+// allocate scratch memory again, and results must not depend on what an
+// earlier call left in the reused blocks.
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/qbestd.hpp"
+
+using namespace qbestd;
+
+TEST_CASE("Blocks are borrowed and returned")
+{
+    release_scratch();
+    const ScratchStats before = scratch_stats();
+    {
+        Scratch<double> a(100, 1.5);
+        CHECK(a.size() == 100);
+        CHECK(reinterpret_cast<std::uintptr_t>(a.data()) % 64 == 0);
+        CHECK(a[99] == 1.5);
+        Scratch<double> b = std::move(a);
+        CHECK(a.empty());
+        CHECK(b[0] == 1.5);
+    }
+    const ScratchStats after = scratch_stats();
+    CHECK(after.allocations == before.allocations + 1);
+    CHECK(after.held == before.held + 832);  // 800 bytes in whole cache lines
+
+    // The idle block serves any type that fits
+    {
+        Scratch<std::uint16_t> c(300);
+        Scratch<char> none(0);
+        CHECK(none.empty());
+    }
+    CHECK(scratch_stats().allocations == after.allocations);
+
+    release_scratch();
+    CHECK(scratch_stats().held == before.held);
+    CHECK(scratch_stats().bytes == after.bytes);
+}
+
+TEST_CASE("Repeated searches allocate nothing")
+{
+    std::mt19937 gen(71);
+    const index_t dims = 13, M = 400, N = 35;
+    const std::vector<double> R = random_frames(dims, M, gen), Q = random_frames(dims, N, gen);
+    const MatrixView<const double> ref = column_major(R.data(), dims, M), qry = column_major(Q.data(), dims, N);
+    const std::vector<double> D = distance_matrix(ref, qry, Metric::SymmetricKL);
+    const MatrixView<const double> view = column_major(D.data(), M, N);
+
+    auto search = [&](index_t rows) {
+        const MatrixView<const double> part{view.data, rows, N, 1, M};
+        const Hit<double> rolled = dtw_rolling<NSDTW3>(part);
+        const Hit<double> full = dtw<GTTS, Normalized>(part);
+        const Hit<double> fused = dtw_features<NewNSDTW>(column_major(R.data(), dims, rows), qry, Metric::SymmetricKL);
+        const Alignment<double> path = dtw_path<NSDTW5>(part);
+        const std::vector<double> Dp = distance_matrix(column_major(R.data(), dims, rows), qry, Metric::SqEuclidean);
+        return std::vector<double>{rolled.dist, full.dist, fused.dist, path.hit.dist, Dp.back(),
+                                   double(path.path.size())};
+    };
+
+    const std::vector<double> first = search(M);
+    const ScratchStats warm = scratch_stats();
+    CHECK(warm.allocations > 0);
+    for (index_t rows : {M, M / 2, index_t(37), M}) {
+        const std::vector<double> again = search(rows);
+        CHECK(scratch_stats().allocations == warm.allocations);
+        CHECK(scratch_stats().bytes == warm.bytes);
+        if (rows == M)
+            for (std::size_t i = 0; i < first.size(); ++i)
+                CHECK(again[i] == first[i]);
+    }
+}
+
+TEST_MAIN()
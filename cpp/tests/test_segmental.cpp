@@ -0,0 +1,72 @@
+// One-sweep segmental DTW against the Fx_do_SDTW loop: DTW_c_skel_nobt
+// on every slice D(k : k+N2+R-1, :) plus an Inf band mask.
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/dtw.hpp"
+#include "qbestd/segmental.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+Segments<double> per_segment_loop(const std::vector<double>& D, index_t N1, index_t N2, index_t R)
+{
+    const index_t L = N2 + R, count = N1 - N2 - R;
+    Segments<double> out{std::vector<double>(std::size_t(count)), std::vector<index_t>(std::size_t(count))};
+    std::vector<double> slice(std::size_t(L * N2));
+    for (index_t k = 0; k < count; ++k) {
+        for (index_t n = 0; n < N2; ++n)
+            for (index_t m = 0; m < L; ++m)
+                slice[n * L + m] = D[n * N1 + k + m]
+                    + (m - n > R || n - m > R ? std::numeric_limits<double>::infinity() : 0.0);
+        const Hit<double> h = dtw<OpenEndDTW>(column_major<const double>(slice.data(), L, N2), Isa::Scalar);
+        out.dist[k] = h.dist;
+        out.end[k] = h.end;
+    }
+    return out;
+}
+
+} // namespace
+
+TEST_CASE("Segmental sweep reproduces the per-segment loop")
+{
+    std::mt19937 gen(3);
+    for (index_t R : {0, 1, 3, 12}) {
+        for (int trial = 0; trial < 6; ++trial) {
+            const index_t N2 = 2 + trial * 3, N1 = N2 + R + 1 + trial * 11;
+            const std::vector<double> D = random_levels(N1, N2, gen, trial % 2 ? 3 : 1000);
+            const Segments<double> want = per_segment_loop(D, N1, N2, R);
+            for (Isa isa : available_isas()) {
+                const Segments<double> got =
+                    segmental_dtw(column_major<const double>(D.data(), N1, N2), R, isa);
+                CHECK(got.dist == want.dist);
+                CHECK(got.end == want.end);
+            }
+        }
+    }
+}
+
+TEST_CASE("Row-major D and segment bounds")
+{
+    const index_t N1 = 9, N2 = 3, R = 1;
+    std::vector<double> D(std::size_t(N1 * N2)), Drm(D.size());
+    for (index_t i = 0; i < N1 * N2; ++i)
+        D[i] = double((i * 7) % 5);
+    for (index_t n = 0; n < N2; ++n)
+        for (index_t m = 0; m < N1; ++m)
+            Drm[m * N2 + n] = D[n * N1 + m];
+    const Segments<double> a = segmental_dtw(column_major<const double>(D.data(), N1, N2), R);
+    const Segments<double> b = segmental_dtw(MatrixView<const double>{Drm.data(), N1, N2, N2, 1}, R);
+    CHECK(a.dist == b.dist && a.end == b.end);
+
+    std::vector<double> dist(8);
+    std::vector<index_t> end(8);
+    CHECK_THROWS(segmental_dtw(column_major<const double>(D.data(), N1, N2), R, 7, dist.data(), end.data()));
+    CHECK_THROWS(segmental_dtw(column_major<const double>(D.data(), 4, N2), R));
+}
+
+TEST_MAIN()
@@ -0,0 +1,86 @@
+// Every instruction set must reproduce the scalar recurrence bit for bit.
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/dtw.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+struct Grid {
+    std::vector<double> S, T, P;
+    explicit Grid(std::size_t cells) : S(cells), T(cells), P(cells) {}
+};
+
+template <class Pattern, class Norm>
+void compare_isas(bool row_major)
+{
+    std::mt19937 gen(11);
+    for (int trial = 0; trial < 40; ++trial) {
+        const index_t M = 6 + (trial * 7) % 53, N = 3 + (trial * 5) % 29;
+        const std::size_t cells = std::size_t(M * N);
+        const std::vector<double> D = random_levels(M, N, gen, trial % 2 ? 5 : 1000, 0.25);
+        const MatrixView<const double> view =
+            row_major ? MatrixView<const double>{D.data(), M, N, N, 1}
+                      : column_major<const double>(D.data(), M, N);
+
+        Grid ref(cells);
+        const Hit<double> want =
+            dtw<Pattern, Norm>(view, column_major(ref.S.data(), M, N), column_major(ref.T.data(), M, N),
+                               column_major(ref.P.data(), M, N), Isa::Scalar);
+        for (Isa isa : available_isas()) {
+            Grid got(cells);
+            const Hit<double> h = dtw<Pattern, Norm>(view, column_major(got.S.data(), M, N),
+                                                     column_major(got.T.data(), M, N),
+                                                     column_major(got.P.data(), M, N), isa);
+            CHECK(got.S == ref.S);
+            CHECK(got.T == ref.T);
+            CHECK(got.P == ref.P);
+            CHECK(h.end == want.end && h.start == want.start);
+            CHECK_NEAR(h.dist, want.dist, 0.0);
+        }
+    }
+}
+
+template <class Pattern>
+void compare_all()
+{
+    compare_isas<Pattern, Accumulated>(false);
+    compare_isas<Pattern, Normalized>(false);
+    compare_isas<Pattern, Accumulated>(true);
+}
+
+} // namespace
+
+TEST_CASE("Column kernel: NSDTW family")
+{
+    compare_all<NSDTW2>();
+    compare_all<NSDTW3>();
+    compare_all<NSDTW4>();
+    compare_all<NSDTW5>();
+    compare_all<NSDTWK<7>>();
+}
+
+TEST_CASE("Wavefront kernel: GTTS, newNSDTW and anchored DTW")
+{
+    compare_all<GTTS>();
+    compare_all<NewNSDTW>();
+    compare_all<OpenEndDTW>();
+    compare_all<BasicDTW>();
+    compare_all<SymmetricDTW>();
+}
+
+TEST_CASE("ISA selection is clamped to the CPU")
+{
+    const Isa before = active_isa();
+    set_isa(Isa::Avx512);
+    CHECK(active_isa() <= detect_isa());
+    set_isa(Isa::Scalar);
+    CHECK(active_isa() == Isa::Scalar);
+    set_isa(before);
+}
+
+TEST_MAIN()
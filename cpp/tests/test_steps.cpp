@@ -0,0 +1,102 @@
+// Compile-time step lists against a plain runtime loop over the same steps.
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/dtw.hpp"
+
+using namespace qbestd;
+
+static_assert(NSDTW5::steps::size == 5);
+static_assert(NSDTW5::steps::max_dm == 4 && NSDTW5::steps::max_dn == 1);
+static_assert(std::is_same_v<NSDTW2::steps, StepList<Step<1, 1>, Step<0, 1>>>);
+static_assert(GTTS::first_row == 1 && NSDTWK<7>::first_row == 6);
+
+namespace {
+
+struct RuntimeStep {
+    index_t dm, dn;
+    int weight;
+};
+
+// Free start, open end, ties to the earliest step.
+Hit<double> runtime_dtw(const std::vector<double>& D, index_t M, index_t N,
+                        const std::vector<RuntimeStep>& steps, index_t first_row)
+{
+    std::vector<double> S(D.size()), T(D.size()), P(D.size());
+    for (index_t m = 0; m < M; ++m) {
+        S[m] = D[m];
+        T[m] = 1;
+        P[m] = double(m);
+    }
+    for (index_t n = 1; n < N; ++n)
+        for (index_t m = 0; m < M; ++m) {
+            const index_t c = m + M * n;
+            if (m < first_row) {
+                S[c] = S[c - M] + D[c];
+                T[c] = T[c - M] + 1;
+                P[c] = P[c - M];
+                continue;
+            }
+            bool first = true;
+            for (const RuntimeStep& s : steps) {
+                const index_t p = (m - s.dm) + M * (n - s.dn);
+                const double cost = S[p] + s.weight * D[c];
+                if (first || cost < S[c]) {
+                    S[c] = cost;
+                    T[c] = T[p] + s.weight;
+                    P[c] = P[p];
+                    first = false;
+                }
+            }
+        }
+    index_t end = 0;
+    for (index_t m = 1; m < M; ++m)
+        if (S[m + M * (N - 1)] < S[end + M * (N - 1)])
+            end = m;
+    const index_t e = end + M * (N - 1);
+    return {S[e] / T[e], index_t(P[e]), end};
+}
+
+template <class Pattern>
+void compare(const std::vector<RuntimeStep>& steps, index_t first_row)
+{
+    std::mt19937 gen(7);
+    for (int trial = 0; trial < 50; ++trial) {
+        const index_t M = 8 + trial, N = 3 + trial % 9;
+        const std::vector<double> D = random_levels(M, N, gen, 7); // coarse levels force ties
+        const Hit<double> want = runtime_dtw(D, M, N, steps, first_row);
+        const Hit<double> got = dtw<Pattern>(column_major(D.data(), M, N));
+        CHECK(got.end == want.end);
+        CHECK(got.start == want.start);
+        CHECK_NEAR(got.dist, want.dist, 0.0);
+    }
+}
+
+} // namespace
+
+TEST_CASE("NSDTWK generates the longest-jump-first lists")
+{
+    compare<NSDTW4>({{3, 1, 1}, {2, 1, 1}, {1, 1, 1}, {0, 1, 1}}, 3);
+    compare<NSDTWK<6>>({{5, 1, 1}, {4, 1, 1}, {3, 1, 1}, {2, 1, 1}, {1, 1, 1}, {0, 1, 1}}, 5);
+}
+
+TEST_CASE("Arbitrary weighted step lists")
+{
+    using Asym = StepPattern<StepList<Step<0, 1, 2>, Step<1, 1>, Step<3, 1, 3>>>;
+    compare<Asym>({{0, 1, 2}, {1, 1, 1}, {3, 1, 3}}, 3);
+}
+
+TEST_CASE("Symmetric weights normalize by the summed weights")
+{
+    const std::vector<double> D = {1, 5, /**/ 5, 1};
+    std::vector<double> S(4), T(4), P(4);
+    const Hit<double> h = dtw<SymmetricDTW>(D.data(), 2, 2, 2, S.data(), T.data(), P.data());
+    CHECK_NEAR(S[3], 3.0, 0.0);
+    CHECK_NEAR(T[3], 3.0, 0.0);
+    CHECK_NEAR(h.dist, 1.0, 0.0);
+}
+
+TEST_MAIN()
@@ -0,0 +1,116 @@
+// The streaming session must follow dtw() on the whole reference row by
+// row, whatever the chunking of the frames.
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/dtw.hpp"
+#include "qbestd/stream.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+// Same detection rule applied to the last column of the full matrices.
+std::vector<Hit<double>> offline(const std::vector<double>& S, const std::vector<double>& T,
+                                 const std::vector<double>& P, index_t M, index_t N, double threshold)
+{
+    std::vector<Hit<double>> out;
+    Hit<double> best;
+    bool pending = false;
+    for (index_t m = 0; m < M; ++m) {
+        const index_t at = (N - 1) * M + m;
+        const Hit<double> h{S[at] / T[at], index_t(P[at]), m};
+        if (!(h.dist < threshold) || (pending && h.start > best.end)) {
+            if (pending)
+                out.push_back(best);
+            pending = false;
+        }
+        if (h.dist < threshold && (!pending || h.dist < best.dist))
+            best = h;
+        pending = pending || h.dist < threshold;
+    }
+    if (pending)
+        out.push_back(best);
+    return out;
+}
+
+template <class Pattern, class Norm>
+void compare_offline(Metric metric)
+{
+    std::mt19937 gen(13);
+    const index_t dims = 4;
+    for (int trial = 0; trial < 8; ++trial) {
+        const index_t M = 60 + trial * 17, N = 1 + trial * 3;
+        const std::vector<double> R = random_frames(dims, M, gen), Q = random_frames(dims, N, gen);
+        const MatrixView<const double> ref = column_major(R.data(), dims, M), qry = column_major(Q.data(), dims, N);
+
+        const FrameDistance<double> dist(ref, qry, metric);
+        for (Isa isa : available_isas()) {
+            // Distances are reduced per instruction set, so D is too
+            std::vector<double> D(std::size_t(M * N)), S(D.size()), T(D.size()), P(D.size());
+            for (index_t n = 0; n < N; ++n)
+                dist.column(n, D.data() + n * M, isa);
+            dtw<Pattern, Norm>(D.data(), M, N, M, S.data(), T.data(), P.data(), Isa::Scalar);
+
+            // Threshold near the median end point, so there are several runs
+            std::vector<double> ends;
+            for (index_t m = 0; m < M; ++m)
+                ends.push_back(S[(N - 1) * M + m] / T[(N - 1) * M + m]);
+            std::nth_element(ends.begin(), ends.begin() + M / 2, ends.end());
+            const double threshold = ends[std::size_t(M / 2)];
+            const std::vector<Hit<double>> want = offline(S, T, P, M, N, threshold);
+
+            StreamSearch<Pattern, Norm> stream(qry, metric, threshold, isa);
+            std::vector<Hit<double>> got;
+            bool rows_match = true;
+            for (index_t m = 0, chunk = 1; m < M; m += chunk, chunk = chunk % 7 + 1) {
+                const index_t count = std::min(chunk, M - m);
+                stream.push(column_major(R.data() + m * dims, dims, count), got);
+                const index_t e = (N - 1) * M + m + count - 1;
+                const Hit<double> last = stream.last();
+                rows_match = rows_match && last.end == m + count - 1 && last.dist == S[e] / T[e]
+                    && last.start == index_t(P[e]);
+            }
+            stream.flush(got);
+            CHECK(rows_match);
+            CHECK(stream.frames() == M);
+            CHECK(!want.empty());
+            CHECK(got.size() == want.size());
+            for (std::size_t k = 0; k < got.size() && k < want.size(); ++k) {
+                CHECK(got[k].end == want[k].end);
+                CHECK(got[k].start == want[k].start);
+                CHECK_NEAR(got[k].dist, want[k].dist, 0.0);
+            }
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("Online kernels follow the offline recurrence")
+{
+    compare_offline<NSDTW3, Normalized>(Metric::SqEuclidean);
+    compare_offline<GTTS, Normalized>(Metric::NormInnerProduct);
+    compare_offline<NewNSDTW, Normalized>(Metric::SymmetricKL);
+}
+
+TEST_CASE("Accumulated and anchored patterns stream too")
+{
+    compare_offline<NSDTW5, Accumulated>(Metric::InnerProduct);
+    compare_offline<GTTS, Accumulated>(Metric::Bhattacharyya);
+    compare_offline<OpenEndDTW, Accumulated>(Metric::SqEuclidean);
+}
+
+TEST_CASE("Stream input checks")
+{
+    const std::vector<double> Q(8, 0.5), F(9, 0.5);
+    StreamSearch<GTTS> stream(column_major(Q.data(), 4, 2), Metric::SqEuclidean, 1.0);
+    std::vector<Hit<double>> out;
+    CHECK_THROWS(stream.push(column_major(F.data(), 3, 3), out));
+    CHECK_THROWS((StreamSearch<GTTS>(column_major(Q.data(), 4, 0), Metric::SqEuclidean, 1.0)));
+}
+
+TEST_MAIN()
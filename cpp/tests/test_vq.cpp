@@ -0,0 +1,145 @@
+// The codebook must find well separated clusters, codes must name the
+// nearest center, and the search on codes must be the search on the
+// reference rebuilt from its centers.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "check.hpp"
+#include "fixtures.hpp"
+#include "qbestd/fused.hpp"
+#include "qbestd/vq.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+// count frames around the given means (dims values each), in turn.
+std::vector<double> blobs(const std::vector<std::vector<double>>& means, index_t count, double spread,
+                          std::mt19937& gen)
+{
+    std::normal_distribution<double> noise(0.0, spread);
+    const std::size_t dims = means[0].size();
+    std::vector<double> X(dims * std::size_t(count));
+    for (index_t f = 0; f < count; ++f)
+        for (std::size_t d = 0; d < dims; ++d)
+            X[std::size_t(f) * dims + d] = means[std::size_t(f) % means.size()][d] + noise(gen);
+    return X;
+}
+
+double sq_distance(const double* a, const double* b, index_t dims)
+{
+    double s = 0;
+    for (index_t d = 0; d < dims; ++d)
+        s += (a[d] - b[d]) * (a[d] - b[d]);
+    return s;
+}
+
+std::vector<double> decoded(const Codebook<double>& cb, const std::vector<std::uint8_t>& codes)
+{
+    std::vector<double> X;
+    for (std::uint8_t c : codes)
+        X.insert(X.end(), cb.centers.begin() + c * cb.dims, cb.centers.begin() + (c + 1) * cb.dims);
+    return X;
+}
+
+template <class Pattern>
+void compare_decoded(Metric metric)
+{
+    std::mt19937 gen(93);
+    const index_t dims = 24, M = 700, N = 31;
+    const std::vector<double> R = random_frames(dims, M, gen, 0.05), Q = random_frames(dims, N, gen, 0.05);
+    const MatrixView<const double> ref = column_major<const double>(R.data(), dims, M);
+    const MatrixView<const double> qry = column_major<const double>(Q.data(), dims, N);
+    const Codebook<double> cb = train_codebook(ref, metric, CodebookOptions{37});
+    const std::vector<std::uint8_t> codes = encode(cb, ref, metric);
+    const std::vector<double> Rq = decoded(cb, codes);
+    const FrameDistance<double> full(column_major<const double>(Rq.data(), dims, M), qry, metric);
+
+    for (Isa isa : available_isas()) {
+        const CodeDistance<double> dist(cb, codes, qry, metric, isa);
+        CHECK(dist.rows() == M);
+        CHECK(dist.cols() == N);
+        std::vector<double> a(static_cast<std::size_t>(M)), b(a.size());
+        for (index_t n = 0; n < N; ++n) {
+            dist.column(n, a.data(), isa);
+            full.column(n, b.data(), isa);
+            CHECK(a == b);
+        }
+        const Hit<double> got = dtw_features<Pattern>(dist, isa), want = dtw_features<Pattern>(full, isa);
+        CHECK(got.end == want.end);
+        CHECK(got.start == want.start);
+        CHECK(got.dist == want.dist);
+        const std::vector<Hit<double>> top = dtw_features<Pattern, Normalized>(dist, TopK{3, 0.0}, isa);
+        const std::vector<Hit<double>> top_want = dtw_features<Pattern, Normalized>(full, TopK{3, 0.0}, isa);
+        CHECK(top.size() == top_want.size());
+        for (std::size_t k = 0; k < top.size() && k < top_want.size(); ++k) {
+            CHECK(top[k].end == top_want[k].end);
+            CHECK(top[k].dist == top_want[k].dist);
+        }
+    }
+}
+
+} // namespace
+
+TEST_CASE("Splitting k-means finds separated clusters")
+{
+    std::mt19937 gen(91);
+    const std::vector<std::vector<double>> means = {
+        {0, 0, 0}, {10, 0, 0}, {0, 10, 0}, {0, 0, 10}, {10, 10, 10}, {-10, 5, 0}};
+    const index_t dims = 3, F = 1200;
+    const std::vector<double> X = blobs(means, F, 0.5, gen);
+    const MatrixView<const double> frames = column_major<const double>(X.data(), dims, F);
+
+    // Six is not a power of two: the last split only divides the worst centers
+    const Codebook<double> cb = train_codebook(frames, Metric::SqEuclidean, CodebookOptions{6});
+    CHECK(cb.size == 6);
+    CHECK(cb.dims == dims);
+    for (const std::vector<double>& mean : means) {
+        double nearest = INFINITY;
+        for (index_t k = 0; k < cb.size; ++k)
+            nearest = std::min(nearest, sq_distance(mean.data(), cb.centers.data() + k * dims, dims));
+        CHECK(nearest < 0.05);
+    }
+
+    // Codes name the nearest center, and one byte replaces three doubles
+    const std::vector<std::uint8_t> codes = encode(cb, frames, Metric::SqEuclidean);
+    CHECK(codes.size() == std::size_t(F));
+    for (index_t f = 0; f < F; ++f) {
+        const double* x = X.data() + f * dims;
+        const double mine = sq_distance(x, cb.centers.data() + codes[std::size_t(f)] * dims, dims);
+        for (index_t k = 0; k < cb.size; ++k)
+            CHECK(mine <= sq_distance(x, cb.centers.data() + k * dims, dims) + 1e-9);
+    }
+    const std::vector<std::uint16_t> wide = encode<std::uint16_t>(cb, frames, Metric::SqEuclidean);
+    CHECK(std::equal(wide.begin(), wide.end(), codes.begin()));
+
+    // More centers than distinct frames: empty clusters restart elsewhere
+    const std::vector<double> few = {1, 1, 1, 1, 1, 1, 5, 5, 5, 5, 5, 5};
+    const Codebook<double> dup = train_codebook(column_major<const double>(few.data(), 3, 4), Metric::SqEuclidean,
+                                                CodebookOptions{3});
+    CHECK(dup.size == 3);
+
+    CHECK_THROWS(train_codebook(frames, Metric::SqEuclidean, CodebookOptions{F + 1}));
+    CHECK_THROWS(encode(train_codebook(frames, Metric::SqEuclidean, CodebookOptions{300}), frames,
+                        Metric::SqEuclidean));
+}
+
+TEST_CASE("Search on codes equals search on the decoded reference")
+{
+    compare_decoded<NSDTW3>(Metric::SqEuclidean);
+    compare_decoded<GTTS>(Metric::SymmetricKL);
+    compare_decoded<NewNSDTW>(Metric::Bhattacharyya);
+    compare_decoded<NSDTW3>(Metric::NormInnerProduct);
+
+    const std::vector<double> q(6, 0.5);
+    const Codebook<double> cb{3, 2, {0.1, 0.2, 0.3, 0.4, 0.5, 0.6}};
+    const std::vector<std::uint8_t> bad = {0, 1, 2};
+    CHECK_THROWS(CodeDistance<double>(cb, bad, column_major<const double>(q.data(), 3, 2), Metric::SqEuclidean));
+    CHECK_THROWS(CodeDistance<double>(cb, bad.data(), 0, column_major<const double>(q.data(), 3, 2),
+                                      Metric::SqEuclidean));
+}
+
+TEST_MAIN()
@@ -0,0 +1,92 @@
+// Spoken-term detection from audio in one process: MFCCs of the query
+// WAV, then the reference WAV streamed second by second through the
+// resampler, MfccStream and the GTTS online recurrence, printing every
+// detection as it completes.
+//
+//   qbestd_search QUERY.wav REFERENCE.wav [--threshold=X] [--metric=s]
+//
+// Without --threshold every end point qualifies, so the best alignment
+// of each stretch of reference it cannot overlap is printed; the lowest
+// dist is the detection. Each line is "start end dist" in seconds (of
+// the hop grid) followed by the frame range.
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "qbestd/qbestd.hpp"
+
+using namespace qbestd;
+
+namespace {
+
+void print(const std::vector<Hit<double>>& hits, const MfccOptions& opt)
+{
+    const double seconds = double(opt.hop) / opt.sample_rate;
+    for (const Hit<double>& h : hits)
+        std::printf("%.3f %.3f %.6g frames %td-%td\n", double(h.start) * seconds, double(h.end + 1) * seconds,
+                    h.dist, h.start, h.end);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<std::string> files;
+    double threshold = std::numeric_limits<double>::infinity();
+    std::string metric = "s";
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--threshold=", 12) == 0)
+            threshold = std::stod(argv[i] + 12);
+        else if (std::strncmp(argv[i], "--metric=", 9) == 0)
+            metric = argv[i] + 9;
+        else if (argv[i][0] == '-') {
+            std::fprintf(stderr, "unknown option %s\n", argv[i]);
+            return 2;
+        } else
+            files.emplace_back(argv[i]);
+    }
+    if (files.size() != 2) {
+        std::fprintf(stderr, "usage: %s QUERY.wav REFERENCE.wav [--threshold=X] [--metric=s|i|in|k|b]\n", argv[0]);
+        return 2;
+    }
+
+    try {
+        const MfccOptions opt;
+        const Features<double> query = mfcc<double>(files[0], opt);
+        StreamSearch<GTTS, Normalized> search(query.view(), parse_metric(metric), threshold);
+
+        const Audio reference = read_wav(files[1]);
+        Resampler resampler(reference.sample_rate, opt.sample_rate);
+        MfccStream<double> frames(opt);
+        std::vector<float> samples;
+        std::vector<double> chunk;
+        std::vector<Hit<double>> hits;
+        auto advance = [&] {
+            search.push(column_major<const double>(chunk.data(), opt.n_mfcc, index_t(chunk.size()) / opt.n_mfcc), hits);
+            print(hits, opt);
+            chunk.clear();
+            hits.clear();
+        };
+        const std::size_t second = std::size_t(reference.sample_rate);
+        for (std::size_t at = 0; at < reference.samples.size(); at += second) {
+            resampler.push(reference.samples.data() + at, std::min(second, reference.samples.size() - at), samples);
+            frames.push(samples.data(), samples.size(), chunk);
+            samples.clear();
+            advance();
+        }
+        resampler.flush(samples);
+        frames.push(samples.data(), samples.size(), chunk);
+        frames.flush(chunk);
+        advance();
+        search.flush(hits);
+        print(hits, opt);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "qbestd_search: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,59 @@
+/*********************************************************************
+ * Fused local distance + DTW: D is computed one query frame at a time
+ * inside the recurrence instead of being built in MATLAB first.
+ * Type_localdist is one of 's', 'i', 'in', 'k', 'b' as in Fx_do_SDTW;
+ * kernel names the MEX kernel whose recurrence is used (default
+ * 'NSDTW_c_skel'). With K, up to K detections are returned best first,
+ * dropping any whose rows overlap a better one by more than
+ * max_overlap (intersection over union, default 0).
+ ********************************************************************/
+// [dist, ep, sp] = DTW_c_features(refcoef, qrycoef, Type_localdist, kernel, K, max_overlap)
+// with 1-based ep and sp rows of the reference; 1 x K vectors when K is given.
+#include "qbestd/fused.hpp"
+#include "qbestd_mex.hpp"
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    if (nrhs < 3 || !mxIsDouble(prhs[0]) || !mxIsDouble(prhs[1]) || mxIsComplex(prhs[0])
+        || mxIsComplex(prhs[1]) || !mxIsChar(prhs[2]) || (nrhs > 3 && !mxIsChar(prhs[3]))
+        || (nrhs > 4 && !mxIsDouble(prhs[4])) || (nrhs > 5 && !mxIsDouble(prhs[5])))
+        mexErrMsgIdAndTxt("qbestd:input",
+                          "Expected refcoef, qrycoef, Type_localdist and optionally a kernel name, K and max_overlap.");
+    const std::string type = qbestd_mex::get_string(prhs[2]);
+    const std::string kernel = nrhs > 3 ? qbestd_mex::get_string(prhs[3]) : "NSDTW_c_skel";
+    std::string error;
+    try {
+        const qbestd::FrameDistance<double> dist(qbestd_mex::features(prhs[0]),
+                                                 qbestd_mex::features(prhs[1]),
+                                                 qbestd::parse_metric(type));
+        if (nrhs > 4) {
+            const qbestd::TopK top{std::size_t(std::max(mxGetScalar(prhs[4]), 0.0)),
+                                   nrhs > 5 ? mxGetScalar(prhs[5]) : 0.0};
+            const std::vector<qbestd::Hit<double>> hits = qbestd_mex::with_kernel(kernel, [&](auto k) {
+                using K = decltype(k);
+                return qbestd::dtw_features<typename K::Pattern, typename K::Norm>(dist, top);
+            });
+            const mwSize count = hits.size();
+            for (int i = 0; i < std::max(nlhs, 1) && i < 3; ++i) {
+                plhs[i] = mxCreateDoubleMatrix(1, count, mxREAL);
+                double* out = mxGetPr(plhs[i]);
+                for (mwSize h = 0; h < count; ++h)
+                    out[h] = i == 0 ? hits[h].dist : double((i == 1 ? hits[h].end : hits[h].start) + 1);
+            }
+        } else {
+            const qbestd::Hit<double> hit = qbestd_mex::with_kernel(kernel, [&](auto k) {
+                using K = decltype(k);
+                return qbestd::dtw_features<typename K::Pattern, typename K::Norm>(dist);
+            });
+            qbestd_mex::createMatlabScalar(plhs[0]) = hit.dist;
+            if (nlhs > 1)
+                qbestd_mex::createMatlabScalar(plhs[1]) = double(hit.end + 1);
+            if (nlhs > 2)
+                qbestd_mex::createMatlabScalar(plhs[2]) = double(hit.start + 1);
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    if (!error.empty())
+        mexErrMsgIdAndTxt("qbestd:dtw", "%s", error.c_str());
+}
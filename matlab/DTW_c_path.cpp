@@ -0,0 +1,47 @@
+/*********************************************************************
+ * Best hit of a kernel together with its warping path, from a 2-bit
+ * (3-bit for NSDTW_c_skel_5 and newNSDTW_c_skel) traceback instead of
+ * the S/T/P matrices. kernel names the MEX kernel whose recurrence is
+ * used (default 'NSDTW_c_skel').
+ ********************************************************************/
+// [dist, ep, sp, path] = DTW_c_path(D, kernel) with 1-based ep and sp rows;
+// path is L x 2, one [reference_row, query_column] pair (1-based) per step
+// from (sp, 1) to (ep, N).
+#include "qbestd/path.hpp"
+#include "qbestd_mex.hpp"
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    qbestd_mex::check_input(nrhs, prhs);
+    if (nrhs > 1 && !mxIsChar(prhs[1]))
+        mexErrMsgIdAndTxt("qbestd:input", "Expected D and optionally a kernel name.");
+    const std::string kernel = nrhs > 1 ? qbestd_mex::get_string(prhs[1]) : "NSDTW_c_skel";
+    const mwSize M = mxGetM(prhs[0]), N = mxGetN(prhs[0]);
+    std::string error;
+    try {
+        const qbestd::MatrixView<const double> D =
+            qbestd::column_major<const double>(mxGetPr(prhs[0]), qbestd::index_t(M), qbestd::index_t(N));
+        const qbestd::Alignment<double> a = qbestd_mex::with_kernel(kernel, [&](auto k) {
+            using K = decltype(k);
+            return qbestd::dtw_path<typename K::Pattern, typename K::Norm>(D);
+        });
+        qbestd_mex::createMatlabScalar(plhs[0]) = a.hit.dist;
+        if (nlhs > 1)
+            qbestd_mex::createMatlabScalar(plhs[1]) = double(a.hit.end + 1);
+        if (nlhs > 2)
+            qbestd_mex::createMatlabScalar(plhs[2]) = double(a.hit.start + 1);
+        if (nlhs > 3) {
+            const mwSize L = a.path.size();
+            plhs[3] = mxCreateDoubleMatrix(L, 2, mxREAL);
+            double* out = mxGetPr(plhs[3]);
+            for (mwSize i = 0; i < L; ++i) {
+                out[i] = double(a.path[i].ref + 1);
+                out[L + i] = double(a.path[i].qry + 1);
+            }
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    if (!error.empty())
+        mexErrMsgIdAndTxt("qbestd:dtw", "%s", error.c_str());
+}
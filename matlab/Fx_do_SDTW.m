@@ -31,14 +31,8 @@ function [dist, startpos,endpos,DistMtrx]= Fx_do_SDTW(refcoef,qrycoef,Type_local
 %% Local distance
 D=0;
 switch Type_localdist
-    case('i'); % If "Inner Product" is used as local distance computation metric
-        D=-log(inDistance(refcoef,qrycoef)); % Inner product based distance
-    case('in'); % If "Inner Product" is used as local distance computation metric
-        refcoef=refcoef./repmat(sum(refcoef.*refcoef),size(refcoef,1),1);
-        qrycoef=qrycoef./repmat(sum(qrycoef.*qrycoef),size(qrycoef,1),1);
-        D=-log(inDistance(refcoef,qrycoef)); % Inner product based distance
-    case('s'); % If "Euclidean" is used as local distance computation metric
-        D=sqDistance(refcoef,qrycoef);       % Euclidean distance
+    case {'i','in','s'} % Inner product (-log), scaled inner product, Euclidean
+        D=local_distance_c(refcoef,qrycoef,Type_localdist); % Blocked C++ kernel
     case('k'); % If "KL distance" (symmetric version) as a local distance
         %         D=slmetric_pw(refcoef,qrycoef,'kldiv')+slmetric_pw(qrycoef,refcoef,'kldiv')';
         D = KL_symdistance(refcoef,qrycoef);
@@ -52,9 +46,7 @@ end
 %% Preallocation
 [N1,N2]=size(D);                     % Num ref X Num query
 R=round(N2*Warping_adjustment/100);
-Mask=masking_distMtrx_segDTW(N2,R);
 DistMtrx=zeros(1,max(1,N1-N2-R));   % Preallocate to store the dtw distances
-ep=zeros(1,max(1,N1-N2-R));   % Preallocate to store the end pos
 
 
 %% Compute SDTW for all possible segments
@@ -64,12 +56,9 @@ if length(DistMtrx)==1
     dist=DTW_c_basic_skel_nobt(D);
     DistMtrx=dist;
 else
-    for k1=1:1:max(N1-N2-R,1)     % Run FOR loop for every segments to do segmental DTW
-        SF=k1;                  % Starting frame of the segmental DTW
-        EF=min(k1+N2+R-1,size(D,1));    % Ending frame of the segmental DTW
-        Dtemp=D(SF:EF,:);  % Temporary distance matrix formed by local distance computation
-        [DistMtrx(1,k1),ep(1,k1)]=DTW_c_skel_nobt(Dtemp+Mask);  % Perform basic skeleton operation on 1 segment
-    end
+    % All segments D(k1:k1+N2+R-1,:) in one sweep; the warping band |m-n|<=R
+    % is applied inside the recurrence instead of adding Mask
+    [DistMtrx,ep]=SDTW_c_skel(D,R);
     % Optimum index
     [dist,optind]=min(DistMtrx);   % Get the optimum index of segmental DTW
     
@@ -0,0 +1,40 @@
+/*********************************************************************
+ * Segmental DTW of Fx_do_SDTW in one sweep: every segment
+ * D(k : k+N2+R-1, :) is aligned with the DTW_c_skel_nobt recurrence
+ * inside the warping band |m - n| <= R, which replaces the added Mask.
+ ********************************************************************/
+// [DistMtrx, ep] = SDTW_c_skel(D, R) for the N1-N2-R segments; ep is the
+// 0-based end row within each segment, as returned by DTW_c_skel_nobt.
+#include "qbestd/segmental.hpp"
+#include "qbestd_mex.hpp"
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    qbestd_mex::check_input(nrhs, prhs);
+    if (nrhs < 2 || !mxIsDouble(prhs[1]) || mxGetNumberOfElements(prhs[1]) != 1)
+        mexErrMsgIdAndTxt("qbestd:input", "Expected the warping window R as a scalar.");
+    const mwSize N1 = mxGetM(prhs[0]), N2 = mxGetN(prhs[0]);
+    const qbestd::index_t R = qbestd::index_t(mxGetScalar(prhs[1]));
+    const qbestd::index_t count = qbestd::index_t(N1) - qbestd::index_t(N2) - R;
+    if (count < 1)
+        mexErrMsgIdAndTxt("qbestd:input", "D has no room for a segment of N2+R rows.");
+    std::string error;
+    {
+        std::vector<qbestd::index_t> end(count);
+        plhs[0] = mxCreateDoubleMatrix(1, mwSize(count), mxREAL);
+        try {
+            qbestd::segmental_dtw(qbestd::column_major<const double>(mxGetPr(prhs[0]), N1, N2), R,
+                                  count, mxGetPr(plhs[0]), end.data());
+            if (nlhs > 1) {
+                plhs[1] = mxCreateDoubleMatrix(1, mwSize(count), mxREAL);
+                double* ep = mxGetPr(plhs[1]);
+                for (qbestd::index_t k = 0; k < count; ++k)
+                    ep[k] = double(end[k]);
+            }
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+    }
+    if (!error.empty())
+        mexErrMsgIdAndTxt("qbestd:dtw", "%s", error.c_str());
+}
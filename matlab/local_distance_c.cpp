@@ -0,0 +1,29 @@
+/*********************************************************************
+ * Local distance matrix of Fx_do_SDTW as a blocked matrix product with
+ * the norm terms and -log applied in the same pass (no BLAS needed).
+ * Type_localdist is one of 's', 'i', 'in', 'k', 'b'.
+ ********************************************************************/
+// D = local_distance_c(refcoef, qrycoef, Type_localdist), D is N1 x N2
+#include "qbestd/distance_matrix.hpp"
+#include "qbestd_mex.hpp"
+
+void mexFunction(int /*nlhs*/, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    if (nrhs < 3 || !mxIsDouble(prhs[0]) || !mxIsDouble(prhs[1]) || mxIsComplex(prhs[0])
+        || mxIsComplex(prhs[1]) || !mxIsChar(prhs[2]))
+        mexErrMsgIdAndTxt("qbestd:input", "Expected refcoef, qrycoef and Type_localdist.");
+    const std::string type = qbestd_mex::get_string(prhs[2]);
+    std::string error;
+    try {
+        const qbestd::MatrixView<const double> ref = qbestd_mex::features(prhs[0]);
+        const qbestd::MatrixView<const double> qry = qbestd_mex::features(prhs[1]);
+        const qbestd::Metric metric = qbestd::parse_metric(type);
+        plhs[0] = mxCreateDoubleMatrix(mwSize(ref.cols), mwSize(qry.cols), mxREAL);
+        qbestd::distance_matrix(ref, qry, metric,
+                                qbestd::column_major(mxGetPr(plhs[0]), ref.cols, qry.cols));
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    if (!error.empty())
+        mexErrMsgIdAndTxt("qbestd:distance", "%s", error.c_str());
+}
@@ -0,0 +1,180 @@
+/*********************************************************************
+ * Glue shared by the MEX entry points in this directory. The DP
+ * recurrence itself lives in the header-only engine ../cpp/include, so
+ * every kernel is compiled as e.g.
+ *     mex -I../cpp/include NSDTW_c_skel.cpp
+ ********************************************************************/
+#pragma once
+
+#include <matrix.h>
+#include <mex.h>
+
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "qbestd/dtw.hpp"
+#include "qbestd/rolling.hpp"
+#include "qbestd/scratch.hpp"
+
+namespace qbestd_mex {
+
+inline double& createMatlabScalar(mxArray*& ptr)
+{
+    ptr = mxCreateDoubleMatrix(1, 1, mxREAL);
+    return *mxGetPr(ptr);
+}
+
+inline void check_input(int nrhs, const mxArray* prhs[])
+{
+    if (nrhs < 1 || !mxIsDouble(prhs[0]) || mxIsComplex(prhs[0])
+        || mxGetNumberOfDimensions(prhs[0]) != 2)
+        mexErrMsgIdAndTxt("qbestd:input", "Expected one real double distance matrix D.");
+    if (mxGetM(prhs[0]) == 0 || mxGetN(prhs[0]) == 0)
+        mexErrMsgIdAndTxt("qbestd:input", "Distance matrix D is empty.");
+}
+
+template <class P, class N>
+struct Kernel {
+    using Pattern = P;
+    using Norm = N;
+};
+
+// Calls f(Kernel<Pattern, Norm>{}) for the recurrence of the MEX kernel
+// called name, e.g. "GTTS_DTW_c_skel".
+template <class F>
+auto with_kernel(const std::string& name, F&& f)
+{
+    using namespace qbestd;
+    if (name == "NSDTW_c_skel")
+        return f(Kernel<NSDTW3, Accumulated>{});
+    if (name == "NSDTW_c_skel_2")
+        return f(Kernel<NSDTW2, Accumulated>{});
+    if (name == "NSDTW_c_skel_4")
+        return f(Kernel<NSDTW4, Accumulated>{});
+    if (name == "NSDTW_c_skel_5")
+        return f(Kernel<NSDTW5, Accumulated>{});
+    if (name == "NSDTW_c_skel_online")
+        return f(Kernel<NSDTW3, Normalized>{});
+    if (name == "newNSDTW_c_skel")
+        return f(Kernel<NewNSDTW, Accumulated>{});
+    if (name == "newNSDTW_c_skel_online")
+        return f(Kernel<NewNSDTW, Normalized>{});
+    if (name == "GTTS_DTW_c_skel")
+        return f(Kernel<GTTS, Accumulated>{});
+    if (name == "GTTS_DTW_c_skel_online" || name == "sub_DTW_c_skel_online")
+        return f(Kernel<GTTS, Normalized>{});
+    if (name == "DTW_c_skel_nobt")
+        return f(Kernel<OpenEndDTW, Accumulated>{});
+    if (name == "DTW_c_basic_skel_nobt")
+        return f(Kernel<BasicDTW, Accumulated>{});
+    throw std::invalid_argument("unknown kernel '" + name + "'");
+}
+
+inline std::string get_string(const mxArray* a)
+{
+    char* chars = mxArrayToString(a);
+    const std::string s = chars ? chars : "";
+    mxFree(chars);
+    return s;
+}
+
+// ND x Nframes feature matrix (one frame per column).
+inline qbestd::MatrixView<const double> features(const mxArray* a)
+{
+    return qbestd::column_major<const double>(mxGetPr(a), qbestd::index_t(mxGetM(a)),
+                                              qbestd::index_t(mxGetN(a)));
+}
+
+// M x N output slot k: a MATLAB matrix when the caller asked for it,
+// scratch memory (reused across calls) otherwise.
+inline double* output_matrix(int nlhs, mxArray* plhs[], int k, mwSize M, mwSize N,
+                             qbestd::Scratch<double>& scratch)
+{
+    if (k < nlhs) {
+        plhs[k] = mxCreateDoubleMatrix(M, N, mxREAL);
+        return mxGetPr(plhs[k]);
+    }
+    scratch = qbestd::Scratch<double>(M * N);
+    return scratch.data();
+}
+
+// [dist, ep, S, T, P] = kernel(D), with 1-based ep and P as in the
+// NSDTW/GTTS kernels. S, T and P are only materialized when requested;
+// [dist, ep] runs in O(M) memory.
+template <class Pattern, class Norm>
+void start_tracking(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
+{
+    check_input(nrhs, prhs);
+    const mwSize M = mxGetM(prhs[0]), N = mxGetN(prhs[0]);
+    std::string error;
+    if (nlhs <= 2) {
+        try {
+            const qbestd::Hit<double> hit =
+                qbestd::dtw_rolling<Pattern, Norm>(mxGetPr(prhs[0]), M, N, M);
+            createMatlabScalar(plhs[0]) = hit.dist;
+            if (nlhs > 1)
+                createMatlabScalar(plhs[1]) = double(hit.end + 1);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+    } else {
+        qbestd::Scratch<double> s_scratch, t_scratch, p_scratch;
+        double* S = output_matrix(nlhs, plhs, 2, M, N, s_scratch);
+        double* T = output_matrix(nlhs, plhs, 3, M, N, t_scratch);
+        double* P = output_matrix(nlhs, plhs, 4, M, N, p_scratch);
+        try {
+            const qbestd::Hit<double> hit =
+                qbestd::dtw<Pattern, Norm>(mxGetPr(prhs[0]), M, N, M, S, T, P);
+            createMatlabScalar(plhs[0]) = hit.dist;
+            if (nlhs > 1)
+                createMatlabScalar(plhs[1]) = double(hit.end + 1);
+            if (nlhs > 4)
+                for (mwSize i = 0; i < M * N; ++i)
+                    P[i] += 1;
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+    }
+    if (!error.empty())
+        mexErrMsgIdAndTxt("qbestd:dtw", "%s", error.c_str());
+}
+
+// [dist, ep, P, P1] = kernel(D) for the anchored DTW kernels, where P is
+// the accumulated cost and P1 the path length; ep is reported as
+// end row + ep_offset. As above, [dist, ep] needs O(M) memory only.
+template <class Pattern>
+void anchored(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[], int ep_offset)
+{
+    check_input(nrhs, prhs);
+    const mwSize M = mxGetM(prhs[0]), N = mxGetN(prhs[0]);
+    std::string error;
+    if (nlhs <= 2) {
+        try {
+            const qbestd::Hit<double> hit = qbestd::dtw_rolling<Pattern>(mxGetPr(prhs[0]), M, N, M);
+            createMatlabScalar(plhs[0]) = hit.dist;
+            if (nlhs > 1)
+                createMatlabScalar(plhs[1]) = double(hit.end + ep_offset);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+    } else {
+        qbestd::Scratch<double> s_scratch, t_scratch, start(M * N);
+        double* S = output_matrix(nlhs, plhs, 2, M, N, s_scratch);
+        double* T = output_matrix(nlhs, plhs, 3, M, N, t_scratch);
+        try {
+            const qbestd::Hit<double> hit =
+                qbestd::dtw<Pattern>(mxGetPr(prhs[0]), M, N, M, S, T, start.data());
+            createMatlabScalar(plhs[0]) = hit.dist;
+            if (nlhs > 1)
+                createMatlabScalar(plhs[1]) = double(hit.end + ep_offset);
+        } catch (const std::exception& e) {
+            error = e.what();
+        }
+    }
+    if (!error.empty())
+        mexErrMsgIdAndTxt("qbestd:dtw", "%s", error.c_str());
+}
+
+} // namespace qbestd_mex
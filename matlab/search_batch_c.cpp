@@ -0,0 +1,52 @@
+/*********************************************************************
+ * All queries of a cell array against one reference in one call: the
+ * queries run in SIMD lanes of a shared fused-distance recurrence, so
+ * each reference frame is loaded once per column for a whole group.
+ * Type_localdist and kernel are as in DTW_c_features.
+ ********************************************************************/
+// [dist, ep, sp] = search_batch_c(refcoef, {qrycoef, ...}, Type_localdist, kernel)
+// with one entry per query and 1-based ep and sp rows of the reference.
+#include "qbestd/batch.hpp"
+#include "qbestd_mex.hpp"
+
+void mexFunction(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+    if (nrhs < 3 || !mxIsDouble(prhs[0]) || mxIsComplex(prhs[0]) || !mxIsCell(prhs[1])
+        || !mxIsChar(prhs[2]) || (nrhs > 3 && !mxIsChar(prhs[3])))
+        mexErrMsgIdAndTxt("qbestd:input",
+                          "Expected refcoef, a cell array of qrycoef, Type_localdist and optionally a kernel name.");
+    const mwSize Q = mxGetNumberOfElements(prhs[1]);
+    std::vector<qbestd::MatrixView<const double>> queries;
+    for (mwSize q = 0; q < Q; ++q) {
+        const mxArray* c = mxGetCell(prhs[1], q);
+        if (!c || !mxIsDouble(c) || mxIsComplex(c))
+            mexErrMsgIdAndTxt("qbestd:input", "Every query must be a real double matrix.");
+        queries.push_back(qbestd_mex::features(c));
+    }
+    const std::string type = qbestd_mex::get_string(prhs[2]);
+    const std::string kernel = nrhs > 3 ? qbestd_mex::get_string(prhs[3]) : "NSDTW_c_skel";
+    std::string error;
+    try {
+        const std::vector<qbestd::Hit<double>> hits = qbestd_mex::with_kernel(kernel, [&](auto k) {
+            using K = decltype(k);
+            return qbestd::search_batch<typename K::Pattern, typename K::Norm>(
+                qbestd_mex::features(prhs[0]), queries, qbestd::parse_metric(type));
+        });
+        plhs[0] = mxCreateDoubleMatrix(1, Q, mxREAL);
+        if (nlhs > 1)
+            plhs[1] = mxCreateDoubleMatrix(1, Q, mxREAL);
+        if (nlhs > 2)
+            plhs[2] = mxCreateDoubleMatrix(1, Q, mxREAL);
+        for (mwSize q = 0; q < Q; ++q) {
+            mxGetPr(plhs[0])[q] = hits[q].dist;
+            if (nlhs > 1)
+                mxGetPr(plhs[1])[q] = double(hits[q].end + 1);
+            if (nlhs > 2)
+                mxGetPr(plhs[2])[q] = double(hits[q].start + 1);
+        }
+    } catch (const std::exception& e) {
+        error = e.what();
+    }
+    if (!error.empty())
+        mexErrMsgIdAndTxt("qbestd:dtw", "%s", error.c_str());
+}
@@ -0,0 +1,107 @@
+"""Build a feature archive for the C++ engine (cpp/include/qbestd/archive.hpp).
+
+Each input becomes one utterance of the archive:
+- `.wav` files are turned into 40 MFCCs per frame, normalized as in
+  `subsequence_dtw.py`;
+- `.npy` files are posteriorgram (or any feature) dumps of shape
+  (frames, dims); pass --dims-first for (dims, frames) dumps.
+
+The archive is written in one pass, so its size is not limited by memory:
+
+    python build_archive.py corpus.qfa data/*.wav
+    python build_archive.py --type float16 corpus.qfa @file_list.txt
+"""
+
+import argparse
+import struct
+from pathlib import Path
+
+import numpy as np
+
+MAGIC = b"QBESTDFA"
+VERSION = 1
+ALIGN = 64
+TYPES = {"float32": (0, "<f4"), "float16": (1, "<f2")}
+HEADER = struct.Struct("<8sIIQQQQQQ")  # ArchiveHeader, 64 bytes
+ENTRY = struct.Struct("<QQQQ")  # ArchiveEntry, 32 bytes
+
+
+def extract_mfcc(audio_file):
+    import librosa
+
+    audio, sample_rate = librosa.load(audio_file)
+    x = librosa.feature.mfcc(y=audio, sr=sample_rate, n_mfcc=40)
+
+    # Normalize the MFCCs: mean = 0, std = 1
+    x = (x - np.mean(x, axis=0)) / np.std(x, axis=0)
+    return x.T
+
+
+class ArchiveWriter:
+    """Streams utterances of shape (frames, dims) into an archive file."""
+
+    def __init__(self, path, dims, type_name="float32"):
+        self.file = open(path, "wb")
+        self.dims = dims
+        self.type, self.dtype = TYPES[type_name]
+        self.entries = []
+        self.names = bytearray()
+        self.frames = 0
+        # Blank header until close(): an unfinished file is not an archive
+        self.file.write(bytes(HEADER.size))
+
+    def add(self, name, frames):
+        frames = np.asarray(frames)
+        if frames.ndim != 2 or frames.shape[1] != self.dims:
+            raise ValueError(f"{name}: expected (frames, {self.dims}), got {frames.shape}")
+        encoded = name.encode("utf-8")
+        self.entries.append((self.file.tell(), frames.shape[0], len(self.names), len(encoded)))
+        self.names += encoded
+        self.frames += frames.shape[0]
+        # Row f of a C-ordered (frames, dims) array is frame f, so the bytes
+        # are the column-major dims x frames block the reader maps
+        self.file.write(np.ascontiguousarray(frames, dtype=self.dtype).tobytes())
+        self.file.write(bytes(-self.file.tell() % ALIGN))
+
+    def close(self):
+        index = self.file.tell()
+        for entry in self.entries:
+            self.file.write(ENTRY.pack(*entry))
+        names = self.file.tell()
+        self.file.write(self.names)
+        size = self.file.tell()
+        self.file.seek(0)
+        self.file.write(
+            HEADER.pack(MAGIC, VERSION, self.type, self.dims, len(self.entries), self.frames, index, names, size)
+        )
+        self.file.close()
+
+
+def load(path, dims_first):
+    path = Path(path)
+    if path.suffix.lower() == ".wav":
+        return extract_mfcc(path)
+    x = np.load(path)
+    return x.T if dims_first else x
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, fromfile_prefix_chars="@")
+    parser.add_argument("output", help="archive to write")
+    parser.add_argument("inputs", nargs="+", help=".wav or .npy files, one utterance each")
+    parser.add_argument("--type", choices=sorted(TYPES), default="float32", help="stored frame type")
+    parser.add_argument("--dims-first", action="store_true", help=".npy dumps are (dims, frames)")
+    args = parser.parse_args()
+
+    writer = None
+    for path in args.inputs:
+        x = load(path, args.dims_first)
+        if writer is None:
+            writer = ArchiveWriter(args.output, x.shape[1], args.type)
+        writer.add(Path(path).stem, x)
+    writer.close()
+    print(f"{args.output}: {len(writer.entries)} utterances, {writer.frames} frames of {writer.dims}")
+
+
+if __name__ == "__main__":
+    main()